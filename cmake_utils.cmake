@@ -47,6 +47,10 @@ endmacro()
 
 macro(detect_compiler_features)
 	set(has_coro_support ${only_msvc})
+	# GCC 10+ has C++20 coroutines with -std=c++20.
+	if (gcc AND NOT gcc_on_msvc AND (CMAKE_CXX_COMPILER_VERSION VERSION_GREATER_EQUAL 10))
+		set(has_coro_support ON)
+	endif ()
 
 	cmake_print_variables(has_coro_support clang only_msvc gcc)
 endmacro()
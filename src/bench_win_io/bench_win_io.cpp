@@ -0,0 +1,176 @@
+#include <benchmark/benchmark.h>
+#include <win_io/io_completion_port.h>
+#include <win_io/user_completion_port.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include <cstdint>
+#include <cstdlib>
+
+using wi::IoCompletionPort;
+using wi::UserCompletionPort;
+using wi::PortEntry;
+
+// Same benchmarks for kernel port (IOCP on Windows, io_uring on Linux)
+// and for user-space one, to compare.
+
+namespace
+{
+    // `threads_count` - concurrency limit, 0 for as many as CPUs.
+    template<typename Port>
+    Port MakePort(std::uint32_t threads_count = 0)
+    {
+        std::error_code ec;
+        std::optional<Port> port = Port::make(threads_count, ec);
+        if (!port)
+        {
+            std::abort();
+        }
+        return std::move(*port);
+    }
+
+    // UserCompletionPort is bounded: post() fails with `no_buffer_space`
+    // when full (even for a moment, while a consumer is preempted).
+    template<typename Port>
+    void Post(Port& port, const PortEntry& entry)
+    {
+        std::error_code ec;
+        do
+        {
+            port.post(entry, ec);
+        }
+        while (ec);
+    }
+
+    template<typename Port>
+    void Receive(Port& port, std::span<PortEntry> entries, std::size_t count)
+    {
+        std::error_code ec;
+        std::size_t received = 0;
+        while (received < count)
+        {
+            received += port.get_many(entries.first((std::min)(entries.size(), count - received)), ec).size();
+        }
+    }
+} // namespace
+
+// Post single entry and get it back on the same thread.
+template<typename Port>
+static void BM_Post_Get_Round_Trip(benchmark::State& state)
+{
+    Port port = MakePort<Port>();
+    std::error_code ec;
+    for (auto _ : state)
+    {
+        Post(port, PortEntry(1, 1, nullptr));
+        benchmark::DoNotOptimize(port.get(ec));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_Post_Get_Round_Trip, IoCompletionPort);
+BENCHMARK_TEMPLATE(BM_Post_Get_Round_Trip, UserCompletionPort);
+
+// post_many() of `batch` entries, get_many() them back.
+template<typename Port>
+static void BM_Get_Many_Throughput(benchmark::State& state)
+{
+    const std::size_t batch = std::size_t(state.range(0));
+    Port port = MakePort<Port>();
+    std::vector<PortEntry> to_send(batch, PortEntry(1, 1, nullptr));
+    std::vector<PortEntry> entries(batch);
+    std::error_code ec;
+    for (auto _ : state)
+    {
+        port.post_many(to_send, ec);
+        Receive(port, entries, batch);
+    }
+    state.SetItemsProcessed(state.iterations() * std::int64_t(batch));
+}
+BENCHMARK_TEMPLATE(BM_Get_Many_Throughput, IoCompletionPort)->RangeMultiplier(4)->Range(1, 1024);
+BENCHMARK_TEMPLATE(BM_Get_Many_Throughput, UserCompletionPort)->RangeMultiplier(4)->Range(1, 1024);
+
+// Every thread is both producer and consumer of the same port:
+// posts an entry, then gets some (not necessary own) entry.
+template<typename Port>
+static void BM_MPMC_Post_Get(benchmark::State& state)
+{
+    static std::optional<Port> port;
+    if (state.thread_index() == 0)
+    {
+        // Without the limit: threads leave the loop (not the port)
+        // at different times and would block the others.
+        port.emplace(MakePort<Port>(std::uint32_t(state.threads())));
+    }
+    std::error_code ec;
+    for (auto _ : state)
+    {
+        Post(*port, PortEntry(1, 1, nullptr));
+        benchmark::DoNotOptimize(port->get(ec));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_MPMC_Post_Get, IoCompletionPort)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_MPMC_Post_Get, UserCompletionPort)->ThreadRange(1, 64)->UseRealTime();
+
+// Time from post() until blocked waiter returns from get().
+template<typename Port>
+static void BM_Wake_Up_Latency(benchmark::State& state)
+{
+    using Clock = std::chrono::steady_clock;
+    constexpr wi::WinULONG_PTR k_stop_key = 1;
+
+    Port port = MakePort<Port>();
+    std::atomic<bool> waiting(false);
+    std::atomic<std::int64_t> latency_ns(-1);
+    std::thread waiter([&]()
+    {
+        std::error_code ec;
+        while (true)
+        {
+            waiting = true;
+            std::optional<PortEntry> entry = port.get(ec);
+            const auto now = Clock::now().time_since_epoch();
+            if (!entry || (entry->completion_key == k_stop_key))
+            {
+                break;
+            }
+            // Post time is passed instead of OVERLAPPED pointer.
+            const std::int64_t posted_ns = std::int64_t(reinterpret_cast<std::intptr_t>(entry->overlapped));
+            latency_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count() - posted_ns;
+        }
+    });
+
+    for (auto _ : state)
+    {
+        while (!waiting.exchange(false))
+        {
+            std::this_thread::yield();
+        }
+        // Give the waiter time to park.
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+
+        const auto now = Clock::now().time_since_epoch();
+        const std::intptr_t posted_ns = std::intptr_t(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+        Post(port, PortEntry(0, 0, reinterpret_cast<void*>(posted_ns)));
+        std::int64_t latency = -1;
+        while ((latency = latency_ns.exchange(-1)) < 0)
+        {
+            std::this_thread::yield();
+        }
+        state.SetIterationTime(double(latency) / 1e9);
+    }
+
+    Post(port, PortEntry(0, k_stop_key, nullptr));
+    waiter.join();
+}
+BENCHMARK_TEMPLATE(BM_Wake_Up_Latency, IoCompletionPort)->UseManualTime()->Iterations(1000);
+BENCHMARK_TEMPLATE(BM_Wake_Up_Latency, UserCompletionPort)->UseManualTime()->Iterations(1000);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,281 @@
+#include <benchmark/benchmark.h>
+#include <win_io_coro/detail/intrusive_queue.h>
+#include <win_io_coro/detail/ring_queue.h>
+#include <win_io_coro/detail/work_stealing_deque.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+using namespace wi::coro::detail;
+
+// Push/pop throughput and latency of the queues from win_io_coro/detail
+// for different producers:consumers ratios. Every benchmark thread
+// is either producer or consumer; per iteration, producer pushes
+// `consumers` elements and consumer pops `producers` elements,
+// so both sides do the same total work.
+//
+// Elements are taken from per-producer pool of `in_flight` size
+// and reused once popped (consumer releases them), which bounds
+// number of elements in the queue.
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Every N-th element carries push time.
+    constexpr std::uint64_t k_latency_sample_rate = 16;
+
+    template<bool Padded>
+    struct alignas(Padded ? 64 : alignof(void*)) Element
+        : IntrusiveQueue<Element<Padded>>::Item
+    {
+        std::atomic<bool> in_use{false};
+        Clock::time_point pushed_at{};
+    };
+
+    void Pause(std::uint32_t& spins)
+    {
+        if (++spins > 64)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    // Same interface for all queues: push(), pop(), roles limits.
+
+    template<typename T>
+    struct IntrusiveQueueAdapter
+    {
+        static constexpr const char* kName = "IntrusiveQueue";
+        static constexpr bool kSingleProducer = false;
+        static constexpr bool kSingleConsumer = false;
+
+        explicit IntrusiveQueueAdapter(std::size_t /*capacity*/) {}
+        bool push(T* value) { queue.push(value); return true; }
+        bool pop(T*& value) { return queue.pop(value); }
+
+        IntrusiveQueue<T> queue;
+    };
+
+    template<typename T>
+    struct IntrusiveMPSCQueueAdapter
+    {
+        static constexpr const char* kName = "IntrusiveMPSCQueue";
+        static constexpr bool kSingleProducer = false;
+        static constexpr bool kSingleConsumer = true;
+
+        explicit IntrusiveMPSCQueueAdapter(std::size_t /*capacity*/) {}
+        bool push(T* value) { queue.push(value); return true; }
+        bool pop(T*& value) { return queue.pop(value); }
+
+        IntrusiveMPSCQueue<T> queue;
+    };
+
+    template<typename T>
+    struct RingQueueAdapter
+    {
+        static constexpr const char* kName = "RingQueue";
+        static constexpr bool kSingleProducer = false;
+        static constexpr bool kSingleConsumer = false;
+
+        explicit RingQueueAdapter(std::size_t capacity) : queue(capacity) {}
+        bool push(T* value) { return queue.try_push(value); }
+        bool pop(T*& value) { return queue.try_pop(value); }
+
+        RingQueue<T> queue;
+    };
+
+    // Owner pushes, thieves steal.
+    template<typename T>
+    struct WorkStealingDequeAdapter
+    {
+        static constexpr const char* kName = "WorkStealingDeque";
+        static constexpr bool kSingleProducer = true;
+        static constexpr bool kSingleConsumer = false;
+
+        explicit WorkStealingDequeAdapter(std::size_t capacity) : queue(capacity) {}
+        bool push(T* value) { queue.push(value); return true; }
+        bool pop(T*& value) { return queue.steal(value); }
+
+        WorkStealingDeque<T> queue;
+    };
+
+    template<typename Queue, typename T>
+    struct Context
+    {
+        Context(std::size_t producers, std::size_t in_flight)
+            : queue(producers * in_flight)
+            , pools(producers)
+        {
+            for (auto& pool : pools)
+            {
+                pool = std::make_unique<T[]>(in_flight);
+            }
+        }
+
+        Queue queue;
+        std::vector<std::unique_ptr<T[]>> pools;
+    };
+
+    double Percentile(const std::vector<std::int64_t>& sorted, double p)
+    {
+        if (sorted.empty())
+        {
+            return 0;
+        }
+        const std::size_t index = std::size_t(p * double(sorted.size() - 1));
+        return double(sorted[index]);
+    }
+} // namespace
+
+template<template<typename> class QueueAdapter, bool Padded>
+static void BM_Queue(benchmark::State& state)
+{
+    using T = Element<Padded>;
+    using Queue = QueueAdapter<T>;
+    using QueueContext = Context<Queue, T>;
+
+    const std::size_t producers = std::size_t(state.range(0));
+    const std::size_t consumers = std::size_t(state.range(1));
+    const std::size_t in_flight = std::size_t(state.range(2));
+    const std::size_t thread = std::size_t(state.thread_index());
+    const bool is_producer = (thread < producers);
+
+    static std::unique_ptr<QueueContext> context;
+    if (thread == 0)
+    {
+        context = std::make_unique<QueueContext>(producers, in_flight);
+    }
+
+    std::vector<std::int64_t> latencies_ns;
+    std::uint64_t ops = 0;
+    std::uint64_t pushed = 0;
+    for (auto _ : state)
+    {
+        if (is_producer)
+        {
+            T* pool = context->pools[thread].get();
+            for (std::size_t i = 0; i < consumers; ++i, ++pushed)
+            {
+                T& element = pool[pushed % in_flight];
+                std::uint32_t spins = 0;
+                while (element.in_use.load(std::memory_order_acquire))
+                {
+                    Pause(spins);
+                }
+                element.in_use.store(true, std::memory_order_relaxed);
+                element.pushed_at = ((pushed % k_latency_sample_rate) == 0)
+                    ? Clock::now() : Clock::time_point();
+                spins = 0;
+                while (!context->queue.push(&element))
+                {
+                    Pause(spins);
+                }
+            }
+            ops += consumers;
+        }
+        else
+        {
+            for (std::size_t i = 0; i < producers; ++i)
+            {
+                T* element = nullptr;
+                std::uint32_t spins = 0;
+                while (!context->queue.pop(element))
+                {
+                    Pause(spins);
+                }
+                if (element->pushed_at != Clock::time_point())
+                {
+                    latencies_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        Clock::now() - element->pushed_at).count());
+                }
+                element->in_use.store(false, std::memory_order_release);
+            }
+            ops += producers;
+        }
+    }
+
+    using benchmark::Counter;
+    state.SetItemsProcessed(std::int64_t(ops));
+    state.counters["ops_per_thread"] = Counter(double(ops), Counter::kAvgThreadsRate);
+    state.counters["ns_per_op"] = Counter(double(ops), Counter::kAvgThreadsRate | Counter::kInvert);
+
+    // Push-to-pop time of sampled elements. Counters are averaged over
+    // all threads, so consumers scale their values to get the average
+    // of per-consumer percentiles.
+    if (!is_producer)
+    {
+        std::sort(latencies_ns.begin(), latencies_ns.end());
+        const double scale = double(producers + consumers) / double(consumers);
+        state.counters["p50_ns"] = Counter(Percentile(latencies_ns, 0.50) * scale, Counter::kAvgThreads);
+        state.counters["p99_ns"] = Counter(Percentile(latencies_ns, 0.99) * scale, Counter::kAvgThreads);
+        state.counters["p999_ns"] = Counter(Percentile(latencies_ns, 0.999) * scale, Counter::kAvgThreads);
+    }
+}
+
+namespace
+{
+    struct Ratio
+    {
+        std::int64_t producers;
+        std::int64_t consumers;
+    };
+
+    template<template<typename> class QueueAdapter, bool Padded>
+    void RegisterQueue()
+    {
+        using Queue = QueueAdapter<Element<Padded>>;
+        const std::int64_t n = (std::max)(2u, std::thread::hardware_concurrency() / 2);
+        const Ratio ratios[] = {{1, 1}, {n, 1}, {1, n}, {n, n}};
+        const std::int64_t in_flight_counts[] = {64, 4096};
+
+        for (const Ratio& ratio : ratios)
+        {
+            if ((Queue::kSingleProducer && (ratio.producers > 1))
+                || (Queue::kSingleConsumer && (ratio.consumers > 1)))
+            {
+                continue;
+            }
+            const std::string name = std::string("BM_Queue<") + Queue::kName
+                + (Padded ? ", Padded>" : ">");
+            benchmark::RegisterBenchmark(name.c_str(), &BM_Queue<QueueAdapter, Padded>)
+                ->ArgNames({"producers", "consumers", "in_flight"})
+                ->ArgsProduct({{ratio.producers}, {ratio.consumers}
+                    , {std::begin(in_flight_counts), std::end(in_flight_counts)}})
+                ->Threads(int(ratio.producers + ratio.consumers))
+                ->UseRealTime();
+        }
+    }
+
+    template<template<typename> class QueueAdapter>
+    void RegisterQueue()
+    {
+        RegisterQueue<QueueAdapter, false>();
+        RegisterQueue<QueueAdapter, true>();
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    RegisterQueue<IntrusiveQueueAdapter>();
+    RegisterQueue<IntrusiveMPSCQueueAdapter>();
+    RegisterQueue<RingQueueAdapter>();
+    RegisterQueue<WorkStealingDequeAdapter>();
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
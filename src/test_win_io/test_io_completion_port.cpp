@@ -1,9 +1,16 @@
 #include <gtest/gtest.h>
 #include <win_io/io_completion_port.h>
 
-#include "file_utils.h"
+#if defined(_WIN32)
+#  include "file_utils.h"
+#else
+#  include <fcntl.h>
+#endif
 
 #include <optional>
+#include <thread>
+#include <vector>
+#include <atomic>
 
 #include <cstdio>
 
@@ -12,6 +19,7 @@ using wi::PortEntry;
 
 using namespace std::chrono_literals;
 
+#if defined(_WIN32)
 namespace
 {
     class IoCompletionPortFileTest : public ::testing::Test
@@ -48,6 +56,7 @@ namespace
         HANDLE file_;
     };
 } // namespace
+#endif
 
 TEST(IoCompletionPort, Creation_Does_Not_Fail)
 {
@@ -90,6 +99,63 @@ TEST(IoCompletionPort, Blocking_Get_Success_After_Post_Many)
     ASSERT_TRUE(std::equal(std::begin(to_send), std::end(to_send), std::begin(ready)));
 }
 
+TEST(IoCompletionPort, Post_Many_Delivers_All_Entries_In_Order)
+{
+    // More entries than io_uring submission queue can take at once.
+    constexpr std::size_t k_entries_count = 1000;
+    std::error_code ec;
+    auto port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    std::vector<PortEntry> to_send;
+    for (std::size_t i = 0; i < k_entries_count; ++i)
+    {
+        to_send.emplace_back(wi::WinDWORD(i), i + 1);
+    }
+    ASSERT_EQ(k_entries_count, port->post_many(to_send, ec));
+    ASSERT_FALSE(ec);
+
+    std::vector<PortEntry> received;
+    PortEntry entries[64];
+    while (received.size() < k_entries_count)
+    {
+        const auto ready = port->get_many(entries, ec);
+        ASSERT_FALSE(ec);
+        received.insert(received.end(), ready.begin(), ready.end());
+    }
+    ASSERT_EQ(to_send, received);
+    ASSERT_FALSE(port->query(ec).has_value());
+}
+
+TEST(IoCompletionPort, Post_Many_Wakes_Up_Blocked_Waiters)
+{
+    constexpr std::size_t k_threads_count = 4;
+    std::error_code ec;
+    auto port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+
+    std::atomic_size_t keys_sum(0);
+    std::vector<std::thread> waiters;
+    for (std::size_t i = 0; i < k_threads_count; ++i)
+    {
+        waiters.emplace_back([&]()
+        {
+            std::error_code wait_ec;
+            const auto entry = port->get(wait_ec);
+            keys_sum += entry ? entry->completion_key : 0;
+        });
+    }
+    std::this_thread::sleep_for(20ms);
+
+    const PortEntry to_send[k_threads_count] = {PortEntry(0, 1), PortEntry(0, 2), PortEntry(0, 3), PortEntry(0, 4)};
+    ASSERT_EQ(k_threads_count, port->post_many(to_send, ec));
+    ASSERT_FALSE(ec);
+    for (auto& waiter : waiters)
+    {
+        waiter.join();
+    }
+    ASSERT_EQ(std::size_t(1 + 2 + 3 + 4), keys_sum);
+}
+
 TEST(IoCompletionPort, Has_No_Data_Until_Post)
 {
     std::error_code ec;
@@ -126,6 +192,117 @@ TEST(IoCompletionPort, Wait_Fails_Until_Post)
     ASSERT_EQ(send_data, *receive_data);
 }
 
+TEST(IoCompletionPort, Get_Many_From_Multiple_Threads_Receives_All_Posted_Entries)
+{
+    constexpr std::size_t k_threads_count = 4;
+    constexpr std::size_t k_entries_count = 1000;
+    std::error_code ec;
+    auto port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+
+    std::atomic_size_t received(0);
+    std::atomic_size_t keys_sum(0);
+    std::vector<std::thread> consumers;
+    for (std::size_t i = 0; i < k_threads_count; ++i)
+    {
+        consumers.emplace_back([&]()
+        {
+            while (received < k_entries_count)
+            {
+                std::error_code wait_ec;
+                PortEntry entries[16];
+                for (const PortEntry& entry : port->wait_for_many(entries, 10ms, wait_ec))
+                {
+                    keys_sum += entry.completion_key;
+                    ++received;
+                }
+            }
+        });
+    }
+
+    for (std::size_t i = 0; i < k_entries_count; ++i)
+    {
+        port->post(PortEntry(0, i + 1), ec);
+        ASSERT_FALSE(ec);
+    }
+    for (auto& consumer : consumers)
+    {
+        consumer.join();
+    }
+
+    ASSERT_EQ(k_entries_count, received);
+    ASSERT_EQ((k_entries_count * (k_entries_count + 1)) / 2, keys_sum);
+    ASSERT_FALSE(port->query(ec).has_value());
+}
+
+TEST(IoCompletionPort, Post_To_Saturated_Port_Delivers_All_And_Wakes_Up_Waiter)
+{
+    // Way more than the port can keep (CQ size on Linux) without waits.
+    constexpr std::size_t k_entries_count = 50'000;
+    std::error_code ec;
+    auto port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    std::size_t errors = 0;
+    for (std::size_t i = 0; i < k_entries_count; ++i)
+    {
+        port->post(PortEntry(0, i + 1), ec);
+        // Entry is queued even if its wake-up could not be submitted.
+        errors += !!ec;
+    }
+    ASSERT_EQ(std::size_t(0), errors);
+
+    std::size_t received = 0;
+    PortEntry entries[64];
+    while (true)
+    {
+        const auto ready = port->query_many(entries, ec);
+        if (ready.empty())
+        {
+            break;
+        }
+        for (const PortEntry& entry : ready)
+        {
+            ASSERT_EQ(received + 1, entry.completion_key);
+            ++received;
+        }
+    }
+    ASSERT_EQ(k_entries_count, received);
+
+    // Port is usable after all: blocked waiter is woken up by the next post.
+    std::optional<PortEntry> data;
+    std::thread waiter([&]()
+    {
+        std::error_code wait_ec;
+        data = port->get(wait_ec);
+    });
+    std::this_thread::sleep_for(20ms);
+    port->post(PortEntry(7), ec);
+    ASSERT_FALSE(ec);
+    waiter.join();
+    ASSERT_EQ(PortEntry(7), data);
+}
+
+#if !defined(_WIN32)
+TEST(IoCompletionPort, Native_Handle_Is_Uring_Descriptor)
+{
+    std::error_code ec;
+    auto port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    const int fd = int(reinterpret_cast<std::intptr_t>(port->native_handle()));
+    ASSERT_LE(0, ::fcntl(fd, F_GETFD));
+}
+
+TEST(IoCompletionPort, Association_Is_Not_Supported)
+{
+    std::error_code ec;
+    auto port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    port->associate_device(nullptr, 1, ec);
+    ASSERT_EQ(std::errc::operation_not_supported, ec);
+}
+#endif
+
+#if defined(_WIN32)
 TEST(IoCompletionPort, Associating_Invalid_Handle_Returns_Error)
 {
     std::error_code ec;
@@ -170,3 +347,4 @@ TEST_F(IoCompletionPortFileTest, Async_File_Write)
     ASSERT_EQ(1u, written->completion_key);
     ASSERT_EQ(&ov_, written->overlapped);
 }
+#endif
@@ -0,0 +1,241 @@
+#include <gtest/gtest.h>
+#include <win_io/io_context.h>
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+using wi::IoCompletionPort;
+using wi::IoContext;
+using wi::PortEntry;
+
+using namespace std::chrono_literals;
+
+namespace
+{
+    struct Counters
+    {
+        IoContext* context = nullptr;
+        std::size_t stop_after = 0;
+        std::atomic_size_t received{0};
+        std::atomic_size_t keys_sum{0};
+        std::mutex lock;
+        std::set<std::thread::id> threads;
+    };
+
+    void CountEntry(void* user_data, const PortEntry& entry, std::error_code ec)
+    {
+        ASSERT_FALSE(ec);
+        Counters& counters = *static_cast<Counters*>(user_data);
+        counters.keys_sum += entry.completion_key;
+        {
+            std::lock_guard _(counters.lock);
+            counters.threads.insert(std::this_thread::get_id());
+        }
+        if (++counters.received == counters.stop_after)
+        {
+            counters.context->stop();
+        }
+    }
+} // namespace
+
+TEST(IoContext, Run_Dispatches_All_Entries_Until_Stop)
+{
+    constexpr std::size_t k_entries_count = 1000;
+    std::error_code ec;
+    auto port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    Counters counters;
+    IoContext context(*port, &CountEntry, &counters, 4);
+    ASSERT_EQ(4u, context.threads_count());
+    counters.context = &context;
+    counters.stop_after = k_entries_count;
+
+    for (std::size_t i = 0; i < k_entries_count; ++i)
+    {
+        port->post(PortEntry(0, i + 1), ec);
+        ASSERT_FALSE(ec);
+    }
+    ASSERT_EQ(k_entries_count, context.run(ec));
+    ASSERT_FALSE(ec);
+    ASSERT_TRUE(context.stopped());
+    ASSERT_EQ(k_entries_count, counters.received);
+    ASSERT_EQ((k_entries_count * (k_entries_count + 1)) / 2, counters.keys_sum);
+}
+
+TEST(IoContext, Stop_From_Other_Thread_Wakes_Up_All_Threads)
+{
+    std::error_code ec;
+    auto port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    Counters counters;
+    IoContext context(*port, &CountEntry, &counters, 8);
+    std::thread stopper([&]()
+    {
+        std::this_thread::sleep_for(20ms);
+        context.stop();
+    });
+    ASSERT_EQ(std::size_t(0), context.run(ec));
+    ASSERT_FALSE(ec);
+    stopper.join();
+    ASSERT_EQ(std::size_t(0), counters.received);
+}
+
+TEST(IoContext, Run_For_Returns_After_Time_Out)
+{
+    std::error_code ec;
+    auto port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    Counters counters;
+    IoContext context(*port, &CountEntry, &counters, 2, true/*pin threads*/);
+    port->post(PortEntry(0, 5), ec);
+    ASSERT_FALSE(ec);
+
+    const auto start = std::chrono::steady_clock::now();
+    ASSERT_EQ(std::size_t(1), context.run_for(20ms, ec));
+    ASSERT_FALSE(ec);
+    ASSERT_GE(std::chrono::steady_clock::now() - start, 20ms);
+    ASSERT_TRUE(context.stopped());
+    ASSERT_EQ(std::size_t(5), counters.keys_sum);
+}
+
+TEST(IoContext, Run_Returns_Immediately_When_Stopped_Until_Restart)
+{
+    std::error_code ec;
+    auto port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    Counters counters;
+    IoContext context(*port, &CountEntry, &counters, 2);
+    context.stop();
+    ASSERT_EQ(std::size_t(0), context.run(ec));
+    ASSERT_FALSE(ec);
+
+    context.restart();
+    ASSERT_FALSE(context.stopped());
+    counters.context = &context;
+    counters.stop_after = 1;
+    port->post(PortEntry(0, 1), ec);
+    ASSERT_FALSE(ec);
+    // Stale sentinels from first stop() are ignored.
+    ASSERT_EQ(std::size_t(1), context.run(ec));
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(std::size_t(1), counters.received);
+}
+
+TEST(IoContext, Timer_Entry_Is_Dispatched_Once_Time_Passes)
+{
+    std::error_code ec;
+    auto port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    Counters counters;
+    IoContext context(*port, &CountEntry, &counters, 2);
+    counters.context = &context;
+    counters.stop_after = 1;
+
+    wi::WheelTimer timer(PortEntry(0, 77));
+    const auto start = std::chrono::steady_clock::now();
+    context.schedule_timer(timer, 20ms);
+    ASSERT_EQ(std::size_t(1), context.run(ec));
+    ASSERT_FALSE(ec);
+    ASSERT_GE(std::chrono::steady_clock::now() - start, 20ms);
+    ASSERT_EQ(std::size_t(77), counters.keys_sum);
+    ASSERT_FALSE(timer.is_scheduled());
+}
+
+TEST(IoContext, Cancelled_Timer_Is_Not_Dispatched)
+{
+    std::error_code ec;
+    auto port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    Counters counters;
+    IoContext context(*port, &CountEntry, &counters, 1);
+    wi::WheelTimer timer(PortEntry(0, 1));
+    context.schedule_timer(timer, 10ms);
+    context.cancel_timer(timer);
+    ASSERT_EQ(std::size_t(0), context.run_for(30ms, ec));
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(std::size_t(0), counters.received);
+}
+
+TEST(IoContext, Earlier_Timer_Wakes_Up_Waiting_Thread)
+{
+    std::error_code ec;
+    auto port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    Counters counters;
+    IoContext context(*port, &CountEntry, &counters, 1);
+    counters.context = &context;
+    counters.stop_after = 1;
+
+    wi::WheelTimer late_timer(PortEntry(0, 1));
+    wi::WheelTimer early_timer(PortEntry(0, 2));
+    context.schedule_timer(late_timer, 10s);
+    std::thread scheduler([&]()
+    {
+        std::this_thread::sleep_for(20ms);
+        context.schedule_timer(early_timer, 10ms);
+    });
+    const auto start = std::chrono::steady_clock::now();
+    ASSERT_EQ(std::size_t(1), context.run(ec));
+    ASSERT_FALSE(ec);
+    scheduler.join();
+    ASSERT_LT(std::chrono::steady_clock::now() - start, 5s);
+    ASSERT_EQ(std::size_t(2), counters.keys_sum);
+    context.cancel_timer(late_timer);
+}
+
+namespace
+{
+    struct LongHandler
+    {
+        IoContext* context = nullptr;
+        wi::WheelTimer timer{PortEntry(0, 2)};
+        std::chrono::steady_clock::time_point scheduled;
+        std::atomic<bool> fired{false};
+        std::chrono::steady_clock::duration delay{};
+    };
+
+    // Key 1: schedules `timer` and keeps the thread busy until it fires
+    // (or for a long time). Key 2: `timer`.
+    void DispatchWithLongHandler(void* user_data, const PortEntry& entry, std::error_code ec)
+    {
+        ASSERT_FALSE(ec);
+        LongHandler& handler = *static_cast<LongHandler*>(user_data);
+        if (entry.completion_key == 2)
+        {
+            handler.delay = std::chrono::steady_clock::now() - handler.scheduled;
+            handler.fired = true;
+            handler.context->stop();
+            return;
+        }
+        handler.scheduled = std::chrono::steady_clock::now();
+        handler.context->schedule_timer(handler.timer, 10ms);
+        const auto busy_until = handler.scheduled + 2s;
+        while (!handler.fired && (std::chrono::steady_clock::now() < busy_until))
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+} // namespace
+
+TEST(IoContext, Timer_Scheduled_From_Long_Handler_Wakes_Up_Blocked_Thread)
+{
+    std::error_code ec;
+    auto port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    LongHandler handler;
+    IoContext context(*port, &DispatchWithLongHandler, &handler, 2);
+    handler.context = &context;
+
+    // Dispatched by the thread that waits for timers; the other
+    // one is blocked on the port without time-out.
+    wi::WheelTimer long_timer(PortEntry(0, 1));
+    context.schedule_timer(long_timer, 20ms);
+    (void)context.run(ec);
+    ASSERT_FALSE(ec);
+    ASSERT_TRUE(handler.fired);
+    // Not when the handler gives up.
+    ASSERT_LT(handler.delay, 1s);
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <win_io/io_operation.h>
+#include <win_io/io_context.h>
+
+#include <atomic>
+#include <vector>
+
+using wi::IoCompletionPort;
+using wi::IoContext;
+using wi::IoOperation;
+using wi::PortEntry;
+
+using namespace std::chrono_literals;
+
+namespace
+{
+    struct Operation
+    {
+        IoOperation header{&Operation::on_complete, this};
+        std::size_t completed = 0;
+        wi::WinDWORD bytes = 0;
+        std::error_code error;
+        IoContext* context = nullptr;
+        std::atomic_size_t* total = nullptr;
+        std::size_t stop_after = 0;
+
+        static void on_complete(void* user_data, const PortEntry& entry, std::error_code ec)
+        {
+            Operation& self = *static_cast<Operation*>(user_data);
+            ASSERT_EQ(entry.overlapped, self.header.overlapped());
+            ++self.completed;
+            self.bytes = entry.bytes_transferred;
+            self.error = ec;
+            if (self.total && (++*self.total == self.stop_after))
+            {
+                self.context->stop();
+            }
+        }
+    };
+} // namespace
+
+TEST(IoOperation, Dispatch_Invokes_Callback_Of_Each_Entry)
+{
+    std::vector<Operation> operations(3);
+    std::vector<PortEntry> entries;
+    for (std::size_t i = 0; i < operations.size(); ++i)
+    {
+        // Any completion key: dispatch goes through OVERLAPPED only.
+        entries.emplace_back(wi::WinDWORD(i + 1), wi::WinULONG_PTR(100 - i), operations[i].header.overlapped());
+    }
+
+    ASSERT_EQ(operations.size(), wi::dispatch(entries));
+    for (std::size_t i = 0; i < operations.size(); ++i)
+    {
+        ASSERT_EQ(std::size_t(1), operations[i].completed);
+        ASSERT_EQ(wi::WinDWORD(i + 1), operations[i].bytes);
+        ASSERT_FALSE(operations[i].error);
+    }
+}
+
+TEST(IoOperation, Dispatch_Passes_Wait_Error_To_Callbacks)
+{
+    Operation operation;
+    const PortEntry entry(0, 0, operation.header.overlapped());
+    const auto error = std::make_error_code(std::errc::operation_canceled);
+    ASSERT_EQ(std::size_t(1), wi::dispatch({&entry, 1}, error));
+    ASSERT_EQ(std::size_t(1), operation.completed);
+    ASSERT_EQ(error, operation.error);
+}
+
+TEST(IoOperation, Posted_Operations_Are_Dispatched_From_Port)
+{
+    std::error_code ec;
+    auto port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    Operation first;
+    Operation second;
+    const PortEntry to_send[2] = {PortEntry(1, 1, first.header.overlapped())
+        , PortEntry(2, 2, second.header.overlapped())};
+    ASSERT_EQ(std::size_t(2), port->post_many(to_send, ec));
+    ASSERT_FALSE(ec);
+
+    std::size_t dispatched = 0;
+    while (dispatched < 2)
+    {
+        PortEntry entries[4];
+        dispatched += wi::dispatch(port->get_many(entries, ec), ec);
+        ASSERT_FALSE(ec);
+    }
+    ASSERT_EQ(std::size_t(1), first.completed);
+    ASSERT_EQ(wi::WinDWORD(1), first.bytes);
+    ASSERT_EQ(std::size_t(1), second.completed);
+    ASSERT_EQ(wi::WinDWORD(2), second.bytes);
+}
+
+TEST(IoOperation, Can_Be_Used_As_IoContext_Dispatch)
+{
+    constexpr std::size_t k_operations_count = 100;
+    std::error_code ec;
+    auto port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoContext context(*port, &wi::dispatch_operation, nullptr, 2);
+
+    std::atomic_size_t total(0);
+    std::vector<Operation> operations(k_operations_count);
+    for (Operation& operation : operations)
+    {
+        operation.context = &context;
+        operation.total = &total;
+        operation.stop_after = k_operations_count;
+        port->post(PortEntry(0, 0, operation.header.overlapped()), ec);
+        ASSERT_FALSE(ec);
+    }
+    context.run(ec);
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(k_operations_count, total);
+    for (const Operation& operation : operations)
+    {
+        ASSERT_EQ(std::size_t(1), operation.completed);
+    }
+}
@@ -2,11 +2,21 @@
 
 #include <win_io/io_completion_port.h>
 
+#include <cerrno>
+
+#if defined(_WIN32)
 TEST(LastError, GetLastWinError_Returns_Proper_Last_Error)
 {
     ::SetLastError(5);
     ASSERT_EQ(::GetLastError(), wi::detail::GetLastWinError());
 }
+#else
+TEST(LastError, GetLastWinError_Returns_Errno)
+{
+    errno = 5;
+    ASSERT_EQ(5u, wi::detail::GetLastWinError());
+}
+#endif
 
 TEST(LastError,
     Make_Last_Error_Code_Creates_Proper_Error_Code_Instance_With_System_Category)
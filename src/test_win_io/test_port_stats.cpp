@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+#include <win_io/io_completion_port.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+using wi::AdaptiveSpinWait;
+using wi::IoCompletionPort;
+using wi::PortEntry;
+using wi::PortStats;
+using wi::PortStatsSnapshot;
+
+using namespace std::chrono_literals;
+
+TEST(PortStats, Nothing_Is_Counted_Without_Stats)
+{
+    std::error_code ec;
+    auto port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(nullptr, port->stats());
+    auto stats = std::make_unique<PortStats>();
+    port->post(PortEntry(1), ec);
+    ASSERT_FALSE(ec);
+    ASSERT_TRUE(port->get(ec));
+
+    const PortStatsSnapshot snapshot = stats->snapshot();
+    ASSERT_EQ(0u, snapshot.posts);
+    ASSERT_EQ(0u, snapshot.dequeues);
+    ASSERT_TRUE(snapshot.keys.empty());
+}
+
+TEST(PortStats, Counts_Posts_Dequeues_And_Time_Outs)
+{
+    std::error_code ec;
+    auto port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    auto stats = std::make_unique<PortStats>();
+    port->set_stats(stats.get());
+
+    const PortEntry to_send[3] = {PortEntry(0, 1), PortEntry(0, 2), PortEntry(0, 2)};
+    ASSERT_EQ(std::size_t(3), port->post_many(to_send, ec));
+    ASSERT_FALSE(ec);
+    port->post(PortEntry(0, 1), ec);
+    ASSERT_FALSE(ec);
+
+    std::size_t received = 0;
+    while (received < 4)
+    {
+        PortEntry entries[8];
+        received += port->get_many(entries, ec).size();
+        ASSERT_FALSE(ec);
+    }
+    ASSERT_FALSE(port->wait_for(1ms, ec));
+    ASSERT_TRUE(ec);
+
+    const PortStatsSnapshot snapshot = stats->snapshot();
+    ASSERT_EQ(4u, snapshot.posts);
+    ASSERT_EQ(4u, snapshot.dequeues);
+    ASSERT_EQ(1u, snapshot.timeouts);
+    ASSERT_EQ(0u, snapshot.errors);
+    ASSERT_GE(snapshot.waits, 2u);
+    ASSERT_EQ(std::size_t(2), snapshot.keys.size());
+    ASSERT_EQ(wi::WinULONG_PTR(1), snapshot.keys[0].completion_key);
+    ASSERT_EQ(2u, snapshot.keys[0].dequeues);
+    ASSERT_EQ(wi::WinULONG_PTR(2), snapshot.keys[1].completion_key);
+    ASSERT_EQ(2u, snapshot.keys[1].dequeues);
+    ASSERT_EQ(0u, snapshot.other_keys_dequeues);
+    ASSERT_GE(snapshot.blocked_time, 1ms);
+}
+
+TEST(PortStats, Histogram_Buckets_Are_Powers_Of_Two)
+{
+    std::error_code ec;
+    auto port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    auto stats = std::make_unique<PortStats>();
+    port->set_stats(stats.get());
+
+    PortEntry entries[8];
+    ASSERT_TRUE(port->query_many(entries, ec).empty());
+    const std::vector<PortEntry> to_send(5, PortEntry(0, 7));
+    ASSERT_EQ(to_send.size(), port->post_many(to_send, ec));
+    ASSERT_FALSE(ec);
+    std::size_t received = 0;
+    while (received < to_send.size())
+    {
+        received += port->get_many(entries, ec).size();
+    }
+
+    const PortStatsSnapshot snapshot = stats->snapshot();
+    ASSERT_EQ(1u, snapshot.batch_sizes[0]);
+    std::uint64_t batches = 0;
+    std::uint64_t max_batch = 0;
+    for (std::size_t i = 1; i < PortStatsSnapshot::kBatchBucketsCount; ++i)
+    {
+        batches += snapshot.batch_sizes[i];
+        if (snapshot.batch_sizes[i] != 0)
+        {
+            max_batch = i;
+        }
+    }
+    ASSERT_EQ(snapshot.waits, batches + 1);
+    // 5 entries at most, [4, 8) bucket.
+    ASSERT_LE(max_batch, 3u);
+
+    stats->reset();
+    const PortStatsSnapshot empty = stats->snapshot();
+    ASSERT_EQ(0u, empty.waits);
+    ASSERT_EQ(0u, empty.batch_sizes[0]);
+    ASSERT_TRUE(empty.keys.empty());
+}
+
+TEST(PortStats, Keys_Over_Capacity_Are_Counted_Together)
+{
+    std::error_code ec;
+    auto port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    auto stats = std::make_unique<PortStats>();
+    port->set_stats(stats.get());
+
+    constexpr std::size_t k_keys_count = PortStats::kKeysCapacity + 10;
+    std::size_t received = 0;
+    for (std::size_t i = 0; i < k_keys_count; ++i)
+    {
+        port->post(PortEntry(0, i), ec);
+        ASSERT_FALSE(ec);
+        received += port->get(ec).has_value();
+    }
+    ASSERT_EQ(k_keys_count, received);
+
+    const PortStatsSnapshot snapshot = stats->snapshot();
+    ASSERT_EQ(PortStats::kKeysCapacity, snapshot.keys.size());
+    ASSERT_EQ(10u, snapshot.other_keys_dequeues);
+}
+
+TEST(PortStats, Multiple_Threads_Counters_Are_Summed)
+{
+    constexpr std::size_t k_threads_count = 4;
+    constexpr std::size_t k_entries_per_thread = 1000;
+    std::error_code ec;
+    auto port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    auto stats = std::make_unique<PortStats>();
+    port->set_stats(stats.get());
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < k_threads_count; ++i)
+    {
+        threads.emplace_back([&, i]()
+        {
+            for (std::size_t j = 0; j < k_entries_per_thread; ++j)
+            {
+                std::error_code thread_ec;
+                port->post(PortEntry(0, i), thread_ec);
+                (void)port->get(thread_ec);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    const PortStatsSnapshot snapshot = stats->snapshot();
+    ASSERT_EQ(k_threads_count * k_entries_per_thread, snapshot.posts);
+    ASSERT_EQ(k_threads_count * k_entries_per_thread, snapshot.dequeues);
+    ASSERT_EQ(k_threads_count, snapshot.keys.size());
+    std::uint64_t keys_dequeues = 0;
+    for (const auto& key : snapshot.keys)
+    {
+        keys_dequeues += key.dequeues;
+    }
+    ASSERT_EQ(snapshot.dequeues, keys_dequeues);
+}
+
+TEST(PortStats, Spin_Wait_Is_Counted_As_Single_Wait)
+{
+    std::error_code ec;
+    auto port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    auto stats = std::make_unique<PortStats>();
+    port->set_stats(stats.get());
+
+    // Spins for the whole time-out: thousands of polls.
+    AdaptiveSpinWait spin(std::chrono::milliseconds(5));
+    PortEntry entries[4];
+    ASSERT_TRUE(port->wait_for_many(entries, 5ms, spin, ec).empty());
+    ASSERT_TRUE(ec);
+    port->post(PortEntry(0, 1), ec);
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(std::size_t(1), port->get_many(entries, spin, ec).size());
+
+    const PortStatsSnapshot snapshot = stats->snapshot();
+    ASSERT_EQ(2u, snapshot.waits);
+    ASSERT_EQ(1u, snapshot.timeouts);
+    ASSERT_EQ(1u, snapshot.dequeues);
+    ASSERT_EQ(1u, snapshot.batch_sizes[0]);
+    ASSERT_EQ(1u, snapshot.batch_sizes[1]);
+}
@@ -1,3 +1,4 @@
+#if defined(_WIN32)
 #include <gtest/gtest.h>
 
 #include <win_io/read_directory_changes.h>
@@ -362,3 +363,4 @@ TEST_F(DirectoryChangesTest, Detects_Buffer_Overflow_With_No_Errors_Flag_Set)
     }
     ASSERT_TRUE(has_buffer_overflow);
 }
+#endif
@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include <win_io/sharded_io_context.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using wi::ShardedIoContext;
+using wi::PortEntry;
+
+using namespace std::chrono_literals;
+
+namespace
+{
+    struct ShardCounters
+    {
+        ShardedIoContext* context = nullptr;
+        std::size_t stop_after = 0;
+        std::chrono::milliseconds work_time{0};
+        std::atomic_size_t received{0};
+        std::atomic_size_t stolen{0};
+    };
+
+    // Entry's completion key is the index of the shard it was posted to.
+    void CountShardEntry(void* user_data, const PortEntry& entry, std::error_code ec)
+    {
+        ASSERT_FALSE(ec);
+        ShardCounters& counters = *static_cast<ShardCounters*>(user_data);
+        if (entry.completion_key != counters.context->current_shard())
+        {
+            ++counters.stolen;
+        }
+        std::this_thread::sleep_for(counters.work_time);
+        if (++counters.received == counters.stop_after)
+        {
+            counters.context->stop();
+        }
+    }
+} // namespace
+
+TEST(ShardedIoContext, Creates_Requested_Shards)
+{
+    std::error_code ec;
+    ShardCounters counters;
+    auto context = ShardedIoContext::make(3, &CountShardEntry, &counters, false, ec);
+    ASSERT_FALSE(ec);
+    ASSERT_TRUE(context);
+    ASSERT_EQ(3u, context->shards_count());
+    const std::uint32_t shard = context->current_shard();
+    ASSERT_GT(3u, shard);
+    // Same shard for the same thread.
+    ASSERT_EQ(shard, context->current_shard());
+    ASSERT_EQ(&context->port(shard), &context->current_port());
+}
+
+TEST(ShardedIoContext, Run_Dispatches_Entries_Of_All_Shards_Until_Stop)
+{
+    constexpr std::size_t k_entries_per_shard = 250;
+    std::error_code ec;
+    ShardCounters counters;
+    auto context = ShardedIoContext::make(4, &CountShardEntry, &counters, true/*pin threads*/, ec);
+    ASSERT_FALSE(ec);
+    counters.context = context.get();
+    counters.stop_after = k_entries_per_shard * context->shards_count();
+
+    for (std::uint32_t shard = 0; shard < context->shards_count(); ++shard)
+    {
+        for (std::size_t i = 0; i < k_entries_per_shard; ++i)
+        {
+            context->port(shard).post(PortEntry(0, shard), ec);
+            ASSERT_FALSE(ec);
+        }
+    }
+    ASSERT_EQ(counters.stop_after, context->run(ec));
+    ASSERT_FALSE(ec);
+    ASSERT_TRUE(context->stopped());
+}
+
+TEST(ShardedIoContext, Idle_Shard_Steals_From_Busy_Shard)
+{
+    // More than single batch: owner's full batch wakes up the thief.
+    constexpr std::size_t k_entries_count = 4 * ShardedIoContext::kBatchSize;
+    std::error_code ec;
+    ShardCounters counters;
+    auto context = ShardedIoContext::make(2, &CountShardEntry, &counters, false, ec);
+    ASSERT_FALSE(ec);
+    counters.context = context.get();
+    counters.stop_after = k_entries_count;
+    counters.work_time = 1ms;
+
+    for (std::size_t i = 0; i < k_entries_count; ++i)
+    {
+        context->port(1).post(PortEntry(0, 1), ec);
+        ASSERT_FALSE(ec);
+    }
+    ASSERT_EQ(k_entries_count, context->run(ec));
+    ASSERT_FALSE(ec);
+    ASSERT_LT(std::size_t(0), counters.stolen);
+}
+
+TEST(ShardedIoContext, Idle_Shard_Steals_Rest_Of_Slow_Batch)
+{
+    // Less than single batch: no backlog, but the owner
+    // takes all of it at once and dispatch is slow.
+    constexpr std::size_t k_entries_count = 8;
+    std::error_code ec;
+    ShardCounters counters;
+    auto context = ShardedIoContext::make(2, &CountShardEntry, &counters, false, ec);
+    ASSERT_FALSE(ec);
+    counters.context = context.get();
+    counters.stop_after = k_entries_count;
+    counters.work_time = 5ms;
+
+    std::thread poster([&]()
+    {
+        // Both threads are blocked by now: nothing to steal on start.
+        std::this_thread::sleep_for(20ms);
+        const std::vector<PortEntry> entries(k_entries_count, PortEntry(0, 0));
+        std::error_code post_ec;
+        (void)context->port(0).post_many(entries, post_ec);
+    });
+    ASSERT_EQ(k_entries_count, context->run(ec));
+    ASSERT_FALSE(ec);
+    poster.join();
+    ASSERT_LT(std::size_t(0), counters.stolen);
+}
+
+TEST(ShardedIoContext, Run_For_Returns_After_Time_Out)
+{
+    std::error_code ec;
+    ShardCounters counters;
+    auto context = ShardedIoContext::make(2, &CountShardEntry, &counters, false, ec);
+    ASSERT_FALSE(ec);
+    counters.context = context.get();
+    const auto start = std::chrono::steady_clock::now();
+    ASSERT_EQ(std::size_t(0), context->run_for(20ms, ec));
+    ASSERT_FALSE(ec);
+    ASSERT_GE(std::chrono::steady_clock::now() - start, 20ms);
+    ASSERT_TRUE(context->stopped());
+
+    context->restart();
+    ASSERT_FALSE(context->stopped());
+}
+
+TEST(ShardedIoContext, Idle_Shards_Block_Instead_Of_Polling)
+{
+    std::error_code ec;
+    ShardCounters counters;
+    auto context = ShardedIoContext::make(4, &CountShardEntry, &counters, false, ec);
+    ASSERT_FALSE(ec);
+    counters.context = context.get();
+    std::vector<std::unique_ptr<wi::PortStats>> stats;
+    for (std::uint32_t shard = 0; shard < context->shards_count(); ++shard)
+    {
+        stats.push_back(std::make_unique<wi::PortStats>());
+        context->port(shard).set_stats(stats.back().get());
+    }
+
+    ASSERT_EQ(std::size_t(0), context->run_for(100ms, ec));
+    ASSERT_FALSE(ec);
+    for (const auto& shard_stats : stats)
+    {
+        // Startup steal attempt and single blocking wait, not
+        // a wake-up every millisecond.
+        ASSERT_LT(shard_stats->snapshot().waits, 20u);
+    }
+}
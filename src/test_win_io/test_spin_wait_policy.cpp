@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <win_io/io_completion_port.h>
+#include <win_io/user_completion_port.h>
+#include <win_io/spin_wait_policy.h>
+
+#include <optional>
+#include <thread>
+
+using wi::AdaptiveSpinWait;
+using wi::IoCompletionPort;
+using wi::UserCompletionPort;
+using wi::PortEntry;
+
+using namespace std::chrono_literals;
+
+TEST(AdaptiveSpinWait, Starts_With_Max_Spin_Budget)
+{
+    AdaptiveSpinWait spin(100us);
+    ASSERT_EQ(std::chrono::nanoseconds(100us), spin.max_spin());
+    ASSERT_EQ(std::chrono::nanoseconds(100us), spin.spin_budget());
+}
+
+TEST(AdaptiveSpinWait, Get_Many_Returns_Already_Posted_Entries)
+{
+    std::error_code ec;
+    auto port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    AdaptiveSpinWait spin;
+    const PortEntry send_data(1, 1, nullptr);
+    port->post(send_data, ec);
+    ASSERT_FALSE(ec);
+
+    PortEntry entries[2];
+    const auto ready = port->get_many(entries, spin, ec);
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(std::size_t(1), ready.size());
+    ASSERT_EQ(send_data, ready[0]);
+}
+
+TEST(AdaptiveSpinWait, Wait_Fails_Until_Post)
+{
+    std::error_code ec;
+    auto port = UserCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    AdaptiveSpinWait spin;
+    PortEntry entries[2];
+    ASSERT_TRUE(port->wait_for_many(entries, 20ms, spin, ec).empty());
+    ASSERT_TRUE(ec);
+
+    port->post(PortEntry(7), ec);
+    ASSERT_FALSE(ec);
+    const auto ready = port->wait_for_many(entries, 20ms, spin, ec);
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(std::size_t(1), ready.size());
+    ASSERT_EQ(PortEntry(7), ready[0]);
+}
+
+TEST(AdaptiveSpinWait, Blocked_Waiter_Receives_Entry_Posted_Later)
+{
+    std::error_code ec;
+    auto port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+
+    std::optional<PortEntry> received;
+    std::thread waiter([&]()
+    {
+        AdaptiveSpinWait spin;
+        std::error_code wait_ec;
+        PortEntry entries[1];
+        const auto ready = port->get_many(entries, spin, wait_ec);
+        if (!ready.empty())
+        {
+            received = ready[0];
+        }
+    });
+    std::this_thread::sleep_for(20ms);
+    port->post(PortEntry(3), ec);
+    ASSERT_FALSE(ec);
+    waiter.join();
+    ASSERT_EQ(PortEntry(3), received);
+}
+
+TEST(AdaptiveSpinWait, Stops_Spinning_When_Port_Stays_Idle)
+{
+    std::error_code ec;
+    auto port = UserCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    AdaptiveSpinWait spin(50us);
+    PortEntry entries[1];
+    for (int i = 0; i < 16; ++i)
+    {
+        (void)port->wait_for_many(entries, 2ms, spin, ec);
+        ASSERT_TRUE(ec);
+    }
+    ASSERT_EQ(std::chrono::nanoseconds(0), spin.spin_budget());
+}
+
+TEST(AdaptiveSpinWait, Resumes_Spinning_When_Entries_Arrive_Often)
+{
+    std::error_code ec;
+    auto port = UserCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    AdaptiveSpinWait spin(50us);
+    PortEntry entries[1];
+    for (int i = 0; i < 16; ++i)
+    {
+        (void)port->wait_for_many(entries, 2ms, spin, ec);
+    }
+    ASSERT_EQ(std::chrono::nanoseconds(0), spin.spin_budget());
+
+    for (int i = 0; i < 64; ++i)
+    {
+        port->post(PortEntry(1), ec);
+        ASSERT_FALSE(ec);
+        ASSERT_EQ(std::size_t(1), port->get_many(entries, spin, ec).size());
+        ASSERT_FALSE(ec);
+    }
+    ASSERT_LT(std::chrono::nanoseconds(0), spin.spin_budget());
+    ASSERT_GE(spin.max_spin(), spin.spin_budget());
+}
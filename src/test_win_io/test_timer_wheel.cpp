@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <win_io/timer_wheel.h>
+
+#include <random>
+#include <vector>
+
+using wi::TimerWheel;
+using wi::WheelTimer;
+using wi::PortEntry;
+
+using namespace std::chrono_literals;
+
+namespace
+{
+    using Clock = TimerWheel::Clock;
+    const Clock::time_point k_start{};
+} // namespace
+
+TEST(TimerWheel, Fires_Timer_Once_Its_Time_Passes)
+{
+    TimerWheel wheel(1ms, k_start);
+    WheelTimer timer(PortEntry(0, 1));
+    wheel.schedule(timer, k_start + 10ms);
+    ASSERT_TRUE(timer.is_scheduled());
+    ASSERT_EQ(std::size_t(1), wheel.size());
+
+    std::vector<WheelTimer*> fired;
+    auto collect = [&](WheelTimer& t) { fired.push_back(&t); };
+    ASSERT_EQ(std::size_t(0), wheel.advance(k_start + 9ms, collect));
+    ASSERT_TRUE(fired.empty());
+    ASSERT_EQ(std::size_t(1), wheel.advance(k_start + 10ms, collect));
+    ASSERT_EQ(std::vector<WheelTimer*>{&timer}, fired);
+    ASSERT_FALSE(timer.is_scheduled());
+    ASSERT_TRUE(wheel.is_empty());
+}
+
+TEST(TimerWheel, Rounds_Up_To_Resolution)
+{
+    TimerWheel wheel(1ms, k_start);
+    WheelTimer timer;
+    wheel.schedule(timer, k_start + 1500us);
+    std::size_t fired = 0;
+    auto count = [&](WheelTimer&) { ++fired; };
+    (void)wheel.advance(k_start + 1ms, count);
+    ASSERT_EQ(std::size_t(0), fired);
+    (void)wheel.advance(k_start + 2ms, count);
+    ASSERT_EQ(std::size_t(1), fired);
+}
+
+TEST(TimerWheel, Cancelled_Timer_Does_Not_Fire)
+{
+    TimerWheel wheel(1ms, k_start);
+    WheelTimer timer;
+    wheel.schedule(timer, k_start + 5ms);
+    wheel.cancel(timer);
+    ASSERT_FALSE(timer.is_scheduled());
+    ASSERT_TRUE(wheel.is_empty());
+    // No-op.
+    wheel.cancel(timer);
+
+    std::size_t fired = 0;
+    (void)wheel.advance(k_start + 1s, [&](WheelTimer&) { ++fired; });
+    ASSERT_EQ(std::size_t(0), fired);
+}
+
+TEST(TimerWheel, Timer_In_The_Past_Fires_On_Next_Advance)
+{
+    TimerWheel wheel(1ms, k_start);
+    (void)wheel.advance(k_start + 100ms, [](WheelTimer&) {});
+    WheelTimer timer;
+    wheel.schedule(timer, k_start + 50ms);
+    std::size_t fired = 0;
+    (void)wheel.advance(k_start + 101ms, [&](WheelTimer&) { ++fired; });
+    ASSERT_EQ(std::size_t(1), fired);
+}
+
+TEST(TimerWheel, Timer_Can_Be_Rescheduled_From_Callback)
+{
+    TimerWheel wheel(1ms, k_start);
+    WheelTimer timer;
+    wheel.schedule(timer, k_start + 1ms);
+    std::size_t fired = 0;
+    auto periodic = [&](WheelTimer& t)
+    {
+        if (++fired < 3)
+        {
+            wheel.schedule(t, k_start + std::chrono::milliseconds(fired + 1));
+        }
+    };
+    for (int ms = 1; ms <= 10; ++ms)
+    {
+        (void)wheel.advance(k_start + std::chrono::milliseconds(ms), periodic);
+    }
+    ASSERT_EQ(std::size_t(3), fired);
+    ASSERT_TRUE(wheel.is_empty());
+}
+
+TEST(TimerWheel, Next_Expiry_Is_Not_Later_Than_Earliest_Timer)
+{
+    TimerWheel wheel(1ms, k_start);
+    ASSERT_FALSE(wheel.next_expiry().has_value());
+    WheelTimer near_timer;
+    WheelTimer far_timer;
+    wheel.schedule(far_timer, k_start + 100s);
+    const auto far_expiry = wheel.next_expiry();
+    ASSERT_TRUE(far_expiry.has_value());
+    ASSERT_GE(k_start + 100s, *far_expiry);
+
+    wheel.schedule(near_timer, k_start + 7ms);
+    ASSERT_EQ(k_start + 7ms, wheel.next_expiry());
+    wheel.cancel(near_timer);
+    wheel.cancel(far_timer);
+}
+
+TEST(TimerWheel, Fires_All_Timers_Exactly_At_Their_Tick_Across_Levels)
+{
+    constexpr std::size_t k_timers_count = 2000;
+    TimerWheel wheel(1ms, k_start);
+    std::vector<WheelTimer> timers(k_timers_count);
+    std::mt19937 random(42);
+    // Cover all levels: up to 2^25 ticks.
+    std::uniform_int_distribution<std::int64_t> delays(1, std::int64_t(1) << 25);
+    for (std::size_t i = 0; i < k_timers_count; ++i)
+    {
+        const std::int64_t delay = (i < 300) ? std::int64_t(i + 1) : delays(random);
+        timers[i].entry = PortEntry(0, wi::WinULONG_PTR(delay));
+        wheel.schedule(timers[i], k_start + std::chrono::milliseconds(delay));
+    }
+
+    std::size_t fired = 0;
+    Clock::time_point prev_now = k_start;
+    Clock::time_point now = k_start;
+    while (!wheel.is_empty())
+    {
+        // Jump to the next interesting time, same as run loop would do.
+        const auto next = wheel.next_expiry();
+        ASSERT_TRUE(next.has_value());
+        ASSERT_LT(now, *next);
+        prev_now = now;
+        now = *next;
+        fired += wheel.advance(now, [&](WheelTimer& timer)
+        {
+            const auto expiry = k_start + std::chrono::milliseconds(timer.entry.completion_key);
+            ASSERT_LT(prev_now, expiry);
+            ASSERT_GE(now, expiry);
+        });
+    }
+    ASSERT_EQ(k_timers_count, fired);
+}
@@ -0,0 +1,306 @@
+#include <gtest/gtest.h>
+#include <win_io/user_completion_port.h>
+
+#include <optional>
+#include <thread>
+#include <vector>
+#include <atomic>
+
+using wi::UserCompletionPort;
+using wi::PortEntry;
+
+using namespace std::chrono_literals;
+
+TEST(UserCompletionPort, Creation_Does_Not_Fail)
+{
+    std::error_code ec;
+    ASSERT_TRUE(UserCompletionPort::make(ec).has_value());
+    ASSERT_TRUE(UserCompletionPort::make(0/*use as much threads as CPUs*/, ec).has_value());
+    ASSERT_TRUE(UserCompletionPort::make(20/*specific threads hint*/, ec).has_value());
+}
+
+TEST(UserCompletionPort, Blocking_Get_Success_After_Post)
+{
+    std::error_code ec;
+    auto port = UserCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    const PortEntry send_data(1, 1, nullptr);
+    port->post(send_data, ec);
+    ASSERT_FALSE(ec);
+    const auto receive_data = port->get(ec);
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(send_data, receive_data);
+}
+
+TEST(UserCompletionPort, Get_Many_Returns_Entries_In_Post_Order)
+{
+    std::error_code ec;
+    auto port = UserCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    PortEntry to_send[2];
+    to_send[0] = PortEntry(1, 1, nullptr);
+    to_send[1] = PortEntry(2, 2, nullptr);
+    for (const PortEntry& entry : to_send)
+    {
+        port->post(entry, ec);
+        ASSERT_FALSE(ec);
+    }
+    PortEntry all_entries[3];
+    const auto ready = port->get_many(all_entries, ec);
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(std::size_t(2), ready.size());
+    ASSERT_TRUE(std::equal(std::begin(to_send), std::end(to_send), std::begin(ready)));
+}
+
+TEST(UserCompletionPort, Wait_Fails_Until_Post)
+{
+    std::error_code ec;
+    auto port = UserCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(std::nullopt, port->query(ec));
+    ASSERT_TRUE(ec);
+    ASSERT_EQ(std::nullopt, port->wait_for(20ms, ec));
+    ASSERT_TRUE(ec);
+
+    const PortEntry send_data(1, 1, nullptr);
+    port->post(send_data, ec);
+    ASSERT_FALSE(ec);
+    const auto receive_data = port->wait_for(20ms, ec);
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(send_data, receive_data);
+}
+
+TEST(UserCompletionPort, Post_Fails_When_Full)
+{
+    std::error_code ec;
+    auto port = UserCompletionPort::make(0, 2/*capacity*/, ec);
+    ASSERT_FALSE(ec);
+    port->post(PortEntry(1), ec);
+    ASSERT_FALSE(ec);
+    port->post(PortEntry(2), ec);
+    ASSERT_FALSE(ec);
+    port->post(PortEntry(3), ec);
+    ASSERT_EQ(std::errc::no_buffer_space, ec);
+}
+
+TEST(UserCompletionPort, Post_Many_Posts_Until_Full)
+{
+    std::error_code ec;
+    auto port = UserCompletionPort::make(0, 2/*capacity*/, ec);
+    ASSERT_FALSE(ec);
+    const PortEntry to_send[3] = {PortEntry(1), PortEntry(2), PortEntry(3)};
+    ASSERT_EQ(std::size_t(2), port->post_many(to_send, ec));
+    ASSERT_EQ(std::errc::no_buffer_space, ec);
+
+    PortEntry all_entries[3];
+    const auto ready = port->query_many(all_entries, ec);
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(std::size_t(2), ready.size());
+    ASSERT_TRUE(std::equal(std::begin(to_send), std::begin(to_send) + 2, std::begin(ready)));
+}
+
+TEST(UserCompletionPort, Post_Many_Wakes_Up_As_Many_Waiters_As_Entries)
+{
+    constexpr std::size_t k_threads_count = 3;
+    std::error_code ec;
+    auto port = UserCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+
+    std::atomic_size_t finished(0);
+    std::vector<std::thread> waiters;
+    for (std::size_t i = 0; i < k_threads_count; ++i)
+    {
+        waiters.emplace_back([&]()
+        {
+            std::error_code wait_ec;
+            (void)port->get(wait_ec);
+            ++finished;
+        });
+    }
+    std::this_thread::sleep_for(20ms);
+
+    const PortEntry to_send[2] = {PortEntry(1), PortEntry(2)};
+    ASSERT_EQ(std::size_t(2), port->post_many(to_send, ec));
+    ASSERT_FALSE(ec);
+    while (finished < 2)
+    {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(20ms);
+    ASSERT_EQ(std::size_t(2), finished);
+
+    port->post(PortEntry(3), ec);
+    ASSERT_FALSE(ec);
+    for (auto& waiter : waiters)
+    {
+        waiter.join();
+    }
+    ASSERT_EQ(k_threads_count, finished);
+}
+
+TEST(UserCompletionPort, Blocked_Waiter_Is_Woken_Up_By_Post)
+{
+    std::error_code ec;
+    auto port = UserCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+
+    std::optional<PortEntry> received;
+    std::thread waiter([&]()
+    {
+        std::error_code wait_ec;
+        received = port->get(wait_ec);
+    });
+    std::this_thread::sleep_for(20ms);
+    port->post(PortEntry(7), ec);
+    ASSERT_FALSE(ec);
+    waiter.join();
+    ASSERT_EQ(PortEntry(7), received);
+}
+
+TEST(UserCompletionPort, Most_Recently_Parked_Waiter_Is_Woken_Up_First)
+{
+    std::error_code ec;
+    auto port = UserCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+
+    std::atomic_int first_woken(0);
+    auto wait = [&](int id)
+    {
+        std::error_code wait_ec;
+        if (port->get(wait_ec))
+        {
+            int expected = 0;
+            first_woken.compare_exchange_strong(expected, id);
+        }
+    };
+    std::thread old_waiter(wait, 1);
+    std::this_thread::sleep_for(50ms);
+    std::thread new_waiter(wait, 2);
+    std::this_thread::sleep_for(50ms);
+
+    port->post(PortEntry(1), ec);
+    ASSERT_FALSE(ec);
+    std::this_thread::sleep_for(50ms);
+    ASSERT_EQ(2, first_woken);
+
+    port->post(PortEntry(2), ec);
+    ASSERT_FALSE(ec);
+    old_waiter.join();
+    new_waiter.join();
+}
+
+TEST(UserCompletionPort, Concurrent_Threads_Hint_Limits_Running_Threads)
+{
+    std::error_code ec;
+    auto port = UserCompletionPort::make(1/*single running thread*/, ec);
+    ASSERT_FALSE(ec);
+    port->post(PortEntry(1), ec);
+    ASSERT_FALSE(ec);
+    port->post(PortEntry(2), ec);
+    ASSERT_FALSE(ec);
+
+    // This thread is running now.
+    ASSERT_EQ(PortEntry(1), port->get(ec));
+    std::optional<PortEntry> other_data;
+    std::thread other([&]()
+    {
+        std::error_code wait_ec;
+        other_data = port->wait_for(50ms, wait_ec);
+    });
+    other.join();
+    ASSERT_EQ(std::nullopt, other_data);
+
+    // Came back: next entry is for us.
+    ASSERT_EQ(PortEntry(2), port->query(ec));
+    ASSERT_FALSE(ec);
+}
+
+TEST(UserCompletionPort, Waiting_On_Other_Port_Wakes_Up_Held_Back_Waiter)
+{
+    std::error_code ec;
+    auto port = UserCompletionPort::make(1/*single running thread*/, ec);
+    ASSERT_FALSE(ec);
+    auto other_port = UserCompletionPort::make(1, ec);
+    ASSERT_FALSE(ec);
+    port->post(PortEntry(1), ec);
+    ASSERT_FALSE(ec);
+
+    // This thread is running for `port` now.
+    ASSERT_EQ(PortEntry(1), port->get(ec));
+    std::atomic<bool> parked(false);
+    std::optional<PortEntry> other_data;
+    std::thread other([&]()
+    {
+        std::error_code wait_ec;
+        parked = true;
+        other_data = port->wait_for(10s, wait_ec);
+    });
+    while (!parked)
+    {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(10ms);
+    // Held back: this thread is still running.
+    port->post(PortEntry(2), ec);
+    ASSERT_FALSE(ec);
+    std::this_thread::sleep_for(10ms);
+
+    // Blocks on the other port instead: the slot is given away.
+    (void)other_port->wait_for(1ms, ec);
+    ASSERT_TRUE(ec);
+    other.join();
+    ASSERT_EQ(PortEntry(2), other_data);
+}
+
+TEST(UserCompletionPort, Multiple_Producers_Consumers_Receive_All_Posted_Entries)
+{
+    constexpr std::size_t k_producers_count = 4;
+    constexpr std::size_t k_consumers_count = 4;
+    constexpr std::size_t k_entries_per_producer = 10'000;
+    constexpr std::size_t k_entries_count = k_producers_count * k_entries_per_producer;
+    std::error_code ec;
+    auto port = UserCompletionPort::make(k_consumers_count, ec);
+    ASSERT_FALSE(ec);
+
+    std::atomic_size_t received(0);
+    std::atomic_size_t keys_sum(0);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < k_consumers_count; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            while (received < k_entries_count)
+            {
+                std::error_code wait_ec;
+                PortEntry entries[16];
+                for (const PortEntry& entry : port->wait_for_many(entries, 10ms, wait_ec))
+                {
+                    keys_sum += entry.completion_key;
+                    ++received;
+                }
+            }
+        });
+    }
+    for (std::size_t i = 0; i < k_producers_count; ++i)
+    {
+        threads.emplace_back([&, i]()
+        {
+            for (std::size_t j = 0; j < k_entries_per_producer; ++j)
+            {
+                std::error_code post_ec;
+                do
+                {
+                    port->post(PortEntry(0, i * k_entries_per_producer + j + 1), post_ec);
+                }
+                while (post_ec);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_EQ(k_entries_count, received);
+    ASSERT_EQ((k_entries_count * (k_entries_count + 1)) / 2, keys_sum);
+}
@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include <win_io_coro/async_channel.h>
+#include <win_io_coro/io_coro_scheduler.h>
+#include <win_io_coro/detached_task.h>
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+using namespace wi;
+using namespace coro;
+
+TEST(AsyncChannel, Buffered_Values_Are_Received_In_Order)
+{
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+    AsyncChannel<int> channel(scheduler, 2);
+
+    int value = 1;
+    ASSERT_TRUE(channel.try_send(value));
+    value = 2;
+    ASSERT_TRUE(channel.try_send(value));
+    value = 3;
+    ASSERT_FALSE(channel.try_send(value));
+
+    bool sent = false;
+    auto send = [](AsyncChannel<int>& channel, bool& sent) -> DetachedTask
+    {
+        sent = co_await channel.send(3);
+    };
+    // Waits for the free slot.
+    send(channel, sent);
+    ASSERT_FALSE(sent);
+
+    ASSERT_EQ(std::optional<int>(1), channel.try_receive());
+    ASSERT_FALSE(sent);
+    ASSERT_EQ(1u, scheduler.poll());
+    ASSERT_TRUE(sent);
+    ASSERT_EQ(std::optional<int>(2), channel.try_receive());
+    ASSERT_EQ(std::optional<int>(3), channel.try_receive());
+    ASSERT_EQ(std::nullopt, channel.try_receive());
+}
+
+TEST(AsyncChannel, Close_Fails_Senders_And_Drains_Receivers)
+{
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+    // Rendezvous: send() waits for the receiver.
+    AsyncChannel<std::unique_ptr<int>> channel(scheduler, 0);
+
+    std::vector<std::optional<std::unique_ptr<int>>> received;
+    auto receive = [](AsyncChannel<std::unique_ptr<int>>& channel
+        , std::vector<std::optional<std::unique_ptr<int>>>& received) -> DetachedTask
+    {
+        received.push_back(co_await channel.receive());
+    };
+    std::vector<bool> sent;
+    auto send = [](AsyncChannel<std::unique_ptr<int>>& channel, std::vector<bool>& sent, int value) -> DetachedTask
+    {
+        sent.push_back(co_await channel.send(std::make_unique<int>(value)));
+    };
+
+    // Receiver waits, sender hands the value over.
+    receive(channel, received);
+    send(channel, sent, 1);
+    ASSERT_EQ((std::vector<bool>{true}), sent);
+    ASSERT_TRUE(received.empty());
+    ASSERT_EQ(1u, scheduler.poll());
+    ASSERT_EQ(1u, received.size());
+    ASSERT_EQ(1, **received[0]);
+
+    // Sender waits, closed.
+    send(channel, sent, 2);
+    ASSERT_EQ(1u, sent.size());
+    channel.close();
+    ASSERT_TRUE(channel.is_closed());
+    ASSERT_EQ(1u, scheduler.poll());
+    ASSERT_EQ((std::vector<bool>{true, false}), sent);
+
+    send(channel, sent, 3);
+    ASSERT_EQ((std::vector<bool>{true, false, false}), sent);
+    receive(channel, received);
+    ASSERT_EQ(2u, received.size());
+    ASSERT_FALSE(received[1]);
+}
+
+TEST(AsyncChannel, Close_Resumes_Waiting_Receiver_With_Nothing)
+{
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+    AsyncChannel<int> channel(scheduler, 1);
+
+    bool finished = false;
+    std::optional<int> value(0);
+    auto receive = [](AsyncChannel<int>& channel, std::optional<int>& value, bool& finished) -> DetachedTask
+    {
+        value = co_await channel.receive();
+        finished = true;
+    };
+    receive(channel, value, finished);
+    ASSERT_FALSE(finished);
+    channel.close();
+    ASSERT_EQ(1u, scheduler.poll());
+    ASSERT_TRUE(finished);
+    ASSERT_FALSE(value);
+}
+
+TEST(AsyncChannel, Multiple_Producers_And_Consumers_Keep_Per_Producer_Order)
+{
+    constexpr int k_threads_count = 4;
+    constexpr int k_producers_count = 3;
+    constexpr int k_consumers_count = 3;
+    constexpr int k_values_count = 2000;
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+    AsyncChannel<int> channel(scheduler, 4);
+
+    struct Shared
+    {
+        std::atomic<int> producers{k_producers_count};
+        std::atomic<int> consumers{k_consumers_count};
+        std::atomic<long long> sum{0};
+        std::atomic<int> received{0};
+        std::atomic<int> out_of_order{0};
+    };
+    Shared shared;
+
+    auto produce = [](AsyncChannel<int>& channel, Shared& shared, int producer) -> DetachedTask
+    {
+        for (int i = 0; i < k_values_count; ++i)
+        {
+            const bool sent = co_await channel.send(producer * k_values_count + i);
+            EXPECT_TRUE(sent);
+        }
+        if (--shared.producers == 0)
+        {
+            channel.close();
+        }
+    };
+    auto consume = [](IoScheduler& scheduler, AsyncChannel<int>& channel, Shared& shared) -> DetachedTask
+    {
+        // Single consumer sees values of each producer in order.
+        std::vector<int> last(k_producers_count, -1);
+        while (std::optional<int> value = co_await channel.receive())
+        {
+            const int producer = *value / k_values_count;
+            if (*value <= last[producer])
+            {
+                ++shared.out_of_order;
+            }
+            last[producer] = *value;
+            shared.sum += *value;
+            ++shared.received;
+        }
+        if (--shared.consumers == 0)
+        {
+            scheduler.stop();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < k_threads_count; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            (void)scheduler.run();
+        });
+    }
+    for (int i = 0; i < k_consumers_count; ++i)
+    {
+        consume(scheduler, channel, shared);
+    }
+    for (int i = 0; i < k_producers_count; ++i)
+    {
+        produce(channel, shared, i);
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    constexpr int k_total = k_producers_count * k_values_count;
+    ASSERT_EQ(k_total, shared.received);
+    ASSERT_EQ((long long)(k_total - 1) * k_total / 2, shared.sum);
+    ASSERT_EQ(0, shared.out_of_order);
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include <win_io_coro/async_mutex.h>
+#include <win_io_coro/io_coro_scheduler.h>
+#include <win_io_coro/detached_task.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace wi;
+using namespace coro;
+
+using namespace std::chrono_literals;
+
+TEST(AsyncMutex, Unlock_Resumes_Waiter_Through_Scheduler)
+{
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+    AsyncMutex mutex(scheduler);
+
+    ASSERT_TRUE(mutex.try_lock());
+    ASSERT_FALSE(mutex.try_lock());
+
+    std::vector<int> order;
+    auto work = [](AsyncMutex& mutex, std::vector<int>& order, int id) -> DetachedTask
+    {
+        co_await mutex.lock();
+        order.push_back(id);
+        mutex.unlock();
+    };
+    work(mutex, order, 1);
+    work(mutex, order, 2);
+    ASSERT_EQ(0u, scheduler.poll());
+    ASSERT_TRUE(order.empty());
+
+    mutex.unlock();
+    // Not resumed inline.
+    ASSERT_TRUE(order.empty());
+    ASSERT_FALSE(mutex.try_lock());
+    ASSERT_EQ(1u, scheduler.poll());
+    ASSERT_EQ((std::vector<int>{1}), order);
+    // Unlocked by 1st waiter, that posted 2nd one.
+    ASSERT_EQ(1u, scheduler.poll());
+    ASSERT_EQ((std::vector<int>{1, 2}), order);
+    ASSERT_TRUE(mutex.try_lock());
+    mutex.unlock();
+}
+
+TEST(AsyncMutex, Critical_Section_Is_Exclusive_With_Multiple_Threads)
+{
+    constexpr int k_threads_count = 4;
+    constexpr int k_workers_count = 8;
+    constexpr int k_iterations = 200;
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+    AsyncMutex mutex(scheduler);
+
+    struct Shared
+    {
+        std::atomic<int> inside{0};
+        std::atomic<int> violations{0};
+        std::atomic<int> remaining{k_workers_count};
+        int counter = 0;
+    };
+    Shared shared;
+
+    auto work = [](IoScheduler& scheduler, AsyncMutex& mutex, Shared& shared) -> DetachedTask
+    {
+        for (int i = 0; i < k_iterations; ++i)
+        {
+            co_await mutex.lock();
+            if (shared.inside.fetch_add(1) != 0)
+            {
+                ++shared.violations;
+            }
+            ++shared.counter;
+            if ((i % 50) == 0)
+            {
+                // Hold the lock across the suspension.
+                co_await scheduler.sleep_for(1ms);
+            }
+            --shared.inside;
+            mutex.unlock();
+        }
+        if (--shared.remaining == 0)
+        {
+            scheduler.stop();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < k_threads_count; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            (void)scheduler.run();
+        });
+    }
+    for (int i = 0; i < k_workers_count; ++i)
+    {
+        work(scheduler, mutex, shared);
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    ASSERT_EQ(0, shared.violations);
+    ASSERT_EQ(k_workers_count * k_iterations, shared.counter);
+    ASSERT_TRUE(mutex.try_lock());
+    mutex.unlock();
+}
@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+#include <win_io_coro/async_scope.h>
+#include <win_io_coro/io_coro_scheduler.h>
+#include <win_io_coro/detached_task.h>
+#include <win_io_coro/task.h>
+
+#include <atomic>
+#include <chrono>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+using namespace wi;
+using namespace coro;
+
+using namespace std::chrono_literals;
+
+TEST(AsyncScope, Join_Without_Children_Does_Not_Suspend)
+{
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+    AsyncScope scope(scheduler);
+
+    bool joined = false;
+    auto join = [](AsyncScope& scope, bool& joined) -> DetachedTask
+    {
+        co_await scope.join();
+        joined = true;
+    };
+    join(scope, joined);
+    ASSERT_TRUE(joined);
+}
+
+TEST(AsyncScope, Join_Waits_For_All_Children)
+{
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+    AsyncScope scope(scheduler);
+
+    int finished = 0;
+    auto child = [](IoScheduler& scheduler, int& finished) -> Task<int>
+    {
+        (void)co_await scheduler.get();
+        ++finished;
+        co_return finished;
+    };
+    ASSERT_TRUE(scope.spawn(child(scheduler, finished)));
+    ASSERT_TRUE(scope.spawn(child(scheduler, finished)));
+    ASSERT_EQ(2u, scope.live());
+
+    bool joined = false;
+    auto join = [](AsyncScope& scope, bool& joined) -> DetachedTask
+    {
+        co_await scope.join();
+        joined = true;
+    };
+    join(scope, joined);
+    ASSERT_FALSE(joined);
+
+    io_port->post(PortEntry(1), ec);
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(1u, scheduler.poll());
+    ASSERT_EQ(1, finished);
+    ASSERT_EQ(1u, scope.live());
+    ASSERT_FALSE(joined);
+
+    io_port->post(PortEntry(2), ec);
+    ASSERT_FALSE(ec);
+    (void)scheduler.poll();
+    ASSERT_EQ(2, finished);
+    ASSERT_EQ(0u, scope.live());
+    // Resumed through the scheduler, not by the last child.
+    ASSERT_FALSE(joined);
+    ASSERT_EQ(1u, scheduler.poll());
+    ASSERT_TRUE(joined);
+}
+
+TEST(AsyncScope, Request_Stop_Reaches_Every_Child)
+{
+    constexpr int k_children_count = 10;
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+    AsyncScope scope(scheduler);
+
+    int canceled = 0;
+    for (int i = 0; i < k_children_count; ++i)
+    {
+        // Lambda is kept alive by the scope while the child runs.
+        ASSERT_TRUE(scope.spawn([&scheduler, &canceled](std::stop_token stop_token) -> Task<>
+        {
+            IoResult result = co_await scheduler.get(stop_token);
+            if (result.error == std::errc::operation_canceled)
+            {
+                ++canceled;
+            }
+        }));
+    }
+    ASSERT_EQ(std::size_t(k_children_count), scope.live());
+
+    bool joined = false;
+    auto shutdown = [](AsyncScope& scope, bool& joined) -> DetachedTask
+    {
+        scope.request_stop();
+        co_await scope.join();
+        joined = true;
+    };
+    shutdown(scope, joined);
+    ASSERT_TRUE(scope.stop_requested());
+    ASSERT_FALSE(scope.spawn([](std::stop_token) -> Task<> { co_return; }));
+    while (!joined)
+    {
+        (void)scheduler.poll();
+    }
+    ASSERT_EQ(k_children_count, canceled);
+    ASSERT_EQ(0u, scope.live());
+}
+
+TEST(AsyncScope, Children_Spawned_From_Multiple_Threads_Are_Joined)
+{
+    constexpr int k_threads_count = 4;
+    constexpr int k_children_count = 200;
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+    AsyncScope scope(scheduler);
+
+    std::atomic<int> finished(0);
+    auto grandchild = [](IoScheduler& scheduler, std::atomic<int>& finished) -> Task<>
+    {
+        co_await scheduler.sleep_for(1ms);
+        ++finished;
+    };
+    auto child = [](IoScheduler& scheduler, AsyncScope& scope
+        , std::atomic<int>& finished, decltype(grandchild)& grandchild) -> Task<>
+    {
+        co_await scheduler.sleep_for(1ms);
+        // Spawned while join() may be in progress already.
+        EXPECT_TRUE(scope.spawn(grandchild(scheduler, finished)));
+        ++finished;
+    };
+    auto join = [](IoScheduler& scheduler, AsyncScope& scope) -> DetachedTask
+    {
+        co_await scope.join();
+        scheduler.stop();
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < k_threads_count; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            (void)scheduler.run();
+        });
+    }
+    for (int i = 0; i < k_children_count; ++i)
+    {
+        ASSERT_TRUE(scope.spawn(child(scheduler, scope, finished, grandchild)));
+    }
+    join(scheduler, scope);
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    ASSERT_EQ(2 * k_children_count, finished);
+    ASSERT_EQ(0u, scope.live());
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include <win_io_coro/async_semaphore.h>
+#include <win_io_coro/io_coro_scheduler.h>
+#include <win_io_coro/detached_task.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace wi;
+using namespace coro;
+
+using namespace std::chrono_literals;
+
+TEST(AsyncSemaphore, Release_Hands_Permits_To_Waiters_In_Order)
+{
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+    AsyncSemaphore semaphore(scheduler, 1);
+
+    std::vector<int> order;
+    auto work = [](AsyncSemaphore& semaphore, std::vector<int>& order, int id) -> DetachedTask
+    {
+        co_await semaphore.acquire();
+        order.push_back(id);
+    };
+    work(semaphore, order, 1);
+    work(semaphore, order, 2);
+    work(semaphore, order, 3);
+    ASSERT_EQ((std::vector<int>{1}), order);
+    ASSERT_EQ(0u, semaphore.available());
+    ASSERT_FALSE(semaphore.try_acquire());
+
+    // 2 waiters get the permits, 1 left.
+    semaphore.release(3);
+    ASSERT_EQ(1u, semaphore.available());
+    ASSERT_EQ((std::vector<int>{1}), order);
+    ASSERT_EQ(2u, scheduler.poll());
+    ASSERT_EQ((std::vector<int>{1, 2, 3}), order);
+    ASSERT_TRUE(semaphore.try_acquire());
+    ASSERT_EQ(0u, semaphore.available());
+}
+
+TEST(AsyncSemaphore, Limits_Operations_In_Flight_With_Multiple_Threads)
+{
+    constexpr int k_threads_count = 4;
+    constexpr int k_workers_count = 16;
+    constexpr std::size_t k_limit = 3;
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+    AsyncSemaphore semaphore(scheduler, k_limit);
+
+    struct Shared
+    {
+        std::atomic<std::size_t> in_flight{0};
+        std::atomic<std::size_t> max_in_flight{0};
+        std::atomic<int> remaining{k_workers_count};
+    };
+    Shared shared;
+
+    auto work = [](IoScheduler& scheduler, AsyncSemaphore& semaphore, Shared& shared) -> DetachedTask
+    {
+        for (int i = 0; i < 5; ++i)
+        {
+            co_await semaphore.acquire();
+            const std::size_t in_flight = ++shared.in_flight;
+            std::size_t max = shared.max_in_flight;
+            while ((in_flight > max) && !shared.max_in_flight.compare_exchange_weak(max, in_flight))
+            {
+            }
+            co_await scheduler.sleep_for(1ms);
+            --shared.in_flight;
+            semaphore.release();
+        }
+        if (--shared.remaining == 0)
+        {
+            scheduler.stop();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < k_threads_count; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            (void)scheduler.run();
+        });
+    }
+    for (int i = 0; i < k_workers_count; ++i)
+    {
+        work(scheduler, semaphore, shared);
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    ASSERT_LE(shared.max_in_flight.load(), k_limit);
+    ASSERT_GE(shared.max_in_flight.load(), 1u);
+    ASSERT_EQ(k_limit, semaphore.available());
+}
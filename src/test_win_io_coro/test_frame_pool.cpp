@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <win_io_coro/frame_pool.h>
+#include <win_io_coro/detached_task.h>
+#include <win_io_coro/io_coro_scheduler.h>
+#include <win_io_coro/io_operation_task.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace wi;
+using namespace coro;
+
+namespace
+{
+
+    // Installs stats for the test's duration.
+    struct ScopedStats
+    {
+        std::unique_ptr<FramePoolStats> stats = std::make_unique<FramePoolStats>();
+
+        ScopedStats()
+        {
+            FramePool::set_stats(stats.get());
+        }
+
+        ~ScopedStats()
+        {
+            FramePool::set_stats(nullptr);
+        }
+    };
+
+} // namespace
+
+TEST(FramePool, Freed_Block_Is_Reused_For_Frame_Of_The_Same_Size_Class)
+{
+    // Fresh thread: empty cache.
+    std::thread([]()
+    {
+        ScopedStats scoped;
+        void* first = FramePool::allocate(100);
+        ASSERT_NE(nullptr, first);
+        ASSERT_EQ(1u, scoped.stats->misses);
+        FramePool::deallocate(first, 100);
+        ASSERT_EQ(1u, scoped.stats->recycled);
+
+        // 100 and 120 are in (64, 128] class.
+        void* second = FramePool::allocate(120);
+        ASSERT_EQ(first, second);
+        ASSERT_EQ(1u, scoped.stats->hits);
+        FramePool::deallocate(second, 120);
+    }).join();
+}
+
+TEST(FramePool, Big_Frames_Are_Not_Cached)
+{
+    ScopedStats scoped;
+    constexpr std::size_t k_size = FramePool::kMaxBlockSize + 1;
+    void* ptr = FramePool::allocate(k_size);
+    ASSERT_NE(nullptr, ptr);
+    FramePool::deallocate(ptr, k_size);
+    ASSERT_EQ(1u, scoped.stats->misses);
+    ASSERT_EQ(1u, scoped.stats->released);
+    ASSERT_EQ(0u, scoped.stats->hits);
+    ASSERT_EQ(0u, scoped.stats->recycled);
+}
+
+TEST(FramePool, Short_Detached_Coroutines_Reuse_Frames)
+{
+    static constexpr std::size_t k_coros_count = 1000;
+    std::thread([]()
+    {
+        ScopedStats scoped;
+        std::size_t finished = 0;
+        auto work = [&]() -> DetachedTask
+        {
+            ++finished;
+            co_return;
+        };
+        for (std::size_t i = 0; i < k_coros_count; ++i)
+        {
+            work();
+        }
+        ASSERT_EQ(k_coros_count, finished);
+        ASSERT_EQ(1u, scoped.stats->misses);
+        ASSERT_EQ(k_coros_count - 1, scoped.stats->hits);
+        ASSERT_EQ(k_coros_count, scoped.stats->recycled);
+    }).join();
+}
+
+TEST(FramePool, Frame_Can_Be_Freed_On_Other_Thread)
+{
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+    ScopedStats scoped;
+
+    IoOperationTask operation;
+    bool finished = false;
+    auto work = [](IoOperationTask& operation, bool& finished) -> DetachedTask
+    {
+        (void)co_await operation;
+        finished = true;
+    };
+    work(operation, finished);
+    ASSERT_FALSE(finished);
+
+    // Resumed and destroyed on other thread.
+    std::thread([&]()
+    {
+        std::error_code thread_ec;
+        io_port->post(PortEntry(0, 0, operation.overlapped()), thread_ec);
+        ASSERT_EQ(1u, scheduler.poll());
+    }).join();
+    ASSERT_TRUE(finished);
+    ASSERT_EQ(1u, scoped.stats->recycled + scoped.stats->released);
+}
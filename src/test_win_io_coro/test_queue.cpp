@@ -5,6 +5,7 @@
 #include <thread>
 #include <algorithm>
 #include <random>
+#include <atomic>
 
 using namespace wi::coro::detail;
 
@@ -327,3 +328,148 @@ TEST(Queue, Multiple_Producers_Consumers_Threads)
         << "Output size: " << output.size();
 }
 
+
+TEST(MPSCQueue, Default_Constructed_Queue_Has_No_Elements)
+{
+    IntrusiveMPSCQueue<TestElement> queue;
+    ASSERT_TRUE(queue.is_empty());
+    TestElement* element = nullptr;
+    ASSERT_FALSE(queue.pop(element));
+    ASSERT_EQ(nullptr, element);
+}
+
+TEST(MPSCQueue, Pop_Returns_In_FIFO_Order_With_Interleaved_Pushes)
+{
+    Elements input = MakeElements(6);
+    IntrusiveMPSCQueue<TestElement> queue;
+    queue.push(&input[0]);
+    queue.push(&input[1]);
+    queue.push(&input[2]);
+
+    TestElement* element = nullptr;
+    ASSERT_TRUE(queue.pop(element));
+    ASSERT_EQ(&input[0], element);
+
+    // Pushed while older elements are still cached by the consumer.
+    queue.push(&input[3]);
+    queue.push(&input[4]);
+    ASSERT_FALSE(queue.is_empty());
+    for (std::size_t i = 1; i < 5; ++i)
+    {
+        ASSERT_TRUE(queue.pop(element));
+        ASSERT_EQ(&input[i], element);
+    }
+    ASSERT_TRUE(queue.is_empty());
+
+    queue.push(&input[5]);
+    ASSERT_TRUE(queue.pop(element));
+    ASSERT_EQ(&input[5], element);
+    ASSERT_FALSE(queue.pop(element));
+    ASSERT_TRUE(queue.is_empty());
+}
+
+TEST(MPSCQueue, Remove_Unlinks_Element_And_Keeps_Order_Of_Others)
+{
+    Elements input = MakeElements(5);
+    IntrusiveMPSCQueue<TestElement> queue;
+    queue.push(&input[0]);
+    queue.push(&input[1]);
+    TestElement* element = nullptr;
+    ASSERT_TRUE(queue.pop(element));
+    ASSERT_EQ(&input[0], element);
+    // input[1] is cached by the consumer, the rest are pushed.
+    queue.push(&input[2]);
+    queue.push(&input[3]);
+    queue.push(&input[4]);
+
+    ASSERT_TRUE(queue.remove(&input[3]));
+    ASSERT_FALSE(queue.remove(&input[3]));
+    ASSERT_FALSE(queue.remove(&input[0]));
+    ASSERT_TRUE(queue.remove(&input[1]));
+
+    ASSERT_TRUE(queue.pop(element));
+    ASSERT_EQ(&input[2], element);
+    ASSERT_TRUE(queue.pop(element));
+    ASSERT_EQ(&input[4], element);
+    ASSERT_TRUE(queue.is_empty());
+}
+
+TEST(MPSCQueue, Push_After_Removing_Last_Element_Keeps_FIFO_Order)
+{
+    Elements input = MakeElements(5);
+    IntrusiveMPSCQueue<TestElement> queue;
+    queue.push(&input[0]);
+    queue.push(&input[1]);
+    queue.push(&input[2]);
+    ASSERT_TRUE(queue.remove(&input[0]));
+    // Last element of consumer list: next pushes are appended to input[1].
+    ASSERT_TRUE(queue.remove(&input[2]));
+    queue.push(&input[3]);
+    queue.push(&input[4]);
+    ASSERT_TRUE(queue.remove(&input[4]));
+
+    TestElement* element = nullptr;
+    ASSERT_TRUE(queue.pop(element));
+    ASSERT_EQ(&input[1], element);
+    ASSERT_TRUE(queue.pop(element));
+    ASSERT_EQ(&input[3], element);
+    ASSERT_TRUE(queue.is_empty());
+
+    // Consumer list became empty by pop().
+    queue.push(&input[0]);
+    ASSERT_TRUE(queue.pop(element));
+    ASSERT_EQ(&input[0], element);
+    ASSERT_FALSE(queue.pop(element));
+}
+
+TEST(MPSCQueue, Multiple_Producers_Single_Consumer_Keeps_Per_Producer_Order)
+{
+    constexpr std::size_t k_producers_count = 5;
+    constexpr std::size_t k_elements_per_producer = 2000;
+    constexpr std::size_t k_elements_count = k_producers_count * k_elements_per_producer;
+
+    Elements input = MakeElements(k_elements_count);
+    IntrusiveMPSCQueue<TestElement> queue;
+    std::atomic_bool start(false);
+
+    std::vector<std::thread> producers;
+    producers.reserve(k_producers_count);
+    for (std::size_t producer_id = 0; producer_id < k_producers_count; ++producer_id)
+    {
+        producers.emplace_back([&, producer_id]()
+        {
+            while (!start)
+            {
+                std::this_thread::yield();
+            }
+            for (std::size_t i = 0; i < k_elements_per_producer; ++i)
+            {
+                queue.push(&input[producer_id * k_elements_per_producer + i]);
+            }
+        });
+    }
+
+    start = true;
+    Elements output;
+    output.reserve(k_elements_count);
+    std::vector<int> last_per_producer(k_producers_count, 0);
+    while (output.size() < k_elements_count)
+    {
+        TestElement* element = nullptr;
+        if (!queue.pop(element))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        const std::size_t producer_id = std::size_t(element->value - 1) / k_elements_per_producer;
+        ASSERT_LT(last_per_producer[producer_id], element->value);
+        last_per_producer[producer_id] = element->value;
+        output.push_back(*element);
+    }
+    WaitAll(producers);
+
+    ASSERT_TRUE(queue.is_empty());
+    ASSERT_TRUE(std::is_permutation(
+        output.begin(), output.end()
+        , input.begin(), input.end()));
+}
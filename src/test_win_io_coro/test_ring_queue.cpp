@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include <win_io_coro/detail/ring_queue.h>
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+using namespace wi::coro::detail;
+
+namespace
+{
+
+    struct TestElement
+    {
+        int value = 0;
+    };
+
+    std::vector<TestElement> MakeElements(std::size_t count)
+    {
+        std::vector<TestElement> elements(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            elements[i].value = static_cast<int>(i + 1);
+        }
+        return elements;
+    }
+
+} // namespace
+
+TEST(RingQueue, Capacity_Is_Rounded_Up_To_Power_Of_Two)
+{
+    RingQueue<TestElement> queue(5);
+    ASSERT_EQ(std::size_t(8), queue.capacity());
+    ASSERT_TRUE(queue.is_empty());
+}
+
+TEST(RingQueue, Pop_Returns_In_FIFO_Order_And_Push_Fails_When_Full)
+{
+    auto input = MakeElements(5);
+    RingQueue<TestElement> queue(4);
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        ASSERT_TRUE(queue.try_push(&input[i]));
+    }
+    ASSERT_FALSE(queue.try_push(&input[4]));
+
+    TestElement* element = nullptr;
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        ASSERT_TRUE(queue.try_pop(element));
+        ASSERT_EQ(&input[i], element);
+    }
+    ASSERT_FALSE(queue.try_pop(element));
+    ASSERT_TRUE(queue.is_empty());
+}
+
+TEST(RingQueue, Batch_Push_Pop_Take_As_Much_As_Possible)
+{
+    auto input = MakeElements(6);
+    std::vector<TestElement*> pointers;
+    for (auto& element : input)
+    {
+        pointers.push_back(&element);
+    }
+
+    RingQueue<TestElement> queue(4);
+    ASSERT_EQ(std::size_t(0), queue.try_push_many({}));
+    ASSERT_EQ(std::size_t(4), queue.try_push_many(pointers));
+    ASSERT_EQ(std::size_t(0), queue.try_push_many(pointers));
+
+    TestElement* output[3]{};
+    ASSERT_EQ(std::size_t(3), queue.try_pop_many(output));
+    ASSERT_EQ(&input[0], output[0]);
+    ASSERT_EQ(&input[1], output[1]);
+    ASSERT_EQ(&input[2], output[2]);
+
+    // Wraps around.
+    ASSERT_EQ(std::size_t(2), queue.try_push_many(std::span(pointers).subspan(4)));
+    ASSERT_EQ(std::size_t(3), queue.try_pop_many(output));
+    ASSERT_EQ(&input[3], output[0]);
+    ASSERT_EQ(&input[4], output[1]);
+    ASSERT_EQ(&input[5], output[2]);
+    ASSERT_EQ(std::size_t(0), queue.try_pop_many(output));
+}
+
+TEST(RingQueue, Multiple_Producers_Consumers_Threads)
+{
+    constexpr std::size_t k_producers_count = 4;
+    constexpr std::size_t k_consumers_count = 4;
+    constexpr std::size_t k_elements_per_producer = 5000;
+    constexpr std::size_t k_elements_count = k_producers_count * k_elements_per_producer;
+
+    auto input = MakeElements(k_elements_count);
+    RingQueue<TestElement> queue(64);
+    std::vector<std::vector<TestElement*>> output_per_consumer(k_consumers_count);
+    std::atomic_size_t consumed(0);
+    std::atomic_bool start(false);
+
+    std::vector<std::thread> threads;
+    for (std::size_t producer_id = 0; producer_id < k_producers_count; ++producer_id)
+    {
+        threads.emplace_back([&, producer_id]()
+        {
+            while (!start)
+            {
+                std::this_thread::yield();
+            }
+            TestElement* batch[3]{};
+            std::size_t i = 0;
+            while (i < k_elements_per_producer)
+            {
+                // Odd producers push in batches.
+                if (producer_id % 2)
+                {
+                    const std::size_t count = (std::min)(std::size(batch), k_elements_per_producer - i);
+                    for (std::size_t j = 0; j < count; ++j)
+                    {
+                        batch[j] = &input[producer_id * k_elements_per_producer + i + j];
+                    }
+                    std::size_t pushed = 0;
+                    while (pushed < count)
+                    {
+                        pushed += queue.try_push_many(std::span(batch).subspan(pushed, count - pushed));
+                    }
+                    i += count;
+                }
+                else if (queue.try_push(&input[producer_id * k_elements_per_producer + i]))
+                {
+                    ++i;
+                }
+            }
+        });
+    }
+    for (std::size_t consumer_id = 0; consumer_id < k_consumers_count; ++consumer_id)
+    {
+        threads.emplace_back([&, consumer_id]()
+        {
+            while (!start)
+            {
+                std::this_thread::yield();
+            }
+            auto& elements = output_per_consumer[consumer_id];
+            TestElement* batch[4]{};
+            while (consumed < k_elements_count)
+            {
+                const std::size_t count = queue.try_pop_many(batch);
+                elements.insert(elements.end(), batch, batch + count);
+                consumed += count;
+                if (count == 0)
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    start = true;
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_TRUE(queue.is_empty());
+    std::vector<TestElement*> output;
+    for (auto& elements : output_per_consumer)
+    {
+        output.insert(output.end(), elements.begin(), elements.end());
+    }
+    std::sort(output.begin(), output.end());
+    ASSERT_EQ(k_elements_count, output.size());
+    ASSERT_TRUE(std::adjacent_find(output.begin(), output.end()) == output.end());
+    ASSERT_EQ(&input.front(), output.front());
+    ASSERT_EQ(&input.back(), output.back());
+}
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include <win_io_coro/sector_buffer_pool.h>
+
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <cstdint>
+#include <cstring>
+
+using namespace wi;
+using namespace coro;
+
+TEST(SectorBufferPool, Blocks_Are_Sector_Aligned_And_Rounded_Up_To_Size_Class)
+{
+    SectorBufferPool pool(512);
+    const std::pair<std::size_t, std::size_t> sizes[] =
+    {
+        {1, 4 * 1024},
+        {4 * 1024, 4 * 1024},
+        {4 * 1024 + 1, 8 * 1024},
+        {100 * 1024, 128 * 1024},
+        {SectorBufferPool::kMaxBlockSize, SectorBufferPool::kMaxBlockSize},
+        // Allocated directly.
+        {SectorBufferPool::kMaxBlockSize + 1, SectorBufferPool::kMaxBlockSize + 512},
+    };
+    for (const auto& [size, expected] : sizes)
+    {
+        SectorBuffer buffer = pool.allocate(size);
+        ASSERT_TRUE(buffer);
+        ASSERT_EQ(expected, buffer.size());
+        ASSERT_EQ(0u, std::uintptr_t(buffer.data()) % 512);
+        std::memset(buffer.data(), 0xAB, buffer.size());
+    }
+}
+
+TEST(SectorBufferPool, Returned_Block_Is_Reused)
+{
+    SectorBufferPool pool;
+    std::uint8_t* data = nullptr;
+    {
+        SectorBuffer buffer = pool.allocate(4 * 1024);
+        data = buffer.data();
+    }
+    ASSERT_EQ(1u, pool.slabs_count());
+
+    SectorBuffer buffer = pool.allocate(100);
+    ASSERT_EQ(data, buffer.data());
+    SectorBuffer moved = std::move(buffer);
+    ASSERT_FALSE(buffer);
+    ASSERT_EQ(data, moved.data());
+    ASSERT_EQ(1u, pool.slabs_count());
+}
+
+TEST(SectorBufferPool, New_Slab_Is_Allocated_Once_Slab_Is_Exhausted)
+{
+    constexpr std::size_t k_block_size = 64 * 1024;
+    constexpr std::size_t k_blocks_per_slab = SectorBufferPool::kSlabSize / k_block_size;
+    SectorBufferPool pool;
+    std::vector<SectorBuffer> buffers;
+    std::set<std::uint8_t*> unique;
+    for (std::size_t i = 0; i < k_blocks_per_slab + 1; ++i)
+    {
+        buffers.push_back(pool.allocate(k_block_size));
+        unique.insert(buffers.back().data());
+    }
+    ASSERT_EQ(buffers.size(), unique.size());
+    ASSERT_EQ(2u, pool.slabs_count());
+
+    buffers.clear();
+    for (std::size_t i = 0; i < k_blocks_per_slab + 1; ++i)
+    {
+        buffers.push_back(pool.allocate(k_block_size));
+    }
+    ASSERT_EQ(2u, pool.slabs_count());
+}
+
+TEST(SectorBufferPool, Blocks_Can_Be_Returned_From_Other_Threads)
+{
+    constexpr std::size_t k_threads_count = 4;
+    constexpr std::size_t k_iterations = 1'000;
+    SectorBufferPool pool;
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < k_threads_count; ++i)
+    {
+        threads.emplace_back([&pool, i]()
+        {
+            for (std::size_t j = 0; j < k_iterations; ++j)
+            {
+                SectorBuffer buffer = pool.allocate((i + 1) * 4 * 1024);
+                buffer.data()[0] = std::uint8_t(j);
+                // Returned by the other thread.
+                std::thread([block = std::move(buffer)]() {}).join();
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    // Classes of 4K, 8K, 16K (12K rounded up); blocks are reused.
+    ASSERT_LE(pool.slabs_count(), 3u);
+}
@@ -0,0 +1,212 @@
+#include <gtest/gtest.h>
+#include <win_io_coro/io_coro_scheduler.h>
+#include <win_io_coro/with_timeout.h>
+#include <win_io_coro/detached_task.h>
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <stop_token>
+#include <thread>
+
+using namespace wi;
+using namespace coro;
+
+using namespace std::chrono_literals;
+using Clock = std::chrono::steady_clock;
+
+TEST(Sleep, Coroutine_Is_Resumed_By_Poll_Once_Time_Passes)
+{
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+
+    bool finished = false;
+    auto work = [](IoScheduler& scheduler, bool& finished) -> DetachedTask
+    {
+        co_await scheduler.sleep_for(5ms);
+        finished = true;
+    };
+    const auto start = Clock::now();
+    work(scheduler, finished);
+    ASSERT_FALSE(finished);
+    ASSERT_EQ(0u, scheduler.poll());
+    while (!finished)
+    {
+        (void)scheduler.poll();
+    }
+    ASSERT_GE(Clock::now() - start, 5ms);
+}
+
+TEST(Sleep, Zero_Time_Does_Not_Suspend)
+{
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+
+    bool finished = false;
+    auto work = [](IoScheduler& scheduler, bool& finished) -> DetachedTask
+    {
+        co_await scheduler.sleep_for(0ms);
+        finished = true;
+    };
+    work(scheduler, finished);
+    ASSERT_TRUE(finished);
+}
+
+TEST(Sleep, Earlier_Timer_Wakes_Up_Blocked_Run)
+{
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+
+    std::atomic<bool> finished(false);
+    auto work = [](IoScheduler& scheduler, std::atomic<bool>& finished, Clock::duration time) -> DetachedTask
+    {
+        co_await scheduler.sleep_for(time);
+        finished = true;
+        scheduler.stop();
+    };
+    // The thread blocks with no time-out: there are no timers.
+    std::thread runner([&]()
+    {
+        (void)scheduler.run();
+    });
+    std::this_thread::sleep_for(10ms);
+    const auto start = Clock::now();
+    work(scheduler, finished, 20ms);
+    runner.join();
+    ASSERT_TRUE(finished);
+    ASSERT_GE(Clock::now() - start, 20ms);
+    ASSERT_LT(Clock::now() - start, 10s);
+}
+
+TEST(Sleep, Timer_Scheduled_During_Long_Resume_Wakes_Up_Blocked_Run)
+{
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+
+    std::atomic<bool> finished(false);
+    Clock::time_point scheduled;
+    Clock::duration delay{};
+    auto sleeper = [](IoScheduler& scheduler, std::atomic<bool>& finished
+        , const Clock::time_point& scheduled, Clock::duration& delay) -> DetachedTask
+    {
+        co_await scheduler.sleep_for(10ms);
+        delay = Clock::now() - scheduled;
+        finished = true;
+        scheduler.stop();
+    };
+    // Resumed by one of run() threads and keeps it busy until
+    // `sleeper` finishes (or for a long time); the other one is blocked.
+    auto work = [&]() -> DetachedTask
+    {
+        co_await scheduler.sleep_for(20ms);
+        scheduled = Clock::now();
+        sleeper(scheduler, finished, scheduled, delay);
+        const auto busy_until = scheduled + 2s;
+        while (!finished && (Clock::now() < busy_until))
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+    };
+    work();
+    std::thread runners[2];
+    for (auto& runner : runners)
+    {
+        runner = std::thread([&]()
+        {
+            (void)scheduler.run();
+        });
+    }
+    for (auto& runner : runners)
+    {
+        runner.join();
+    }
+    ASSERT_TRUE(finished);
+    // Not when `work` gives up.
+    ASSERT_LT(delay, 1s);
+}
+
+TEST(Sleep, Timers_Expire_In_Order_From_Run)
+{
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+
+    std::vector<int> order;
+    auto work = [](IoScheduler& scheduler, std::vector<int>& order
+        , Clock::duration time, int id, bool stop) -> DetachedTask
+    {
+        co_await scheduler.sleep_for(time);
+        order.push_back(id);
+        if (stop)
+        {
+            scheduler.stop();
+        }
+    };
+    work(scheduler, order, 30ms, 3, true);
+    work(scheduler, order, 10ms, 1, false);
+    work(scheduler, order, 20ms, 2, false);
+    ASSERT_EQ(3u, scheduler.run());
+    ASSERT_EQ((std::vector<int>{1, 2, 3}), order);
+}
+
+TEST(Sleep, With_Timeout_Returns_Nothing_And_Cancels_Operation_On_Time_Out)
+{
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+
+    bool finished = false;
+    std::optional<IoResult> result;
+    auto work = [](IoScheduler& scheduler, std::optional<IoResult>& result, bool& finished) -> DetachedTask
+    {
+        // Nobody posts the data.
+        result = co_await with_timeout(scheduler, scheduler.get(std::stop_token()), 10ms);
+        finished = true;
+    };
+    const auto start = Clock::now();
+    work(scheduler, result, finished);
+    while (!finished)
+    {
+        (void)scheduler.run_one();
+    }
+    ASSERT_GE(Clock::now() - start, 10ms);
+    ASSERT_FALSE(result);
+}
+
+TEST(Sleep, With_Timeout_Returns_Result_And_Cancels_Timer)
+{
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+
+    bool finished = false;
+    std::optional<IoResult> result;
+    auto work = [](IoScheduler& scheduler, std::optional<IoResult>& result, bool& finished) -> DetachedTask
+    {
+        result = co_await with_timeout(scheduler, scheduler.get(std::stop_token()), 1h);
+        finished = true;
+    };
+    work(scheduler, result, finished);
+    io_port->post(PortEntry(7), ec);
+    ASSERT_FALSE(ec);
+    const auto start = Clock::now();
+    while (!finished)
+    {
+        (void)scheduler.run_one();
+    }
+    ASSERT_LT(Clock::now() - start, 10s);
+    ASSERT_TRUE(result);
+    ASSERT_FALSE(result->error);
+    ASSERT_EQ(PortEntry(7), result->entry);
+}
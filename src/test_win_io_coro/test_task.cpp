@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include <win_io_coro/task.h>
+#include <win_io_coro/detached_task.h>
+#include <win_io_coro/io_coro_scheduler.h>
+#include <win_io_coro/io_operation_task.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+using namespace wi;
+using namespace coro;
+
+namespace
+{
+
+    Task<int> Value(int value)
+    {
+        co_return value;
+    }
+
+    Task<int> Sum(int count)
+    {
+        int sum = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            sum += co_await Value(1);
+        }
+        co_return sum;
+    }
+
+    Task<> Throw()
+    {
+        throw std::runtime_error("task");
+        co_return;
+    }
+
+} // namespace
+
+TEST(Task, Is_Lazy_And_Returns_Value_To_Awaiter)
+{
+    bool started = false;
+    auto make = [](bool& started) -> Task<std::string>
+    {
+        started = true;
+        co_return std::string("value");
+    };
+    Task<std::string> task = make(started);
+    ASSERT_FALSE(started);
+    ASSERT_FALSE(task.is_ready());
+
+    std::string result;
+    auto run = [](Task<std::string>& task, std::string& result) -> DetachedTask
+    {
+        result = co_await task;
+    };
+    run(task, result);
+    ASSERT_TRUE(started);
+    ASSERT_TRUE(task.is_ready());
+    ASSERT_EQ("value", result);
+}
+
+TEST(Task, Move_Only_Value_Is_Returned)
+{
+    std::unique_ptr<int> result;
+    auto run = [](std::unique_ptr<int>& result) -> DetachedTask
+    {
+        auto make = []() -> Task<std::unique_ptr<int>>
+        {
+            co_return std::make_unique<int>(5);
+        };
+        result = co_await make();
+    };
+    run(result);
+    ASSERT_TRUE(result);
+    ASSERT_EQ(5, *result);
+}
+
+TEST(Task, Exception_Is_Rethrown_To_Awaiter)
+{
+    std::string error;
+    auto run = [](std::string& error) -> DetachedTask
+    {
+        try
+        {
+            co_await Throw();
+        }
+        catch (const std::runtime_error& e)
+        {
+            error = e.what();
+        }
+    };
+    run(error);
+    ASSERT_EQ("task", error);
+}
+
+TEST(Task, Many_Synchronously_Completed_Tasks_Do_Not_Grow_Stack)
+{
+    // Without symmetric transfer each completion resumes the awaiter
+    // from inside the previous one; this would overflow the stack.
+    constexpr int k_count = 1'000'000;
+    int result = 0;
+    auto run = [](int& result) -> DetachedTask
+    {
+        result = co_await Sum(k_count);
+    };
+    run(result);
+    ASSERT_EQ(k_count, result);
+}
+
+TEST(Task, Is_Resumed_By_Io_Operation_Completion)
+{
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+
+    IoOperationTask operation;
+    auto read = [](IoOperationTask& operation) -> Task<WinDWORD>
+    {
+        IoResult result = co_await operation;
+        co_return result.entry.bytes_transferred;
+    };
+    WinDWORD bytes = 0;
+    auto run = [&read](IoOperationTask& operation, WinDWORD& bytes) -> DetachedTask
+    {
+        bytes = co_await read(operation);
+    };
+    run(operation, bytes);
+    ASSERT_EQ(WinDWORD(0), bytes);
+
+    io_port->post(PortEntry(42, 0, operation.overlapped()), ec);
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(1u, scheduler.poll());
+    ASSERT_EQ(WinDWORD(42), bytes);
+}
@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+#include <win_io_coro/when_all.h>
+#include <win_io_coro/when_any.h>
+#include <win_io_coro/task.h>
+#include <win_io_coro/detached_task.h>
+#include <win_io_coro/io_coro_scheduler.h>
+#include <win_io_coro/io_operation_task.h>
+
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <variant>
+#include <vector>
+
+using namespace wi;
+using namespace coro;
+
+namespace
+{
+
+    Task<int> Value(int value)
+    {
+        co_return value;
+    }
+
+    Task<> Nothing()
+    {
+        co_return;
+    }
+
+    Task<int> Throw(std::string message)
+    {
+        throw std::runtime_error(message);
+        co_return 0;
+    }
+
+    // IoOperationTask that completes (with no data) once cancelled.
+    struct CancellableOperation
+    {
+        IoOperationTask operation;
+        IoCompletionPort* port = nullptr;
+        std::size_t cancels = 0;
+
+        bool await_ready() const noexcept
+        {
+            return operation.await_ready();
+        }
+
+        bool await_suspend(std::coroutine_handle<> awaiter) noexcept
+        {
+            return operation.await_suspend(awaiter);
+        }
+
+        IoResult await_resume() noexcept
+        {
+            return operation.await_resume();
+        }
+
+        void cancel()
+        {
+            ++cancels;
+            std::error_code ec;
+            port->post(PortEntry(0, 0, operation.overlapped()), ec);
+        }
+    };
+
+} // namespace
+
+TEST(WhenAll, Returns_Results_In_Input_Order)
+{
+    Task<int> lvalue_task = Value(1);
+    std::tuple<int, std::monostate, int> result;
+    auto run = [](Task<int>& lvalue_task, std::tuple<int, std::monostate, int>& result) -> DetachedTask
+    {
+        result = co_await when_all(lvalue_task, Nothing(), Value(3));
+    };
+    run(lvalue_task, result);
+    ASSERT_EQ(1, std::get<0>(result));
+    ASSERT_EQ(3, std::get<2>(result));
+}
+
+TEST(WhenAll, Resumes_Once_All_Operations_Completed)
+{
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+
+    constexpr std::size_t k_count = 8;
+    std::vector<IoOperationTask> operations(k_count);
+    std::vector<IoResult> results;
+    bool finished = false;
+    auto run = [](std::vector<IoOperationTask>& operations
+        , std::vector<IoResult>& results, bool& finished) -> DetachedTask
+    {
+        results = co_await when_all(operations);
+        finished = true;
+    };
+    run(operations, results, finished);
+
+    // Complete in reverse order.
+    for (std::size_t i = k_count; i > 0; --i)
+    {
+        ASSERT_FALSE(finished);
+        io_port->post(PortEntry(WinDWORD(i - 1), 0, operations[i - 1].overlapped()), ec);
+        ASSERT_FALSE(ec);
+        ASSERT_EQ(1u, scheduler.poll_one());
+    }
+    ASSERT_TRUE(finished);
+    ASSERT_EQ(k_count, results.size());
+    for (std::size_t i = 0; i < k_count; ++i)
+    {
+        ASSERT_EQ(WinDWORD(i), results[i].entry.bytes_transferred);
+    }
+}
+
+TEST(WhenAll, Rethrows_First_Exception_Once_All_Finished)
+{
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+
+    IoOperationTask operation;
+    std::string error;
+    auto run = [](IoOperationTask& operation, std::string& error) -> DetachedTask
+    {
+        try
+        {
+            (void)co_await when_all(Throw("first"), operation, Throw("second"));
+        }
+        catch (const std::runtime_error& e)
+        {
+            error = e.what();
+        }
+    };
+    run(operation, error);
+    ASSERT_TRUE(error.empty());
+
+    io_port->post(PortEntry(0, 0, operation.overlapped()), ec);
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(1u, scheduler.poll());
+    ASSERT_EQ("first", error);
+}
+
+TEST(WhenAll, Many_Synchronously_Completed_Children_Do_Not_Suspend)
+{
+    constexpr std::size_t k_count = 10'000;
+    std::vector<Task<int>> tasks;
+    for (std::size_t i = 0; i < k_count; ++i)
+    {
+        tasks.push_back(Value(int(i)));
+    }
+    std::vector<int> results;
+    auto run = [](std::vector<Task<int>>& tasks, std::vector<int>& results) -> DetachedTask
+    {
+        results = co_await when_all(std::span<Task<int>>(tasks));
+    };
+    run(tasks, results);
+    ASSERT_EQ(k_count, results.size());
+    for (std::size_t i = 0; i < k_count; ++i)
+    {
+        ASSERT_EQ(int(i), results[i]);
+    }
+}
+
+TEST(WhenAny, Cancels_Losers_And_Returns_Winner)
+{
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+
+    std::vector<CancellableOperation> operations(3);
+    for (CancellableOperation& operation : operations)
+    {
+        operation.port = &*io_port;
+    }
+    WhenAnyResult<IoResult> result{};
+    bool finished = false;
+    auto run = [](std::vector<CancellableOperation>& operations
+        , WhenAnyResult<IoResult>& result, bool& finished) -> DetachedTask
+    {
+        result = co_await when_any(operations);
+        finished = true;
+    };
+    run(operations, result, finished);
+    ASSERT_FALSE(finished);
+
+    io_port->post(PortEntry(42, 0, operations[1].operation.overlapped()), ec);
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(1u, scheduler.poll_one());
+    // Resumed only once the losers are done.
+    ASSERT_FALSE(finished);
+    ASSERT_EQ(1u, operations[0].cancels);
+    ASSERT_EQ(0u, operations[1].cancels);
+    ASSERT_EQ(1u, operations[2].cancels);
+
+    ASSERT_EQ(2u, scheduler.poll());
+    ASSERT_TRUE(finished);
+    ASSERT_EQ(1u, result.index);
+    ASSERT_EQ(WinDWORD(42), result.value.entry.bytes_transferred);
+}
+
+TEST(WhenAny, Waits_For_Not_Cancellable_Losers)
+{
+    std::error_code ec;
+    auto io_port = IoCompletionPort::make(ec);
+    ASSERT_FALSE(ec);
+    IoScheduler scheduler(*io_port);
+
+    IoOperationTask operation;
+    std::variant<IoResult, int> result;
+    bool finished = false;
+    auto run = [](IoOperationTask& operation
+        , std::variant<IoResult, int>& result, bool& finished) -> DetachedTask
+    {
+        result = co_await when_any(operation, Value(5));
+        finished = true;
+    };
+    run(operation, result, finished);
+    ASSERT_FALSE(finished);
+
+    io_port->post(PortEntry(0, 0, operation.overlapped()), ec);
+    ASSERT_FALSE(ec);
+    ASSERT_EQ(1u, scheduler.poll());
+    ASSERT_TRUE(finished);
+    ASSERT_EQ(1u, result.index());
+    ASSERT_EQ(5, std::get<1>(result));
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <win_io_coro/detail/work_stealing_deque.h>
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+using namespace wi::coro::detail;
+
+namespace
+{
+
+    struct TestElement
+    {
+        std::atomic_int taken{0};
+    };
+
+} // namespace
+
+TEST(WorkStealingDeque, Owner_Pops_In_LIFO_Order_Thief_Steals_In_FIFO_Order)
+{
+    std::vector<TestElement> elements(3);
+    WorkStealingDeque<TestElement> deque;
+    ASSERT_TRUE(deque.is_empty());
+    for (auto& element : elements)
+    {
+        deque.push(&element);
+    }
+
+    TestElement* element = nullptr;
+    ASSERT_TRUE(deque.steal(element));
+    ASSERT_EQ(&elements[0], element);
+    ASSERT_TRUE(deque.pop(element));
+    ASSERT_EQ(&elements[2], element);
+    ASSERT_TRUE(deque.pop(element));
+    ASSERT_EQ(&elements[1], element);
+
+    ASSERT_FALSE(deque.pop(element));
+    ASSERT_FALSE(deque.steal(element));
+    ASSERT_TRUE(deque.is_empty());
+}
+
+TEST(WorkStealingDeque, Grows_When_Full_Keeping_Elements)
+{
+    constexpr std::size_t k_elements_count = 1000;
+    std::vector<TestElement> elements(k_elements_count);
+    WorkStealingDeque<TestElement> deque(2);
+    for (auto& element : elements)
+    {
+        deque.push(&element);
+    }
+
+    TestElement* element = nullptr;
+    ASSERT_TRUE(deque.steal(element));
+    ASSERT_EQ(&elements.front(), element);
+    for (std::size_t i = k_elements_count - 1; i > 0; --i)
+    {
+        ASSERT_TRUE(deque.pop(element));
+        ASSERT_EQ(&elements[i], element);
+    }
+    ASSERT_TRUE(deque.is_empty());
+}
+
+// Owner pushes (growing the deque) and pops while thieves steal.
+// Every element should be taken exactly once.
+TEST(WorkStealingDeque, Stress_Owner_And_Thieves_Take_Every_Element_Once)
+{
+    constexpr std::size_t k_thieves_count = 4;
+    constexpr std::size_t k_elements_count = 100'000;
+    std::vector<TestElement> elements(k_elements_count);
+    WorkStealingDeque<TestElement> deque(4);
+    std::atomic_size_t taken(0);
+    std::atomic_bool start(false);
+
+    std::vector<std::thread> thieves;
+    for (std::size_t i = 0; i < k_thieves_count; ++i)
+    {
+        thieves.emplace_back([&]()
+        {
+            while (!start)
+            {
+                std::this_thread::yield();
+            }
+            while (taken < k_elements_count)
+            {
+                TestElement* element = nullptr;
+                if (deque.steal(element))
+                {
+                    ++element->taken;
+                    ++taken;
+                }
+            }
+        });
+    }
+
+    start = true;
+    std::size_t pushed = 0;
+    while (pushed < k_elements_count)
+    {
+        // Push few, pop one: the deque is never empty for long.
+        for (std::size_t i = 0; (i < 3) && (pushed < k_elements_count); ++i)
+        {
+            deque.push(&elements[pushed++]);
+        }
+        TestElement* element = nullptr;
+        if (deque.pop(element))
+        {
+            ++element->taken;
+            ++taken;
+        }
+    }
+    TestElement* element = nullptr;
+    while (deque.pop(element))
+    {
+        ++element->taken;
+        ++taken;
+    }
+    for (auto& thief : thieves)
+    {
+        thief.join();
+    }
+
+    ASSERT_EQ(k_elements_count, taken);
+    ASSERT_TRUE(std::all_of(elements.begin(), elements.end()
+        , [](const TestElement& e) { return (e.taken == 1); }));
+}
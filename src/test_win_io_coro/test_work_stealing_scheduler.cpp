@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include <win_io_coro/work_stealing_scheduler.h>
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <set>
+
+using namespace wi::coro;
+
+namespace
+{
+
+    // Coroutine that starts immediately and destroys itself when finished.
+    struct FireAndForget
+    {
+        struct promise_type
+        {
+            FireAndForget get_return_object()
+            {
+                return {};
+            }
+
+            std::suspend_never initial_suspend()
+            {
+                return {};
+            }
+
+            std::suspend_never final_suspend() noexcept
+            {
+                return {};
+            }
+
+            void return_void()
+            {
+            }
+
+            void unhandled_exception()
+            {
+                std::terminate();
+            }
+        };
+    };
+
+    void WaitFor(const std::atomic_size_t& counter, std::size_t value)
+    {
+        while (counter.load() < value)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+} // namespace
+
+TEST(WorkStealingScheduler, Schedule_Continues_Coroutine_On_Worker_Thread)
+{
+    WorkStealingScheduler scheduler(2);
+    ASSERT_EQ(2u, scheduler.threads_count());
+    ASSERT_FALSE(scheduler.is_worker_thread());
+
+    std::atomic_size_t finished(0);
+    std::atomic_bool on_worker(false);
+    std::thread::id worker_id;
+    auto work = [&]() -> FireAndForget
+    {
+        co_await scheduler.schedule();
+        worker_id = std::this_thread::get_id();
+        on_worker = scheduler.is_worker_thread();
+        ++finished;
+    };
+    work();
+    WaitFor(finished, 1);
+
+    ASSERT_TRUE(on_worker);
+    ASSERT_NE(std::this_thread::get_id(), worker_id);
+}
+
+TEST(WorkStealingScheduler, Rescheduling_From_Worker_Stays_On_Some_Worker)
+{
+    constexpr std::size_t k_hops_count = 100;
+    WorkStealingScheduler scheduler(3);
+
+    std::atomic_size_t finished(0);
+    std::atomic_size_t off_worker(0);
+    auto work = [&]() -> FireAndForget
+    {
+        for (std::size_t i = 0; i < k_hops_count; ++i)
+        {
+            co_await scheduler.schedule();
+            if (!scheduler.is_worker_thread())
+            {
+                ++off_worker;
+            }
+        }
+        ++finished;
+    };
+    work();
+    WaitFor(finished, 1);
+
+    ASSERT_EQ(0u, off_worker);
+}
+
+// Many coroutines started from multiple outside threads, each hopping
+// through the scheduler, with nested coroutines spawned from workers
+// (pushed to the worker's own deque and stolen by idle ones).
+TEST(WorkStealingScheduler, Stress_Every_Coroutine_Is_Resumed_Once_Per_Schedule)
+{
+    constexpr std::size_t k_outside_threads_count = 4;
+    constexpr std::size_t k_coros_per_thread = 500;
+    constexpr std::size_t k_hops_count = 20;
+    constexpr std::size_t k_coros_count = k_outside_threads_count * k_coros_per_thread;
+    WorkStealingScheduler scheduler(4);
+
+    std::atomic_size_t hops(0);
+    std::atomic_size_t finished(0);
+    std::mutex threads_lock;
+    std::set<std::thread::id> worker_threads;
+
+    auto nested = [&]() -> FireAndForget
+    {
+        co_await scheduler.schedule();
+        ++hops;
+        ++finished;
+    };
+    auto work = [&]() -> FireAndForget
+    {
+        for (std::size_t i = 0; i < k_hops_count; ++i)
+        {
+            co_await scheduler.schedule();
+            ++hops;
+        }
+        {
+            std::lock_guard<std::mutex> lock(threads_lock);
+            worker_threads.insert(std::this_thread::get_id());
+        }
+        nested();
+        ++finished;
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < k_outside_threads_count; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            for (std::size_t j = 0; j < k_coros_per_thread; ++j)
+            {
+                work();
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    WaitFor(finished, 2 * k_coros_count);
+
+    ASSERT_EQ(2 * k_coros_count, finished);
+    ASSERT_EQ(k_coros_count * (k_hops_count + 1), hops);
+    std::lock_guard<std::mutex> lock(threads_lock);
+    ASSERT_LE(worker_threads.size(), std::size_t(scheduler.threads_count()));
+}
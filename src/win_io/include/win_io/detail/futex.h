@@ -0,0 +1,69 @@
+#pragma once
+#include <win_io/io_completion_port.h>
+
+#include <atomic>
+
+#include <cstdint>
+
+#if defined(_WIN32)
+// Needs Synchronization.lib.
+#  include <Windows.h>
+#else
+#  include <linux/futex.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#  include <cerrno>
+#  include <ctime>
+#endif
+
+namespace wi::detail
+{
+    // Blocks while `word` is equal to `expected`, at most `milliseconds`
+    // (kWaitInfinite to wait forever). Spurious wake-ups are possible.
+    // Returns false on time-out.
+    bool FutexWait(std::atomic<std::uint32_t>& word, std::uint32_t expected
+        , WinDWORD milliseconds);
+
+    // Wakes single thread blocked in FutexWait() on the `word`.
+    void FutexWakeOne(std::atomic<std::uint32_t>& word);
+} // namespace wi::detail
+
+namespace wi::detail
+{
+    static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t));
+
+#if defined(_WIN32)
+    inline bool FutexWait(std::atomic<std::uint32_t>& word, std::uint32_t expected
+        , WinDWORD milliseconds)
+    {
+        const BOOL ok = ::WaitOnAddress(&word, &expected, sizeof(expected), milliseconds);
+        return (ok || (::GetLastError() != ERROR_TIMEOUT));
+    }
+
+    inline void FutexWakeOne(std::atomic<std::uint32_t>& word)
+    {
+        ::WakeByAddressSingle(&word);
+    }
+#else
+    inline bool FutexWait(std::atomic<std::uint32_t>& word, std::uint32_t expected
+        , WinDWORD milliseconds)
+    {
+        struct timespec ts{};
+        struct timespec* timeout = nullptr;
+        if (milliseconds != kWaitInfinite)
+        {
+            ts.tv_sec = time_t(milliseconds / 1000);
+            ts.tv_nsec = long(milliseconds % 1000) * 1'000'000l;
+            timeout = &ts;
+        }
+        const long status = ::syscall(SYS_futex, &word, FUTEX_WAIT_PRIVATE
+            , expected, timeout, nullptr, 0);
+        return ((status == 0) || (errno != ETIMEDOUT));
+    }
+
+    inline void FutexWakeOne(std::atomic<std::uint32_t>& word)
+    {
+        (void)::syscall(SYS_futex, &word, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+    }
+#endif
+} // namespace wi::detail
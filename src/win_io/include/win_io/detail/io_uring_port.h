@@ -0,0 +1,431 @@
+#pragma once
+// Implementation detail of <win_io/io_completion_port.h>.
+// Do not include directly: expects `PortEntry` & friends to be declared.
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <span>
+#include <system_error>
+#include <utility>
+#include <atomic>
+
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace wi::detail
+{
+    // Minimal io_uring instance (no liburing dependency) that backs
+    // `IoCompletionPort` on Linux.
+    //
+    // Posted entries live in user-space FIFO; every post also submits
+    // IORING_OP_NOP so that threads blocked in ::io_uring_enter()
+    // wake up. NOP completions are tokens only: CQ ring is drained
+    // in batches from the shared memory without any syscall, one
+    // token per consumed entry.
+    //
+    // Safe to use from multiple threads: submission and
+    // reaping are serialized with separate locks, blocking wait
+    // is done outside of any lock.
+    class UringPort
+    {
+    public:
+        static UringPort* make(std::uint32_t entries, std::error_code& ec) noexcept;
+        ~UringPort();
+
+        UringPort(const UringPort&) = delete;
+        UringPort& operator=(const UringPort&) = delete;
+        UringPort(UringPort&&) = delete;
+        UringPort& operator=(UringPort&&) = delete;
+
+        // If NOP submission fails, `ec` is set, but the entry is queued
+        // anyway: it's delivered to the next waiter that wakes up, while
+        // already blocked waiters may not be woken up by it.
+        void post(const PortEntry& entry, std::error_code& ec);
+        // All entries are queued at once and NOPs for them are
+        // submitted with a single ::io_uring_enter() (if SQ has room).
+        std::size_t post_many(std::span<const PortEntry> entries, std::error_code& ec);
+
+        // `milliseconds` has same meaning as for ::GetQueuedCompletionStatusEx():
+        // 0 - do not block, kWaitInfinite - block until any entry is available.
+        std::span<PortEntry> wait_many(std::span<PortEntry> entries_to_write
+            , WinDWORD milliseconds
+            , std::error_code& ec);
+
+        int native_handle() const;
+
+    public:
+        static constexpr std::uint64_t kPostToken = 0;
+
+    private:
+        explicit UringPort() noexcept = default;
+        bool setup(std::uint32_t entries, std::error_code& ec);
+        void submit_nops(std::uint32_t count, std::error_code& ec);
+        std::size_t reap(std::span<PortEntry> entries_to_write);
+        bool enter_wait(WinDWORD milliseconds, std::error_code& ec);
+
+    private:
+        int ring_fd_ = -1;
+
+        void* sq_ring_ = nullptr;
+        std::size_t sq_ring_size_ = 0;
+        void* cq_ring_ = nullptr;
+        std::size_t cq_ring_size_ = 0;
+        io_uring_sqe* sqes_ = nullptr;
+        std::size_t sqes_size_ = 0;
+
+        std::uint32_t* sq_head_ = nullptr;
+        std::uint32_t* sq_tail_ = nullptr;
+        std::uint32_t* sq_array_ = nullptr;
+        std::uint32_t sq_mask_ = 0;
+        std::uint32_t sq_entries_ = 0;
+
+        std::uint32_t* cq_head_ = nullptr;
+        std::uint32_t* cq_tail_ = nullptr;
+        io_uring_cqe* cqes_ = nullptr;
+        std::uint32_t cq_mask_ = 0;
+
+        std::mutex sq_lock_;
+        std::mutex cq_lock_;
+        // Tokens that are still in-flight for already consumed entries.
+        std::uint64_t owed_tokens_ = 0;
+
+        std::mutex posted_lock_;
+        std::deque<PortEntry> posted_;
+    };
+} // namespace wi::detail
+
+namespace wi::detail
+{
+    inline int SysIoUringSetup(std::uint32_t entries, io_uring_params* params)
+    {
+        return int(::syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    inline int SysIoUringEnter(int fd, std::uint32_t to_submit, std::uint32_t min_complete
+        , std::uint32_t flags, const void* arg, std::size_t arg_size)
+    {
+        return int(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete
+            , flags, arg, arg_size));
+    }
+
+    template<typename T>
+    T* RingPtr(void* ring, std::uint32_t offset)
+    {
+        return reinterpret_cast<T*>(static_cast<std::uint8_t*>(ring) + offset);
+    }
+
+    inline std::uint32_t LoadAcquire(const std::uint32_t* ptr)
+    {
+        return std::atomic_ref<const std::uint32_t>(*ptr).load(std::memory_order_acquire);
+    }
+
+    inline void StoreRelease(std::uint32_t* ptr, std::uint32_t value)
+    {
+        std::atomic_ref<std::uint32_t>(*ptr).store(value, std::memory_order_release);
+    }
+
+    /*static*/ inline UringPort* UringPort::make(std::uint32_t entries, std::error_code& ec) noexcept
+    {
+        UringPort* port = new(std::nothrow) UringPort();
+        if (!port)
+        {
+            ec = std::make_error_code(std::errc::not_enough_memory);
+            return nullptr;
+        }
+        if (!port->setup(entries, ec))
+        {
+            delete port;
+            return nullptr;
+        }
+        return port;
+    }
+
+    inline bool UringPort::setup(std::uint32_t entries, std::error_code& ec)
+    {
+        io_uring_params params{};
+        // Posted entries may stay in CQ for a while; give more room
+        // for them than for submissions.
+        params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP;
+        params.cq_entries = entries * 16;
+        ring_fd_ = SysIoUringSetup(entries, &params);
+        if (ring_fd_ < 0)
+        {
+            ec = make_last_error_code();
+            return false;
+        }
+        if (!(params.features & IORING_FEAT_EXT_ARG)
+            || !(params.features & IORING_FEAT_NODROP))
+        {
+            // Kernel 5.11+ is required for waits with time-out.
+            ec = std::make_error_code(std::errc::not_supported);
+            return false;
+        }
+
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(std::uint32_t);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = !!(params.features & IORING_FEAT_SINGLE_MMAP);
+        if (single_mmap)
+        {
+            sq_ring_size_ = (std::max)(sq_ring_size_, cq_ring_size_);
+            cq_ring_size_ = sq_ring_size_;
+        }
+
+        sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE
+            , MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+        if (sq_ring_ == MAP_FAILED)
+        {
+            sq_ring_ = nullptr;
+            ec = make_last_error_code();
+            return false;
+        }
+        if (single_mmap)
+        {
+            cq_ring_ = sq_ring_;
+        }
+        else
+        {
+            cq_ring_ = ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE
+                , MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+            if (cq_ring_ == MAP_FAILED)
+            {
+                cq_ring_ = nullptr;
+                ec = make_last_error_code();
+                return false;
+            }
+        }
+
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE
+            , MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED)
+        {
+            ec = make_last_error_code();
+            return false;
+        }
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+        sq_head_ = RingPtr<std::uint32_t>(sq_ring_, params.sq_off.head);
+        sq_tail_ = RingPtr<std::uint32_t>(sq_ring_, params.sq_off.tail);
+        sq_array_ = RingPtr<std::uint32_t>(sq_ring_, params.sq_off.array);
+        sq_mask_ = *RingPtr<std::uint32_t>(sq_ring_, params.sq_off.ring_mask);
+        sq_entries_ = *RingPtr<std::uint32_t>(sq_ring_, params.sq_off.ring_entries);
+
+        cq_head_ = RingPtr<std::uint32_t>(cq_ring_, params.cq_off.head);
+        cq_tail_ = RingPtr<std::uint32_t>(cq_ring_, params.cq_off.tail);
+        cq_mask_ = *RingPtr<std::uint32_t>(cq_ring_, params.cq_off.ring_mask);
+        cqes_ = RingPtr<io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+
+        ec = std::error_code();
+        return true;
+    }
+
+    inline UringPort::~UringPort()
+    {
+        if (sqes_)
+        {
+            (void)::munmap(sqes_, sqes_size_);
+        }
+        if (cq_ring_ && (cq_ring_ != sq_ring_))
+        {
+            (void)::munmap(cq_ring_, cq_ring_size_);
+        }
+        if (sq_ring_)
+        {
+            (void)::munmap(sq_ring_, sq_ring_size_);
+        }
+        if (ring_fd_ >= 0)
+        {
+            [[maybe_unused]] const int error = ::close(ring_fd_);
+            assert((error == 0) && "[Io] ::close() on io_uring failed");
+        }
+    }
+
+    inline int UringPort::native_handle() const
+    {
+        return ring_fd_;
+    }
+
+    inline void UringPort::post(const PortEntry& entry, std::error_code& ec)
+    {
+        {
+            std::lock_guard _(posted_lock_);
+            posted_.push_back(entry);
+        }
+        // Same as post_many(): the entry is already visible to reap()
+        // and can't be taken back (its NOP may be in SQ already).
+        // Unsubmitted NOPs are submitted by the next post.
+        submit_nops(1, ec);
+    }
+
+    inline std::size_t UringPort::post_many(std::span<const PortEntry> entries, std::error_code& ec)
+    {
+        ec = std::error_code();
+        if (entries.empty())
+        {
+            return 0;
+        }
+        {
+            std::lock_guard _(posted_lock_);
+            posted_.insert(posted_.end(), entries.begin(), entries.end());
+        }
+        // Entries are already visible to reap(); even if submission
+        // fails, they are delivered to the next waiter that wakes up.
+        submit_nops(std::uint32_t(entries.size()), ec);
+        return entries.size();
+    }
+
+    inline void UringPort::submit_nops(std::uint32_t count, std::error_code& ec)
+    {
+        ec = std::error_code();
+        std::lock_guard _(sq_lock_);
+        // SQEs are written once per token: after EINTR, short submit
+        // or earlier failed call, SQEs still in SQ (between kernel's head
+        // and our tail) are re-submitted, not written again; otherwise
+        // there would be CQEs without posted entry.
+        while (true)
+        {
+            const std::uint32_t head = LoadAcquire(sq_head_);
+            std::uint32_t tail = *sq_tail_;
+            const std::uint32_t available = sq_entries_ - (tail - head);
+            const std::uint32_t batch = (std::min)(count, available);
+            for (std::uint32_t i = 0; i < batch; ++i)
+            {
+                const std::uint32_t index = (tail & sq_mask_);
+                io_uring_sqe& sqe = sqes_[index];
+                std::memset(&sqe, 0, sizeof(sqe));
+                sqe.opcode = IORING_OP_NOP;
+                sqe.fd = -1;
+                sqe.user_data = kPostToken;
+                sq_array_[index] = index;
+                ++tail;
+            }
+            StoreRelease(sq_tail_, tail);
+            count -= batch;
+
+            const std::uint32_t pending = (tail - head);
+            if (pending == 0)
+            {
+                // SQ is empty (never full then): all written and submitted.
+                assert(count == 0);
+                return;
+            }
+            const int submitted = SysIoUringEnter(ring_fd_, pending, 0, 0, nullptr, 0);
+            if ((submitted < 0) && (errno != EINTR))
+            {
+                ec = make_last_error_code();
+                return;
+            }
+        }
+    }
+
+    inline std::size_t UringPort::reap(std::span<PortEntry> entries_to_write)
+    {
+        std::size_t count = 0;
+        {
+            std::lock_guard _(posted_lock_);
+            count = (std::min)(entries_to_write.size(), posted_.size());
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                entries_to_write[i] = posted_.front();
+                posted_.pop_front();
+            }
+        }
+
+        owed_tokens_ += count;
+        std::uint32_t head = *cq_head_;
+        const std::uint32_t tail = LoadAcquire(cq_tail_);
+        while ((owed_tokens_ > 0) && (head != tail))
+        {
+            [[maybe_unused]] const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+            assert((cqe.user_data == kPostToken) && "[Io] Only posted entries are supported");
+            ++head;
+            --owed_tokens_;
+        }
+        StoreRelease(cq_head_, head);
+        return count;
+    }
+
+    inline bool UringPort::enter_wait(WinDWORD milliseconds, std::error_code& ec)
+    {
+        __kernel_timespec ts{};
+        io_uring_getevents_arg arg{};
+        if (milliseconds != kWaitInfinite)
+        {
+            ts.tv_sec = (milliseconds / 1000);
+            ts.tv_nsec = (milliseconds % 1000) * 1'000'000ll;
+            arg.ts = reinterpret_cast<std::uint64_t>(&ts);
+        }
+
+        const int status = SysIoUringEnter(ring_fd_, 0, 1
+            , IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG
+            , &arg, sizeof(arg));
+        if (status >= 0)
+        {
+            return true;
+        }
+        if ((errno == EINTR) || (errno == EAGAIN) || (errno == EBUSY))
+        {
+            return true;
+        }
+        if (errno == ETIME)
+        {
+            ec = make_timeout_error_code();
+            return false;
+        }
+        ec = make_last_error_code();
+        return false;
+    }
+
+    inline std::span<PortEntry> UringPort::wait_many(std::span<PortEntry> entries_to_write
+        , WinDWORD milliseconds
+        , std::error_code& ec)
+    {
+        using Clock = std::chrono::steady_clock;
+        const auto deadline = Clock::now() + std::chrono::milliseconds(milliseconds);
+        ec = std::error_code();
+        while (true)
+        {
+            std::size_t count = 0;
+            {
+                std::lock_guard _(cq_lock_);
+                count = reap(entries_to_write);
+            }
+            if (count > 0)
+            {
+                return entries_to_write.first(count);
+            }
+            if (milliseconds == 0)
+            {
+                ec = make_timeout_error_code();
+                return entries_to_write.first(0);
+            }
+
+            WinDWORD wait_ms = kWaitInfinite;
+            if (milliseconds != kWaitInfinite)
+            {
+                const auto now = Clock::now();
+                if (now >= deadline)
+                {
+                    ec = make_timeout_error_code();
+                    return entries_to_write.first(0);
+                }
+                const auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - now);
+                wait_ms = WinDWORD(left.count());
+            }
+            if (!enter_wait(wait_ms, ec))
+            {
+                return entries_to_write.first(0);
+            }
+        }
+    }
+} // namespace wi::detail
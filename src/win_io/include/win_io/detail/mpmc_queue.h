@@ -0,0 +1,283 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace wi::detail
+{
+    // Assume 64 bytes when compiler does not know better.
+    // (std::hardware_destructive_interference_size triggers
+    // ABI warnings on GCC).
+    constexpr std::size_t kCacheLineSize = 64;
+
+    // Bounded, lock-free multi-producer/multi-consumer queue.
+    // Dmitry Vyukov's algorithm: every cell has a sequence number
+    // that tells whether the cell is ready to be written or read
+    // on the current lap. See
+    // https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue.
+    //
+    // Memory is allocated once, in the constructor.
+    // Capacity is rounded up to the power of 2.
+    //
+    // try_push() may fail even if the queue is not full: while a consumer
+    // that took the cell on the previous lap is preempted before releasing
+    // it. Callers should retry (or handle it as "full").
+    template<typename T>
+    class MPMCQueue
+    {
+    public:
+        static_assert(std::is_nothrow_copy_assignable_v<T>
+            , "T is copied into/from cells with no way to report an error");
+
+        explicit MPMCQueue(std::size_t capacity);
+        MPMCQueue(const MPMCQueue&) = delete;
+        MPMCQueue& operator=(const MPMCQueue&) = delete;
+        MPMCQueue(MPMCQueue&&) = delete;
+        MPMCQueue& operator=(MPMCQueue&&) = delete;
+
+        bool try_push(const T& value) noexcept;
+        bool try_pop(T& value) noexcept;
+
+        // Batch versions: take consecutive cells with single CAS.
+        // Push/pop as many elements as there are ready cells, in order;
+        // return the count (0 when full/empty).
+        std::size_t try_push_many(std::span<const T> values) noexcept;
+        std::size_t try_pop_many(std::span<T> values) noexcept;
+
+        // Approximate: may be stale once returned.
+        bool is_empty() const noexcept;
+        std::size_t capacity() const noexcept;
+
+    private:
+        struct Cell
+        {
+            std::atomic<std::size_t> sequence;
+            T data;
+        };
+
+        // Number of cells, starting from `pos`, with `sequence` equal to
+        // `pos + i + offset`, up to `max_count`.
+        std::size_t count_ready(std::size_t pos, std::size_t offset, std::size_t max_count) const noexcept;
+
+        std::unique_ptr<Cell[]> cells_;
+        std::size_t mask_;
+        // Separate cache lines to avoid false sharing
+        // between producers and consumers.
+        alignas(kCacheLineSize) std::atomic<std::size_t> enqueue_pos_;
+        alignas(kCacheLineSize) std::atomic<std::size_t> dequeue_pos_;
+    };
+} // namespace wi::detail
+
+namespace wi::detail
+{
+    inline std::size_t RoundUpToPowerOf2(std::size_t value)
+    {
+        std::size_t power = 1;
+        while (power < value)
+        {
+            power <<= 1;
+        }
+        return power;
+    }
+
+    template<typename T>
+    /*explicit*/ MPMCQueue<T>::MPMCQueue(std::size_t capacity)
+        : cells_(new Cell[RoundUpToPowerOf2((capacity < 2) ? 2 : capacity)])
+        , mask_(RoundUpToPowerOf2((capacity < 2) ? 2 : capacity) - 1)
+        , enqueue_pos_(0)
+        , dequeue_pos_(0)
+    {
+        for (std::size_t i = 0; i <= mask_; ++i)
+        {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    template<typename T>
+    bool MPMCQueue<T>::try_push(const T& value) noexcept
+    {
+        std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        while (true)
+        {
+            cell = &cells_[pos & mask_];
+            const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = std::intptr_t(sequence) - std::intptr_t(pos);
+            if (diff == 0)
+            {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1
+                    , std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                // Full.
+                return false;
+            }
+            else
+            {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    template<typename T>
+    bool MPMCQueue<T>::try_pop(T& value) noexcept
+    {
+        std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        while (true)
+        {
+            cell = &cells_[pos & mask_];
+            const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = std::intptr_t(sequence) - std::intptr_t(pos + 1);
+            if (diff == 0)
+            {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1
+                    , std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                // Empty.
+                return false;
+            }
+            else
+            {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        value = cell->data;
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    template<typename T>
+    std::size_t MPMCQueue<T>::count_ready(std::size_t pos
+        , std::size_t offset
+        , std::size_t max_count) const noexcept
+    {
+        max_count = (std::min)(max_count, mask_ + 1);
+        std::size_t count = 0;
+        for (; count < max_count; ++count)
+        {
+            const Cell& cell = cells_[(pos + count) & mask_];
+            if (cell.sequence.load(std::memory_order_acquire) != (pos + count + offset))
+            {
+                break;
+            }
+        }
+        return count;
+    }
+
+    template<typename T>
+    std::size_t MPMCQueue<T>::try_push_many(std::span<const T> values) noexcept
+    {
+        // Cells that are ready can't be changed by anyone, but
+        // the thread that takes them by moving `enqueue_pos_`.
+        if (values.empty())
+        {
+            return 0;
+        }
+        std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        std::size_t count = 0;
+        while (true)
+        {
+            count = count_ready(pos, 0, values.size());
+            if (count == 0)
+            {
+                const std::size_t sequence = cells_[pos & mask_].sequence.load(std::memory_order_acquire);
+                if ((std::intptr_t(sequence) - std::intptr_t(pos)) < 0)
+                {
+                    // Full.
+                    return 0;
+                }
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + count
+                , std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            Cell& cell = cells_[(pos + i) & mask_];
+            cell.data = values[i];
+            cell.sequence.store(pos + i + 1, std::memory_order_release);
+        }
+        return count;
+    }
+
+    template<typename T>
+    std::size_t MPMCQueue<T>::try_pop_many(std::span<T> values) noexcept
+    {
+        if (values.empty())
+        {
+            return 0;
+        }
+        std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        std::size_t count = 0;
+        while (true)
+        {
+            count = count_ready(pos, 1, values.size());
+            if (count == 0)
+            {
+                const std::size_t sequence = cells_[pos & mask_].sequence.load(std::memory_order_acquire);
+                if ((std::intptr_t(sequence) - std::intptr_t(pos + 1)) < 0)
+                {
+                    // Empty.
+                    return 0;
+                }
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (dequeue_pos_.compare_exchange_weak(pos, pos + count
+                , std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            Cell& cell = cells_[(pos + i) & mask_];
+            values[i] = cell.data;
+            cell.sequence.store(pos + i + mask_ + 1, std::memory_order_release);
+        }
+        return count;
+    }
+
+    template<typename T>
+    bool MPMCQueue<T>::is_empty() const noexcept
+    {
+        const std::size_t dequeue_pos = dequeue_pos_.load(std::memory_order_seq_cst);
+        const std::size_t enqueue_pos = enqueue_pos_.load(std::memory_order_seq_cst);
+        return (enqueue_pos == dequeue_pos);
+    }
+
+    template<typename T>
+    std::size_t MPMCQueue<T>::capacity() const noexcept
+    {
+        return (mask_ + 1);
+    }
+} // namespace wi::detail
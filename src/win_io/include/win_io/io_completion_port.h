@@ -1,9 +1,12 @@
 #pragma once
+#include <win_io/spin_wait_policy.h>
+
 #include <chrono>
 #include <optional>
 #include <system_error> // std::error_code.
 #include <span>
 
+#include <cstddef> // std::size_t.
 #include <cstdint> // std::[u]int*_t.
 
 namespace wi
@@ -51,6 +54,9 @@ namespace wi
 
 namespace wi::detail
 {
+    // Same as INFINITE from Windows.h.
+    constexpr WinDWORD kWaitInfinite = 0xFFFFFFFF;
+
     WinDWORD GetLastWinError();
 
     inline std::error_code make_last_error_code(
@@ -61,6 +67,9 @@ namespace wi::detail
         // if using together with `std::system_error`.
         return std::error_code(static_cast<int>(last_error), std::system_category());
     }
+
+    // Same error as reported by the port when wait time-out expires.
+    std::error_code make_timeout_error_code();
 } // namespace wi
 
 namespace wi
@@ -86,9 +95,19 @@ namespace wi
     }
 } // namespace wi
 
+#if !defined(_WIN32)
+namespace wi::detail
+{
+    class UringPort;
+} // namespace wi::detail
+#endif
+
+#include <win_io/port_stats.h>
+
 namespace wi
 {
     // Low-level wrapper around Windows I/O Completion Port.
+    // On Linux, io_uring is used instead, see detail::UringPort.
     class IoCompletionPort
     {
     public:
@@ -104,8 +123,15 @@ namespace wi
         IoCompletionPort& operator=(IoCompletionPort&& rhs) noexcept;
         ~IoCompletionPort();
 
+        // On Linux, error means the entry is queued, but blocked
+        // waiters may not be woken up (see UringPort::post()).
         void post(const PortEntry& data, std::error_code& ec);
 
+        // Posts all `entries`, in order, at once. Wakes up no more
+        // waiters than there are entries.
+        // Returns number of entries posted; on error, the rest is not posted.
+        std::size_t post_many(std::span<const PortEntry> entries, std::error_code& ec);
+
         // Blocking call.
         // It's possible to have valid data, but still receive some `error_code`.
         // See https://xania.org/200807/iocp article for possible
@@ -116,6 +142,13 @@ namespace wi
             , std::error_code& ec
             , bool alertable = false);
 
+        // Busy-polls first, blocks only if nothing arrives in time.
+        // See AdaptiveSpinWait.
+        std::span<PortEntry> get_many(std::span<PortEntry> entries_to_write
+            , AdaptiveSpinWait& spin
+            , std::error_code& ec
+            , bool alertable = false);
+
         // Non-blocking call.
         std::optional<PortEntry> query(std::error_code& ec);
 
@@ -134,26 +167,65 @@ namespace wi
             , std::error_code& ec
             , bool alertable = false);
 
+        template<typename Rep, typename Period>
+        std::span<PortEntry> wait_for_many(std::span<PortEntry> entries_to_write
+            , std::chrono::duration<Rep, Period> time
+            , AdaptiveSpinWait& spin
+            , std::error_code& ec
+            , bool alertable = false);
+
+        // Windows only. On Linux, the port delivers posted entries only:
+        // association fails with std::errc::operation_not_supported.
         void associate_device(WinHANDLE device, WinULONG_PTR key
             , std::error_code& ec);
 
         void associate_socket(WinSOCKET socket, WinULONG_PTR key
             , std::error_code& ec);
 
+        // IOCP HANDLE on Windows, io_uring file descriptor on Linux.
         WinHANDLE native_handle();
 
+        // Opt-in instrumentation: once set, posts and waits are counted
+        // into `stats` (nullptr to stop). `stats` must outlive the port
+        // or be detached; set it before the port is used by other threads.
+        // Same PortStats can be shared by multiple ports.
+        void set_stats(PortStats* stats) noexcept;
+        PortStats* stats() const noexcept;
+
     private:
+        // Non-counting query/wait for AdaptiveSpinWait, so spin polls
+        // are not counted as separate waits, see spin_wait_many_impl().
+        struct NativeWaits;
+
         std::optional<PortEntry> wait_impl(WinDWORD milliseconds, std::error_code& ec);
         std::span<PortEntry> wait_many_impl(std::span<PortEntry> entries_to_write
             , WinDWORD milliseconds
             , bool alertable
             , std::error_code& ec);
+        // Counted as single wait, however many polls it takes.
+        std::span<PortEntry> spin_wait_many_impl(std::span<PortEntry> entries_to_write
+            , WinDWORD milliseconds
+            , AdaptiveSpinWait& spin
+            , bool alertable
+            , std::error_code& ec);
+        void native_post(const PortEntry& data, std::error_code& ec);
+        std::size_t native_post_many(std::span<const PortEntry> entries, std::error_code& ec);
+        std::optional<PortEntry> native_wait(WinDWORD milliseconds, std::error_code& ec);
+        std::span<PortEntry> native_wait_many(std::span<PortEntry> entries_to_write
+            , WinDWORD milliseconds
+            , bool alertable
+            , std::error_code& ec);
         void associate_with_impl(WinHANDLE device, WinULONG_PTR key
             , std::error_code& ec);
         void close() noexcept;
 
     private:
+#if defined(_WIN32)
         WinHANDLE io_port_ = nullptr;
+#else
+        detail::UringPort* io_port_ = nullptr;
+#endif
+        PortStats* stats_ = nullptr;
     };
 } // namespace wi
 
@@ -176,6 +248,17 @@ namespace wi
         const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(time);
         return wait_many_impl(entries_to_write, static_cast<WinDWORD>(ms.count()), alertable, ec);
     }
+
+    template<typename Rep, typename Period>
+    std::span<PortEntry> IoCompletionPort::wait_for_many(std::span<PortEntry> entries_to_write
+        , std::chrono::duration<Rep, Period> time
+        , AdaptiveSpinWait& spin
+        , std::error_code& ec
+        , bool alertable /*= false*/)
+    {
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(time);
+        return spin_wait_many_impl(entries_to_write, static_cast<WinDWORD>(ms.count()), spin, alertable, ec);
+    }
 } // namespace wi
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -185,6 +268,7 @@ namespace wi
 
 #include <cassert>
 
+#if defined(_WIN32)
 #include <Windows.h>
 
 namespace wi
@@ -193,6 +277,7 @@ namespace wi
         , "Mismatch in OVERLAPPED size detected.");
     static_assert(alignof(WinOVERLAPPED) == alignof(OVERLAPPED)
         , "Mismatch in OVERLAPPED align detected.");
+    static_assert(detail::kWaitInfinite == INFINITE);
 } // namespace wi
 
 namespace wi::detail
@@ -201,16 +286,15 @@ namespace wi::detail
     {
         return ::GetLastError();
     }
-}
 
-namespace wi
-{
-    /*static*/ inline std::optional<IoCompletionPort> IoCompletionPort::make(std::error_code& ec) noexcept
+    inline std::error_code make_timeout_error_code()
     {
-        // As many concurrently running threads as there are processors in the system.
-        return make(0, ec);
+        return make_last_error_code(WAIT_TIMEOUT);
     }
+}
 
+namespace wi
+{
     /*static*/ inline std::optional<IoCompletionPort> IoCompletionPort::make(std::uint32_t concurrent_threads_hint
         , std::error_code& ec) noexcept
     {
@@ -230,26 +314,6 @@ namespace wi
         return value;
     }
 
-    inline IoCompletionPort::IoCompletionPort(IoCompletionPort&& rhs) noexcept
-        : io_port_(std::exchange(rhs.io_port_, nullptr))
-    {
-    }
-
-    inline IoCompletionPort& IoCompletionPort::operator=(IoCompletionPort&& rhs) noexcept
-    {
-        if (this != &rhs)
-        {
-            close();
-            io_port_ = std::exchange(rhs.io_port_, nullptr);
-        }
-        return *this;
-    }
-
-    inline IoCompletionPort::~IoCompletionPort()
-    {
-        close();
-    }
-
     inline void IoCompletionPort::close() noexcept
     {
         if (io_port_)
@@ -260,7 +324,7 @@ namespace wi
         }
     }
 
-    inline void IoCompletionPort::post(const PortEntry& data, std::error_code& ec)
+    inline void IoCompletionPort::native_post(const PortEntry& data, std::error_code& ec)
     {
         ec = std::error_code();
         const BOOL ok = ::PostQueuedCompletionStatus(io_port_
@@ -273,43 +337,28 @@ namespace wi
         }
     }
 
-    inline std::optional<PortEntry> IoCompletionPort::get(std::error_code& ec)
+    inline std::size_t IoCompletionPort::native_post_many(std::span<const PortEntry> entries, std::error_code& ec)
     {
-        return wait_impl(INFINITE, ec);
-    }
-
-    inline std::span<PortEntry> IoCompletionPort::get_many(std::span<PortEntry> entries_to_write
-        , std::error_code& ec
-        , bool alertable /*= false*/)
-    {
-        return wait_many_impl(entries_to_write, INFINITE, alertable, ec);
-    }
-
-    inline std::optional<PortEntry> IoCompletionPort::query(std::error_code& ec)
-    {
-        return wait_impl(0/*no blocking wait*/, ec);
-    }
-
-    inline std::span<PortEntry> IoCompletionPort::query_many(std::span<PortEntry> entries_to_write
-        , std::error_code& ec
-        , bool alertable /*= false*/)
-    {
-        return wait_many_impl(entries_to_write, 0/*no blocking wait*/, alertable, ec);
-    }
-
-    inline void IoCompletionPort::associate_device(WinHANDLE device, WinULONG_PTR key
-        , std::error_code& ec)
-    {
-        associate_with_impl(device, key, ec);
-    }
-
-    inline void IoCompletionPort::associate_socket(WinSOCKET socket, WinULONG_PTR key
-        , std::error_code& ec)
-    {
-        associate_with_impl(socket, key, ec);
+        // #XXX: there is no batched ::PostQueuedCompletionStatus();
+        // each call wakes up at most one waiter.
+        ec = std::error_code();
+        for (std::size_t i = 0; i < entries.size(); ++i)
+        {
+            const PortEntry& data = entries[i];
+            const BOOL ok = ::PostQueuedCompletionStatus(io_port_
+                , data.bytes_transferred
+                , data.completion_key
+                , static_cast<LPOVERLAPPED>(data.overlapped));
+            if (!ok)
+            {
+                ec = detail::make_last_error_code();
+                return i;
+            }
+        }
+        return entries.size();
     }
 
-    inline std::optional<PortEntry> IoCompletionPort::wait_impl(
+    inline std::optional<PortEntry> IoCompletionPort::native_wait(
         WinDWORD milliseconds, std::error_code& ec)
     {
         DWORD bytes_transferred = 0;
@@ -337,7 +386,7 @@ namespace wi
         return std::nullopt;
     }
 
-    inline std::span<PortEntry> IoCompletionPort::wait_many_impl(std::span<PortEntry> entries_to_write
+    inline std::span<PortEntry> IoCompletionPort::native_wait_many(std::span<PortEntry> entries_to_write
         , WinDWORD milliseconds
         , bool alertable
         , std::error_code& ec)
@@ -385,3 +434,271 @@ namespace wi
         return io_port_;
     }
 } // namespace wi
+#else // Linux, io_uring.
+#include <cerrno>
+
+#include <win_io/detail/io_uring_port.h>
+
+namespace wi::detail
+{
+    inline WinDWORD GetLastWinError()
+    {
+        return WinDWORD(errno);
+    }
+
+    inline std::error_code make_timeout_error_code()
+    {
+        return make_last_error_code(ETIMEDOUT);
+    }
+
+    // Submission queue size. Completion queue is bigger, see UringPort::setup().
+    constexpr std::uint32_t kUringEntries = 256;
+}
+
+namespace wi
+{
+    /*static*/ inline std::optional<IoCompletionPort> IoCompletionPort::make(std::uint32_t concurrent_threads_hint
+        , std::error_code& ec) noexcept
+    {
+        // #XXX: io_uring has no notion of concurrency limit.
+        (void)concurrent_threads_hint;
+        std::optional<IoCompletionPort> value;
+
+        IoCompletionPort& o = value.emplace();
+        o.io_port_ = detail::UringPort::make(detail::kUringEntries, ec);
+        if (o.io_port_ == nullptr)
+        {
+            return std::nullopt;
+        }
+
+        return value;
+    }
+
+    inline void IoCompletionPort::close() noexcept
+    {
+        delete std::exchange(io_port_, nullptr);
+    }
+
+    inline void IoCompletionPort::native_post(const PortEntry& data, std::error_code& ec)
+    {
+        io_port_->post(data, ec);
+    }
+
+    inline std::size_t IoCompletionPort::native_post_many(std::span<const PortEntry> entries, std::error_code& ec)
+    {
+        return io_port_->post_many(entries, ec);
+    }
+
+    inline std::optional<PortEntry> IoCompletionPort::native_wait(
+        WinDWORD milliseconds, std::error_code& ec)
+    {
+        PortEntry data;
+        if (io_port_->wait_many(std::span<PortEntry>(&data, 1), milliseconds, ec).empty())
+        {
+            return std::nullopt;
+        }
+        return data;
+    }
+
+    inline std::span<PortEntry> IoCompletionPort::native_wait_many(std::span<PortEntry> entries_to_write
+        , WinDWORD milliseconds
+        , bool alertable
+        , std::error_code& ec)
+    {
+        // No APCs on Linux.
+        (void)alertable;
+        return io_port_->wait_many(entries_to_write, milliseconds, ec);
+    }
+
+    inline void IoCompletionPort::associate_with_impl(
+        WinHANDLE device, WinULONG_PTR key, std::error_code& ec)
+    {
+        // Posted entries only: there is no association with io_uring.
+        (void)device;
+        (void)key;
+        ec = std::make_error_code(std::errc::operation_not_supported);
+    }
+
+    inline WinHANDLE IoCompletionPort::native_handle()
+    {
+        if (!io_port_)
+        {
+            return nullptr;
+        }
+        return reinterpret_cast<WinHANDLE>(std::intptr_t(io_port_->native_handle()));
+    }
+} // namespace wi
+#endif
+
+namespace wi
+{
+    /*static*/ inline std::optional<IoCompletionPort> IoCompletionPort::make(std::error_code& ec) noexcept
+    {
+        // As many concurrently running threads as there are processors in the system.
+        return make(0, ec);
+    }
+
+    inline IoCompletionPort::IoCompletionPort(IoCompletionPort&& rhs) noexcept
+        : io_port_(std::exchange(rhs.io_port_, nullptr))
+        , stats_(std::exchange(rhs.stats_, nullptr))
+    {
+    }
+
+    inline IoCompletionPort& IoCompletionPort::operator=(IoCompletionPort&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            close();
+            io_port_ = std::exchange(rhs.io_port_, nullptr);
+            stats_ = std::exchange(rhs.stats_, nullptr);
+        }
+        return *this;
+    }
+
+    inline void IoCompletionPort::set_stats(PortStats* stats) noexcept
+    {
+        stats_ = stats;
+    }
+
+    inline PortStats* IoCompletionPort::stats() const noexcept
+    {
+        return stats_;
+    }
+
+    inline void IoCompletionPort::post(const PortEntry& data, std::error_code& ec)
+    {
+        native_post(data, ec);
+        if (stats_)
+        {
+            stats_->on_posted(ec ? 0 : 1, ec);
+        }
+    }
+
+    inline std::size_t IoCompletionPort::post_many(std::span<const PortEntry> entries, std::error_code& ec)
+    {
+        const std::size_t posted = native_post_many(entries, ec);
+        if (stats_)
+        {
+            stats_->on_posted(posted, ec);
+        }
+        return posted;
+    }
+
+    inline std::optional<PortEntry> IoCompletionPort::wait_impl(
+        WinDWORD milliseconds, std::error_code& ec)
+    {
+        if (!stats_)
+        {
+            return native_wait(milliseconds, ec);
+        }
+        const PortStats::Clock::time_point start = stats_->on_wait_start();
+        std::optional<PortEntry> data = native_wait(milliseconds, ec);
+        stats_->on_waited(start
+            , data ? std::span<const PortEntry>(&*data, 1) : std::span<const PortEntry>()
+            , ec);
+        return data;
+    }
+
+    inline std::span<PortEntry> IoCompletionPort::wait_many_impl(std::span<PortEntry> entries_to_write
+        , WinDWORD milliseconds
+        , bool alertable
+        , std::error_code& ec)
+    {
+        if (!stats_)
+        {
+            return native_wait_many(entries_to_write, milliseconds, alertable, ec);
+        }
+        const PortStats::Clock::time_point start = stats_->on_wait_start();
+        std::span<PortEntry> ready = native_wait_many(entries_to_write, milliseconds, alertable, ec);
+        stats_->on_waited(start, ready, ec);
+        return ready;
+    }
+
+    struct IoCompletionPort::NativeWaits
+    {
+        IoCompletionPort& port;
+
+        std::span<PortEntry> query_many(std::span<PortEntry> entries_to_write
+            , std::error_code& ec
+            , bool alertable)
+        {
+            return port.native_wait_many(entries_to_write, 0/*no blocking wait*/, alertable, ec);
+        }
+
+        template<typename Rep, typename Period>
+        std::span<PortEntry> wait_for_many(std::span<PortEntry> entries_to_write
+            , std::chrono::duration<Rep, Period> time
+            , std::error_code& ec
+            , bool alertable)
+        {
+            const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(time);
+            return port.native_wait_many(entries_to_write, static_cast<WinDWORD>(ms.count()), alertable, ec);
+        }
+    };
+
+    inline std::span<PortEntry> IoCompletionPort::spin_wait_many_impl(std::span<PortEntry> entries_to_write
+        , WinDWORD milliseconds
+        , AdaptiveSpinWait& spin
+        , bool alertable
+        , std::error_code& ec)
+    {
+        NativeWaits native{*this};
+        if (!stats_)
+        {
+            return spin.wait_many(native, entries_to_write, milliseconds, alertable, ec);
+        }
+        const PortStats::Clock::time_point start = stats_->on_wait_start();
+        std::span<PortEntry> ready = spin.wait_many(native, entries_to_write, milliseconds, alertable, ec);
+        stats_->on_waited(start, ready, ec);
+        return ready;
+    }
+
+    inline IoCompletionPort::~IoCompletionPort()
+    {
+        close();
+    }
+
+    inline std::optional<PortEntry> IoCompletionPort::get(std::error_code& ec)
+    {
+        return wait_impl(detail::kWaitInfinite, ec);
+    }
+
+    inline std::span<PortEntry> IoCompletionPort::get_many(std::span<PortEntry> entries_to_write
+        , std::error_code& ec
+        , bool alertable /*= false*/)
+    {
+        return wait_many_impl(entries_to_write, detail::kWaitInfinite, alertable, ec);
+    }
+
+    inline std::span<PortEntry> IoCompletionPort::get_many(std::span<PortEntry> entries_to_write
+        , AdaptiveSpinWait& spin
+        , std::error_code& ec
+        , bool alertable /*= false*/)
+    {
+        return spin_wait_many_impl(entries_to_write, detail::kWaitInfinite, spin, alertable, ec);
+    }
+
+    inline std::optional<PortEntry> IoCompletionPort::query(std::error_code& ec)
+    {
+        return wait_impl(0/*no blocking wait*/, ec);
+    }
+
+    inline std::span<PortEntry> IoCompletionPort::query_many(std::span<PortEntry> entries_to_write
+        , std::error_code& ec
+        , bool alertable /*= false*/)
+    {
+        return wait_many_impl(entries_to_write, 0/*no blocking wait*/, alertable, ec);
+    }
+
+    inline void IoCompletionPort::associate_device(WinHANDLE device, WinULONG_PTR key
+        , std::error_code& ec)
+    {
+        associate_with_impl(device, key, ec);
+    }
+
+    inline void IoCompletionPort::associate_socket(WinSOCKET socket, WinULONG_PTR key
+        , std::error_code& ec)
+    {
+        associate_with_impl(socket, key, ec);
+    }
+} // namespace wi
@@ -0,0 +1,504 @@
+#pragma once
+#include <win_io/io_completion_port.h>
+#include <win_io/timer_wheel.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#if !defined(_WIN32)
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
+namespace wi
+{
+    // Run loop that drains `IoCompletionPort` from a pool of threads.
+    // Each thread calls get_many() and hands every entry to `dispatch`
+    // (e.g., wi::dispatch_operation to invoke IoOperation's callback),
+    // concurrently.
+    //
+    // stop() posts one sentinel entry (kStopKey, no OVERLAPPED) per thread,
+    // so blocked threads wake up and exit. Entries posted before stop()
+    // are dispatched first, as long as port keeps FIFO order.
+    // Same as Asio, once stopped, run() returns immediately until restart().
+    //
+    // Timers: expired WheelTimer's entry is dispatched same way as
+    // port's entries. One of the waiting threads uses the next expiration
+    // time as its wait time-out; if earlier timer is scheduled, that
+    // thread is woken up with kWakeKey entry to re-calculate it.
+    // Thread gives the duty up once it has entries to dispatch; if other
+    // threads are blocked without time-out then, one of them is woken up
+    // with kWakeKey to take it (same for a timer scheduled meanwhile).
+    class IoContext
+    {
+    public:
+        using Dispatch = void (*)(void* user_data, const PortEntry& entry, std::error_code ec);
+        using Clock = std::chrono::steady_clock;
+
+        // Reserved: do not post entries with these keys.
+        static constexpr WinULONG_PTR kStopKey = ~WinULONG_PTR(0);
+        static constexpr WinULONG_PTR kWakeKey = ~WinULONG_PTR(0) - 1;
+        static constexpr std::size_t kBatchSize = 64;
+
+        // `threads_count` - how many threads run() uses, including the
+        // calling one (0 - as many as CPUs).
+        // `pin_threads` - pin i-th pool thread to (i % CPUs) CPU, best effort.
+        // Calling thread's affinity is left as is.
+        explicit IoContext(IoCompletionPort& port
+            , Dispatch dispatch
+            , void* user_data = nullptr
+            , std::uint32_t threads_count = 0
+            , bool pin_threads = false);
+        IoContext(const IoContext&) = delete;
+        IoContext& operator=(const IoContext&) = delete;
+        IoContext(IoContext&&) = delete;
+        IoContext& operator=(IoContext&&) = delete;
+        ~IoContext();
+
+        // Blocks until stop(). Returns number of dispatched entries.
+        // `ec` is set if waiting on the port failed (context is stopped then).
+        std::size_t run(std::error_code& ec);
+
+        // Same as run(), but calls stop() itself once `time` passes.
+        template<typename Rep, typename Period>
+        std::size_t run_for(std::chrono::duration<Rep, Period> time
+            , std::error_code& ec);
+
+        // Thread-safe. Can be called from `dispatch`.
+        void stop();
+        bool stopped() const;
+        // Must not be called while run() is in progress.
+        void restart();
+
+        std::uint32_t threads_count() const;
+
+        // Thread-safe, O(1). `timer.entry` is dispatched once `time`
+        // passes (rounded up to 1ms). Reschedules if already scheduled.
+        template<typename Rep, typename Period>
+        void schedule_timer(WheelTimer& timer, std::chrono::duration<Rep, Period> time);
+        void schedule_timer_at(WheelTimer& timer, Clock::time_point when);
+        // Thread-safe, O(1). Timer that already expired, but is not
+        // yet dispatched, will still be dispatched.
+        void cancel_timer(WheelTimer& timer);
+
+    private:
+        std::size_t run_impl(std::optional<Clock::time_point> deadline
+            , std::error_code& ec);
+        std::size_t run_thread(std::optional<Clock::time_point> deadline
+            , std::error_code& ec);
+        void set_error(const std::error_code& ec);
+        // Under `timers_lock_`. True if nobody waits for timers, but some
+        // thread is blocked without time-out and can take the duty:
+        // kWakeKey needs to be posted then (`wake_posted_` is set).
+        bool hand_off_timer_duty(bool has_timers);
+        void post_wake_up();
+
+    private:
+        IoCompletionPort& port_;
+        Dispatch dispatch_;
+        void* user_data_;
+        std::uint32_t threads_count_;
+        bool pin_threads_;
+        std::atomic<bool> stopped_;
+        std::atomic<std::uint32_t> running_;
+
+        std::mutex error_lock_;
+        std::error_code error_;
+
+        std::mutex timers_lock_;
+        TimerWheel timers_;
+        // Id of the thread's wait that uses timers for time-out, 0 if none.
+        std::uint64_t timer_duty_;
+        std::uint64_t timer_duty_id_;
+        Clock::time_point planned_wake_up_;
+        // Threads blocked on the port without timer duty.
+        std::uint32_t waiting_;
+        // kWakeKey is posted, but nobody took the duty yet.
+        bool wake_posted_;
+    };
+} // namespace wi
+
+namespace wi
+{
+    template<typename Rep, typename Period>
+    std::size_t IoContext::run_for(std::chrono::duration<Rep, Period> time
+        , std::error_code& ec)
+    {
+        const auto duration = std::chrono::duration_cast<Clock::duration>(time);
+        return run_impl(Clock::now() + duration, ec);
+    }
+
+    template<typename Rep, typename Period>
+    void IoContext::schedule_timer(WheelTimer& timer, std::chrono::duration<Rep, Period> time)
+    {
+        const auto duration = std::chrono::duration_cast<Clock::duration>(time);
+        schedule_timer_at(timer, Clock::now() + duration);
+    }
+} // namespace wi
+
+///////////////////////////////////////////////////////////////////////////////
+// Implementation.
+namespace wi::detail
+{
+    // Best effort: returns false if thread can't be pinned.
+    inline bool PinThisThreadToCpu(std::uint32_t cpu)
+    {
+#if defined(_WIN32)
+        if (cpu >= (sizeof(DWORD_PTR) * 8))
+        {
+            return false;
+        }
+        return (::SetThreadAffinityMask(::GetCurrentThread(), DWORD_PTR(1) << cpu) != 0);
+#else
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        return (::pthread_setaffinity_np(::pthread_self(), sizeof(cpus), &cpus) == 0);
+#endif
+    }
+} // namespace wi::detail
+
+namespace wi
+{
+    /*explicit*/ inline IoContext::IoContext(IoCompletionPort& port
+        , Dispatch dispatch
+        , void* user_data /*= nullptr*/
+        , std::uint32_t threads_count /*= 0*/
+        , bool pin_threads /*= false*/)
+        : port_(port)
+        , dispatch_(dispatch)
+        , user_data_(user_data)
+        , threads_count_(threads_count)
+        , pin_threads_(pin_threads)
+        , stopped_(false)
+        , running_(0)
+        , error_lock_()
+        , error_()
+        , timers_lock_()
+        , timers_()
+        , timer_duty_(0)
+        , timer_duty_id_(0)
+        , planned_wake_up_()
+        , waiting_(0)
+        , wake_posted_(false)
+    {
+        assert(dispatch_ && "[Io] IoContext needs dispatch function");
+        if (threads_count_ == 0)
+        {
+            threads_count_ = (std::max)(1u, std::thread::hardware_concurrency());
+        }
+    }
+
+    inline IoContext::~IoContext()
+    {
+        assert((running_.load() == 0)
+            && "[Io] IoContext destroyed while run() is in progress");
+    }
+
+    inline std::uint32_t IoContext::threads_count() const
+    {
+        return threads_count_;
+    }
+
+    inline bool IoContext::stopped() const
+    {
+        return stopped_.load(std::memory_order_acquire);
+    }
+
+    inline void IoContext::restart()
+    {
+        assert((running_.load() == 0)
+            && "[Io] IoContext::restart() while run() is in progress");
+        stopped_.store(false, std::memory_order_release);
+    }
+
+    inline void IoContext::stop()
+    {
+        if (stopped_.exchange(true, std::memory_order_acq_rel))
+        {
+            return;
+        }
+        // One wake-up per thread. Extra (stale) sentinels that
+        // nobody consumed are ignored by the next run().
+        std::vector<PortEntry> sentinels(threads_count_, PortEntry(0, kStopKey, nullptr));
+        std::error_code ec;
+        (void)port_.post_many(sentinels, ec);
+        if (ec)
+        {
+            set_error(ec);
+        }
+    }
+
+    inline void IoContext::schedule_timer_at(WheelTimer& timer, Clock::time_point when)
+    {
+        bool wake_up = false;
+        {
+            std::lock_guard _(timers_lock_);
+            timers_.schedule(timer, when);
+            if ((timer_duty_ != 0) && (when < planned_wake_up_))
+            {
+                // Waiting thread will sleep for too long; whoever
+                // takes kWakeKey takes the duty.
+                timer_duty_ = 0;
+                wake_posted_ = true;
+                wake_up = true;
+            }
+            else
+            {
+                // Duty holder may be dispatching for long.
+                wake_up = hand_off_timer_duty(true);
+            }
+        }
+        if (wake_up)
+        {
+            post_wake_up();
+        }
+    }
+
+    inline bool IoContext::hand_off_timer_duty(bool has_timers)
+    {
+        if ((timer_duty_ != 0) || (waiting_ == 0) || wake_posted_ || !has_timers)
+        {
+            return false;
+        }
+        wake_posted_ = true;
+        return true;
+    }
+
+    inline void IoContext::post_wake_up()
+    {
+        std::error_code ec;
+        port_.post(PortEntry(0, kWakeKey, nullptr), ec);
+        if (ec)
+        {
+            set_error(ec);
+        }
+    }
+
+    inline void IoContext::cancel_timer(WheelTimer& timer)
+    {
+        std::lock_guard _(timers_lock_);
+        timers_.cancel(timer);
+    }
+
+    inline void IoContext::set_error(const std::error_code& ec)
+    {
+        std::lock_guard _(error_lock_);
+        if (!error_)
+        {
+            error_ = ec;
+        }
+    }
+
+    inline std::size_t IoContext::run(std::error_code& ec)
+    {
+        return run_impl(std::nullopt, ec);
+    }
+
+    inline std::size_t IoContext::run_impl(std::optional<Clock::time_point> deadline
+        , std::error_code& ec)
+    {
+        ec = std::error_code();
+        if (stopped())
+        {
+            return 0;
+        }
+        {
+            std::lock_guard _(error_lock_);
+            error_ = std::error_code();
+        }
+
+        running_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic<std::size_t> dispatched(0);
+        std::vector<std::thread> pool;
+        try
+        {
+            pool.reserve(threads_count_ - 1);
+            for (std::uint32_t i = 1; i < threads_count_; ++i)
+            {
+                pool.emplace_back([this, i, &dispatched]()
+                {
+                    if (pin_threads_)
+                    {
+                        const std::uint32_t cpus = (std::max)(1u, std::thread::hardware_concurrency());
+                        (void)detail::PinThisThreadToCpu(i % cpus);
+                    }
+                    std::error_code thread_ec;
+                    dispatched += run_thread(std::nullopt, thread_ec);
+                    if (thread_ec)
+                    {
+                        set_error(thread_ec);
+                    }
+                });
+            }
+        }
+        catch (const std::system_error& e)
+        {
+            // Could not start all threads: run with what we have.
+            set_error(e.code());
+        }
+
+        std::error_code thread_ec;
+        dispatched += run_thread(deadline, thread_ec);
+        if (thread_ec)
+        {
+            set_error(thread_ec);
+        }
+        for (std::thread& thread : pool)
+        {
+            thread.join();
+        }
+        running_.fetch_sub(1, std::memory_order_relaxed);
+
+        std::lock_guard _(error_lock_);
+        ec = error_;
+        return dispatched.load();
+    }
+
+    inline std::size_t IoContext::run_thread(std::optional<Clock::time_point> deadline
+        , std::error_code& ec)
+    {
+        std::size_t dispatched = 0;
+        PortEntry entries[kBatchSize];
+        std::vector<PortEntry> expired;
+        while (!stopped())
+        {
+            const auto now = Clock::now();
+            if (deadline && (now >= *deadline))
+            {
+                deadline.reset();
+                stop();
+                continue;
+            }
+
+            std::optional<Clock::time_point> wake_up = deadline;
+            std::uint64_t timer_duty = 0;
+            bool hand_off = false;
+            {
+                std::lock_guard _(timers_lock_);
+                timers_.advance(now, [&](WheelTimer& timer)
+                {
+                    expired.push_back(timer.entry);
+                });
+                if (!expired.empty())
+                {
+                    // Going to dispatch: let blocked thread wait for the rest.
+                    hand_off = hand_off_timer_duty(timers_.next_expiry().has_value());
+                }
+                else if (timer_duty_ == 0)
+                {
+                    // Nobody waits for timers; take it.
+                    timer_duty = timer_duty_ = ++timer_duty_id_;
+                    wake_posted_ = false;
+                    const std::optional<Clock::time_point> next = timers_.next_expiry();
+                    planned_wake_up_ = next.value_or(Clock::time_point::max());
+                    if (next && (!wake_up || (*next < *wake_up)))
+                    {
+                        wake_up = next;
+                    }
+                }
+                else
+                {
+                    ++waiting_;
+                }
+            }
+            if (hand_off)
+            {
+                post_wake_up();
+            }
+            if (!expired.empty())
+            {
+                for (const PortEntry& entry : expired)
+                {
+                    dispatch_(user_data_, entry, std::error_code());
+                    ++dispatched;
+                }
+                expired.clear();
+                continue;
+            }
+
+            std::error_code wait_ec;
+            std::span<PortEntry> ready;
+            if (wake_up)
+            {
+                const auto left = std::chrono::ceil<std::chrono::milliseconds>(*wake_up - Clock::now());
+                ready = port_.wait_for_many(entries
+                    , (std::max)(left, std::chrono::milliseconds(0))
+                    , wait_ec);
+            }
+            else
+            {
+                ready = port_.get_many(entries, wait_ec);
+            }
+
+            const bool has_work = std::any_of(ready.begin(), ready.end()
+                , [](const PortEntry& entry)
+            {
+                return (entry.overlapped
+                    || ((entry.completion_key != kStopKey) && (entry.completion_key != kWakeKey)));
+            });
+            {
+                std::lock_guard _(timers_lock_);
+                if (timer_duty == 0)
+                {
+                    --waiting_;
+                }
+                else if (timer_duty_ == timer_duty)
+                {
+                    timer_duty_ = 0;
+                    // Dispatch may take long: let blocked thread wait for timers.
+                    hand_off = has_work
+                        && hand_off_timer_duty(planned_wake_up_ != Clock::time_point::max());
+                }
+            }
+            if (hand_off)
+            {
+                post_wake_up();
+            }
+
+            if (ready.empty() && wait_ec)
+            {
+                if (wait_ec == detail::make_timeout_error_code())
+                {
+                    continue;
+                }
+                // Port is unusable; don't wait for the sentinel.
+                ec = wait_ec;
+                stop();
+                break;
+            }
+
+            std::size_t sentinels = 0;
+            for (const PortEntry& entry : ready)
+            {
+                if (!entry.overlapped
+                    && ((entry.completion_key == kStopKey) || (entry.completion_key == kWakeKey)))
+                {
+                    sentinels += (entry.completion_key == kStopKey);
+                    continue;
+                }
+                dispatch_(user_data_, entry, wait_ec);
+                ++dispatched;
+            }
+
+            if ((sentinels > 1) && stopped())
+            {
+                // Took wake-ups of other threads; give them back.
+                std::vector<PortEntry> extra(sentinels - 1, PortEntry(0, kStopKey, nullptr));
+                (void)port_.post_many(extra, wait_ec);
+            }
+        }
+        return dispatched;
+    }
+} // namespace wi
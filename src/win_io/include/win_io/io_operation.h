@@ -0,0 +1,89 @@
+#pragma once
+#include <win_io/io_completion_port.h>
+
+#include <span>
+#include <system_error>
+
+#include <cassert>
+#include <cstddef>
+
+namespace wi
+{
+    // Header of the asynchronous operation: OVERLAPPED followed by
+    // the completion callback. Embed it into operation's state and pass
+    // overlapped() to the Win API call (or post it with PortEntry).
+    // Once completed, dispatch() gets to the callback straight from
+    // `PortEntry::overlapped`: no completion key lookups or comparisons,
+    // so sockets, files and directory changes can share the same port
+    // and the same run loop.
+    //
+    // Must outlive the operation (until the callback is invoked).
+    struct IoOperation : WinOVERLAPPED
+    {
+        using Callback = void (*)(void* user_data, const PortEntry& entry, std::error_code ec);
+
+        Callback callback = nullptr;
+        void* user_data = nullptr;
+
+        explicit IoOperation(Callback on_complete = nullptr, void* data = nullptr) noexcept;
+
+        WinOVERLAPPED* overlapped() noexcept;
+        // `entry.overlapped` must point to IoOperation.
+        static IoOperation& from(const PortEntry& entry) noexcept;
+        void invoke(const PortEntry& entry, std::error_code ec);
+    };
+
+    // Invokes callback of each entry's operation. `ec` is the
+    // error of the wait that returned `entries`, if any.
+    // Returns number of invoked callbacks.
+    std::size_t dispatch(std::span<const PortEntry> entries, std::error_code ec = std::error_code());
+
+    // Same as above, for single entry. Has the same signature as
+    // IoContext::Dispatch and can be used as one.
+    void dispatch_operation(void* user_data, const PortEntry& entry, std::error_code ec);
+} // namespace wi
+
+///////////////////////////////////////////////////////////////////////////////
+// Implementation.
+namespace wi
+{
+    /*explicit*/ inline IoOperation::IoOperation(Callback on_complete /*= nullptr*/
+        , void* data /*= nullptr*/) noexcept
+        : WinOVERLAPPED()
+        , callback(on_complete)
+        , user_data(data)
+    {
+    }
+
+    inline WinOVERLAPPED* IoOperation::overlapped() noexcept
+    {
+        return this;
+    }
+
+    /*static*/ inline IoOperation& IoOperation::from(const PortEntry& entry) noexcept
+    {
+        assert(entry.overlapped && "[Io] Entry without IoOperation");
+        // Pointer to WinOVERLAPPED base, as given to the system.
+        return static_cast<IoOperation&>(*static_cast<WinOVERLAPPED*>(entry.overlapped));
+    }
+
+    inline void IoOperation::invoke(const PortEntry& entry, std::error_code ec)
+    {
+        assert(callback && "[Io] IoOperation without callback");
+        callback(user_data, entry, ec);
+    }
+
+    inline std::size_t dispatch(std::span<const PortEntry> entries, std::error_code ec /*= {}*/)
+    {
+        for (const PortEntry& entry : entries)
+        {
+            IoOperation::from(entry).invoke(entry, ec);
+        }
+        return entries.size();
+    }
+
+    inline void dispatch_operation(void* /*user_data*/, const PortEntry& entry, std::error_code ec)
+    {
+        IoOperation::from(entry).invoke(entry, ec);
+    }
+} // namespace wi
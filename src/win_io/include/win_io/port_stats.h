@@ -0,0 +1,310 @@
+#pragma once
+// Part of <win_io/io_completion_port.h>, include that instead:
+// expects `PortEntry` & friends to be declared.
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <span>
+#include <system_error>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace wi
+{
+    // Copy of PortStats counters at some point of time.
+    struct PortStatsSnapshot
+    {
+        // batch_sizes[0] - waits that returned nothing;
+        // batch_sizes[i] - [2^(i-1), 2^i) entries returned;
+        // last one - 1024 entries or more.
+        static constexpr std::size_t kBatchBucketsCount = 12;
+
+        struct KeyCount
+        {
+            WinULONG_PTR completion_key = 0;
+            std::uint64_t dequeues = 0;
+        };
+
+        // Entries successfully posted.
+        std::uint64_t posts = 0;
+        // Entries returned by get*()/query*()/wait_for*().
+        std::uint64_t dequeues = 0;
+        // Calls to get*()/query*()/wait_for*().
+        std::uint64_t waits = 0;
+        std::uint64_t timeouts = 0;
+        // Failed posts and waits (other than time-out).
+        std::uint64_t errors = 0;
+        std::uint64_t batch_sizes[kBatchBucketsCount]{};
+        // Time spent inside the wait calls.
+        std::chrono::nanoseconds blocked_time{0};
+        // Time between the wait that returned entries and the next wait
+        // on the same thread, i.e., handling of the entries.
+        std::chrono::nanoseconds dispatch_time{0};
+        // Dequeues per completion key, sorted by key.
+        std::vector<KeyCount> keys;
+        // Dequeues of keys that did not fit into PortStats::kKeysCapacity.
+        std::uint64_t other_keys_dequeues = 0;
+    };
+
+    // Opt-in instrumentation of IoCompletionPort, see
+    // IoCompletionPort::set_stats(). Thread-safe and lock-free:
+    // each thread updates its own (cache line-sized) slot of counters,
+    // so waiting threads do not contend. Per-key counters are shared,
+    // key slots are taken with CAS, once.
+    //
+    // Counters are read with snapshot(); values are consistent per
+    // counter, not across counters, while the port is in use.
+    class PortStats
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr std::size_t kBatchBucketsCount = PortStatsSnapshot::kBatchBucketsCount;
+        // More threads share slots (still correct, but contend).
+        static constexpr std::size_t kThreadSlotsCount = 64;
+        static constexpr std::size_t kKeysCapacity = 64;
+
+        explicit PortStats() noexcept;
+        PortStats(const PortStats&) = delete;
+        PortStats& operator=(const PortStats&) = delete;
+        PortStats(PortStats&&) = delete;
+        PortStats& operator=(PortStats&&) = delete;
+
+        PortStatsSnapshot snapshot() const;
+        // Must not race with the port's use: counters updated
+        // concurrently may be lost or kept.
+        void reset() noexcept;
+
+        // Called by IoCompletionPort.
+        void on_posted(std::size_t count, const std::error_code& ec) noexcept;
+        Clock::time_point on_wait_start() noexcept;
+        void on_waited(Clock::time_point start
+            , std::span<const PortEntry> entries
+            , const std::error_code& ec) noexcept;
+
+    private:
+        struct alignas(64) ThreadSlot
+        {
+            std::atomic<std::uint64_t> posts{0};
+            std::atomic<std::uint64_t> dequeues{0};
+            std::atomic<std::uint64_t> waits{0};
+            std::atomic<std::uint64_t> timeouts{0};
+            std::atomic<std::uint64_t> errors{0};
+            std::atomic<std::uint64_t> batch_sizes[kBatchBucketsCount]{};
+            std::atomic<std::int64_t> blocked_ns{0};
+            std::atomic<std::int64_t> dispatch_ns{0};
+        };
+
+        struct KeySlot
+        {
+            enum State : std::uint32_t { kEmpty, kTaking, kTaken };
+            std::atomic<std::uint32_t> state{kEmpty};
+            std::atomic<WinULONG_PTR> key{0};
+            std::atomic<std::uint64_t> dequeues{0};
+        };
+
+        ThreadSlot& this_thread_slot() noexcept;
+        void count_key(WinULONG_PTR key) noexcept;
+        static std::size_t batch_bucket(std::size_t size) noexcept;
+
+    private:
+        ThreadSlot threads_[kThreadSlotsCount];
+        KeySlot keys_[kKeysCapacity];
+        std::atomic<std::uint64_t> other_keys_dequeues_;
+    };
+} // namespace wi
+
+///////////////////////////////////////////////////////////////////////////////
+// Implementation.
+namespace wi::detail
+{
+    inline std::atomic<std::size_t> stats_threads_count{0};
+    // Index of the calling thread's counters in PortStats.
+    inline thread_local const std::size_t tls_stats_thread_index
+        = stats_threads_count.fetch_add(1, std::memory_order_relaxed);
+
+    // The last wait that returned entries, to measure dispatch time.
+    struct LastDequeue
+    {
+        const void* stats = nullptr;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    inline thread_local LastDequeue tls_last_dequeue;
+} // namespace wi::detail
+
+namespace wi
+{
+    /*explicit*/ inline PortStats::PortStats() noexcept
+        : threads_()
+        , keys_()
+        , other_keys_dequeues_(0)
+    {
+    }
+
+    inline PortStats::ThreadSlot& PortStats::this_thread_slot() noexcept
+    {
+        return threads_[detail::tls_stats_thread_index % kThreadSlotsCount];
+    }
+
+    /*static*/ inline std::size_t PortStats::batch_bucket(std::size_t size) noexcept
+    {
+        return (std::min)(std::size_t(std::bit_width(size)), kBatchBucketsCount - 1);
+    }
+
+    inline void PortStats::on_posted(std::size_t count, const std::error_code& ec) noexcept
+    {
+        ThreadSlot& slot = this_thread_slot();
+        slot.posts.fetch_add(count, std::memory_order_relaxed);
+        if (ec)
+        {
+            slot.errors.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    inline PortStats::Clock::time_point PortStats::on_wait_start() noexcept
+    {
+        const Clock::time_point now = Clock::now();
+        detail::LastDequeue& last = detail::tls_last_dequeue;
+        if (last.stats == this)
+        {
+            this_thread_slot().dispatch_ns.fetch_add((now - last.time).count()
+                , std::memory_order_relaxed);
+            last.stats = nullptr;
+        }
+        return now;
+    }
+
+    inline void PortStats::on_waited(Clock::time_point start
+        , std::span<const PortEntry> entries
+        , const std::error_code& ec) noexcept
+    {
+        const Clock::time_point now = Clock::now();
+        ThreadSlot& slot = this_thread_slot();
+        slot.waits.fetch_add(1, std::memory_order_relaxed);
+        slot.blocked_ns.fetch_add((now - start).count(), std::memory_order_relaxed);
+        slot.batch_sizes[batch_bucket(entries.size())].fetch_add(1, std::memory_order_relaxed);
+        if (ec)
+        {
+            if (ec == detail::make_timeout_error_code())
+            {
+                slot.timeouts.fetch_add(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                slot.errors.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        if (entries.empty())
+        {
+            return;
+        }
+        slot.dequeues.fetch_add(entries.size(), std::memory_order_relaxed);
+        for (const PortEntry& entry : entries)
+        {
+            count_key(entry.completion_key);
+        }
+        detail::tls_last_dequeue = {this, now};
+    }
+
+    inline void PortStats::count_key(WinULONG_PTR key) noexcept
+    {
+        // Open addressing with linear probing; slots are never freed.
+        const std::size_t hash = std::size_t(key * 0x9E3779B97F4A7C15ull);
+        for (std::size_t i = 0; i < kKeysCapacity; ++i)
+        {
+            KeySlot& slot = keys_[(hash + i) % kKeysCapacity];
+            std::uint32_t state = slot.state.load(std::memory_order_acquire);
+            if (state == KeySlot::kEmpty)
+            {
+                if (slot.state.compare_exchange_strong(state, KeySlot::kTaking
+                    , std::memory_order_acquire))
+                {
+                    slot.key.store(key, std::memory_order_relaxed);
+                    slot.dequeues.fetch_add(1, std::memory_order_relaxed);
+                    slot.state.store(KeySlot::kTaken, std::memory_order_release);
+                    return;
+                }
+            }
+            // Someone else is taking it; the key is published right after.
+            while (state == KeySlot::kTaking)
+            {
+                state = slot.state.load(std::memory_order_acquire);
+            }
+            if (slot.key.load(std::memory_order_relaxed) == key)
+            {
+                slot.dequeues.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        other_keys_dequeues_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    inline PortStatsSnapshot PortStats::snapshot() const
+    {
+        PortStatsSnapshot stats;
+        std::int64_t blocked_ns = 0;
+        std::int64_t dispatch_ns = 0;
+        for (const ThreadSlot& slot : threads_)
+        {
+            stats.posts += slot.posts.load(std::memory_order_relaxed);
+            stats.dequeues += slot.dequeues.load(std::memory_order_relaxed);
+            stats.waits += slot.waits.load(std::memory_order_relaxed);
+            stats.timeouts += slot.timeouts.load(std::memory_order_relaxed);
+            stats.errors += slot.errors.load(std::memory_order_relaxed);
+            for (std::size_t i = 0; i < kBatchBucketsCount; ++i)
+            {
+                stats.batch_sizes[i] += slot.batch_sizes[i].load(std::memory_order_relaxed);
+            }
+            blocked_ns += slot.blocked_ns.load(std::memory_order_relaxed);
+            dispatch_ns += slot.dispatch_ns.load(std::memory_order_relaxed);
+        }
+        stats.blocked_time = std::chrono::nanoseconds(blocked_ns);
+        stats.dispatch_time = std::chrono::nanoseconds(dispatch_ns);
+
+        for (const KeySlot& slot : keys_)
+        {
+            if (slot.state.load(std::memory_order_acquire) == KeySlot::kTaken)
+            {
+                stats.keys.push_back({slot.key.load(std::memory_order_relaxed)
+                    , slot.dequeues.load(std::memory_order_relaxed)});
+            }
+        }
+        std::sort(stats.keys.begin(), stats.keys.end()
+            , [](const PortStatsSnapshot::KeyCount& lhs, const PortStatsSnapshot::KeyCount& rhs)
+        {
+            return (lhs.completion_key < rhs.completion_key);
+        });
+        stats.other_keys_dequeues = other_keys_dequeues_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    inline void PortStats::reset() noexcept
+    {
+        for (ThreadSlot& slot : threads_)
+        {
+            slot.posts.store(0, std::memory_order_relaxed);
+            slot.dequeues.store(0, std::memory_order_relaxed);
+            slot.waits.store(0, std::memory_order_relaxed);
+            slot.timeouts.store(0, std::memory_order_relaxed);
+            slot.errors.store(0, std::memory_order_relaxed);
+            for (auto& bucket : slot.batch_sizes)
+            {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            slot.blocked_ns.store(0, std::memory_order_relaxed);
+            slot.dispatch_ns.store(0, std::memory_order_relaxed);
+        }
+        for (KeySlot& slot : keys_)
+        {
+            slot.state.store(KeySlot::kEmpty, std::memory_order_relaxed);
+            slot.key.store(0, std::memory_order_relaxed);
+            slot.dequeues.store(0, std::memory_order_relaxed);
+        }
+        other_keys_dequeues_.store(0, std::memory_order_relaxed);
+    }
+} // namespace wi
@@ -1,5 +1,6 @@
 #pragma once
 #include "io_completion_port.h"
+#include "io_operation.h"
 
 #include <variant>
 #include <optional>
@@ -287,6 +288,11 @@ namespace wi
 
         const void* buffer() const;
 
+        // Callback for wi::dispatch(): once completed, port's entry
+        // is routed to `callback` without `dir_key` checks.
+        // Useful when the port is drained by IoContext.
+        void set_callback(IoOperation::Callback callback, void* user_data);
+
     private:
         static WinHANDLE open_directory(const wchar_t* directory_name, std::error_code& ec);
         void close() noexcept;
@@ -298,7 +304,7 @@ namespace wi
         WinHANDLE directory_{};
         void* buffer_ = nullptr;
         WinULONG_PTR dir_key_{};
-        WinOVERLAPPED ov_{};
+        IoOperation ov_{};
         WinDWORD length_bytes_ = 0;
         WinDWORD notify_filter_ = 0;
         bool owns_directory_ = false;
@@ -508,7 +514,7 @@ namespace wi
         o.directory_ = directory;
         o.buffer_ = buffer;
         o.dir_key_ = dir_key;
-        o.ov_ = {};
+        o.ov_ = IoOperation();
         o.length_bytes_ = length;
         o.notify_filter_ = notify_filter;
         o.owns_directory_ = false;
@@ -602,6 +608,12 @@ namespace wi
         return buffer_;
     }
 
+    inline void DirectoryChanges::set_callback(IoOperation::Callback callback, void* user_data)
+    {
+        ov_.callback = callback;
+        ov_.user_data = user_data;
+    }
+
     inline DirectoryChanges::~DirectoryChanges()
     {
         close();
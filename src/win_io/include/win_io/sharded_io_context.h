@@ -0,0 +1,495 @@
+#pragma once
+#include <win_io/io_completion_port.h>
+#include <win_io/io_context.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace wi
+{
+    // Same as IoContext, but instead of single shared port there is
+    // one IoCompletionPort (shard) per thread, usually one per core,
+    // so threads do not contend on the same port.
+    //
+    // Devices and sockets should be associated with current_port()
+    // (shard of the thread that creates them); posts that target
+    // current_port() stay on the same thread.
+    // Thread whose shard is empty blocks on its own shard (no polling
+    // while idle). Thread that dequeues a full batch (evidence of backlog)
+    // wakes one idle thread with kStealKey entry; that one steals batches
+    // of ready entries from other shards until there is nothing to steal,
+    // then blocks again. Best effort: backlog is still served by the owner.
+    // Entries of the dequeued batch can't be stolen: if dispatch takes
+    // longer than kGiveBackTime while some threads are idle, the rest of
+    // the batch is posted back to the port (after entries posted
+    // meanwhile) and one idle thread is woken up the same way.
+    class ShardedIoContext
+    {
+    public:
+        using Dispatch = IoContext::Dispatch;
+
+        // Reserved: do not post entries with these keys.
+        static constexpr WinULONG_PTR kStopKey = IoContext::kStopKey;
+        static constexpr WinULONG_PTR kStealKey = IoContext::kWakeKey;
+        static constexpr std::size_t kBatchSize = IoContext::kBatchSize;
+        static constexpr std::size_t kStealBatchSize = 16;
+        static constexpr std::chrono::milliseconds kGiveBackTime{1};
+
+        // `shards_count` - 0 for as many as CPUs. run() uses one thread
+        // per shard, calling thread serves shard 0.
+        // `pin_threads` - pin thread of i-th shard to (i % CPUs) CPU,
+        // best effort. Calling thread's affinity is left as is.
+        static std::unique_ptr<ShardedIoContext> make(std::uint32_t shards_count
+            , Dispatch dispatch
+            , void* user_data
+            , bool pin_threads
+            , std::error_code& ec) noexcept;
+
+        ShardedIoContext(const ShardedIoContext&) = delete;
+        ShardedIoContext& operator=(const ShardedIoContext&) = delete;
+        ShardedIoContext(ShardedIoContext&&) = delete;
+        ShardedIoContext& operator=(ShardedIoContext&&) = delete;
+        ~ShardedIoContext();
+
+        // If thread for some shard can't be created, stops and
+        // returns the error: shard without owner is never woken up.
+        std::size_t run(std::error_code& ec);
+
+        template<typename Rep, typename Period>
+        std::size_t run_for(std::chrono::duration<Rep, Period> time
+            , std::error_code& ec);
+
+        void stop();
+        bool stopped() const;
+        void restart();
+
+        std::uint32_t shards_count() const;
+        IoCompletionPort& port(std::uint32_t shard);
+        // Shard of the calling thread. Threads outside of run()
+        // are assigned to shards round-robin, on first call.
+        std::uint32_t current_shard();
+        IoCompletionPort& current_port();
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        explicit ShardedIoContext(Dispatch dispatch, void* user_data, bool pin_threads) noexcept;
+        std::size_t run_impl(std::optional<Clock::time_point> deadline
+            , std::error_code& ec);
+        std::size_t run_shard(std::uint32_t shard
+            , std::optional<Clock::time_point> deadline
+            , std::error_code& ec);
+        // `victim` is set to the shard entries are taken from.
+        std::span<PortEntry> steal(std::uint32_t thief
+            , std::span<PortEntry> entries_to_write
+            , std::uint32_t& victim);
+        // Wakes one idle thread (if any), except `busy_shard`'s one.
+        void wake_thief(std::uint32_t busy_shard);
+        void set_error(const std::error_code& ec);
+
+    private:
+        std::vector<IoCompletionPort> ports_;
+        Dispatch dispatch_;
+        void* user_data_;
+        bool pin_threads_;
+        // Per shard: its thread is blocked with nothing to do.
+        std::unique_ptr<std::atomic<bool>[]> idle_;
+        std::atomic<std::uint32_t> idle_count_;
+        std::atomic<bool> stopped_;
+        std::atomic<std::uint32_t> running_;
+        std::atomic<std::uint32_t> next_shard_;
+
+        std::mutex error_lock_;
+        std::error_code error_;
+    };
+} // namespace wi
+
+namespace wi
+{
+    template<typename Rep, typename Period>
+    std::size_t ShardedIoContext::run_for(std::chrono::duration<Rep, Period> time
+        , std::error_code& ec)
+    {
+        const auto duration = std::chrono::duration_cast<Clock::duration>(time);
+        return run_impl(Clock::now() + duration, ec);
+    }
+} // namespace wi
+
+///////////////////////////////////////////////////////////////////////////////
+// Implementation.
+namespace wi::detail
+{
+    // Which shard the thread belongs to, see ShardedIoContext::current_shard().
+    struct ThisThreadShard
+    {
+        const void* context = nullptr;
+        std::uint32_t shard = 0;
+    };
+
+    inline thread_local ThisThreadShard tls_this_thread_shard;
+} // namespace wi::detail
+
+namespace wi
+{
+    /*static*/ inline std::unique_ptr<ShardedIoContext> ShardedIoContext::make(std::uint32_t shards_count
+        , Dispatch dispatch
+        , void* user_data
+        , bool pin_threads
+        , std::error_code& ec) noexcept
+    {
+        assert(dispatch && "[Io] ShardedIoContext needs dispatch function");
+        if (shards_count == 0)
+        {
+            shards_count = (std::max)(1u, std::thread::hardware_concurrency());
+        }
+
+        try
+        {
+            std::unique_ptr<ShardedIoContext> context(
+                new ShardedIoContext(dispatch, user_data, pin_threads));
+            context->ports_.reserve(shards_count);
+            context->idle_ = std::make_unique<std::atomic<bool>[]>(shards_count);
+            for (std::uint32_t i = 0; i < shards_count; ++i)
+            {
+                // No concurrency limit of 1 thread: with IOCP, thieves would
+                // not be able to dequeue while the owner is running.
+                std::optional<IoCompletionPort> port = IoCompletionPort::make(ec);
+                if (!port)
+                {
+                    return nullptr;
+                }
+                context->ports_.push_back(std::move(*port));
+            }
+            ec = std::error_code();
+            return context;
+        }
+        catch (const std::bad_alloc&)
+        {
+            ec = std::make_error_code(std::errc::not_enough_memory);
+            return nullptr;
+        }
+    }
+
+    /*explicit*/ inline ShardedIoContext::ShardedIoContext(Dispatch dispatch
+        , void* user_data
+        , bool pin_threads) noexcept
+        : ports_()
+        , dispatch_(dispatch)
+        , user_data_(user_data)
+        , pin_threads_(pin_threads)
+        , idle_()
+        , idle_count_(0)
+        , stopped_(false)
+        , running_(0)
+        , next_shard_(0)
+        , error_lock_()
+        , error_()
+    {
+    }
+
+    inline ShardedIoContext::~ShardedIoContext()
+    {
+        assert((running_.load() == 0)
+            && "[Io] ShardedIoContext destroyed while run() is in progress");
+    }
+
+    inline std::uint32_t ShardedIoContext::shards_count() const
+    {
+        return std::uint32_t(ports_.size());
+    }
+
+    inline IoCompletionPort& ShardedIoContext::port(std::uint32_t shard)
+    {
+        assert((shard < ports_.size()) && "[Io] Invalid shard index");
+        return ports_[shard];
+    }
+
+    inline std::uint32_t ShardedIoContext::current_shard()
+    {
+        detail::ThisThreadShard& this_thread = detail::tls_this_thread_shard;
+        if (this_thread.context != this)
+        {
+            this_thread.context = this;
+            this_thread.shard = next_shard_.fetch_add(1, std::memory_order_relaxed)
+                % shards_count();
+        }
+        return this_thread.shard;
+    }
+
+    inline IoCompletionPort& ShardedIoContext::current_port()
+    {
+        return ports_[current_shard()];
+    }
+
+    inline bool ShardedIoContext::stopped() const
+    {
+        return stopped_.load(std::memory_order_acquire);
+    }
+
+    inline void ShardedIoContext::restart()
+    {
+        assert((running_.load() == 0)
+            && "[Io] ShardedIoContext::restart() while run() is in progress");
+        stopped_.store(false, std::memory_order_release);
+    }
+
+    inline void ShardedIoContext::stop()
+    {
+        if (stopped_.exchange(true, std::memory_order_acq_rel))
+        {
+            return;
+        }
+        // Wake-up for the owner of each shard. If stolen,
+        // the thief gives it back, see run_shard().
+        for (IoCompletionPort& port : ports_)
+        {
+            std::error_code ec;
+            port.post(PortEntry(0, kStopKey, nullptr), ec);
+            if (ec)
+            {
+                set_error(ec);
+            }
+        }
+    }
+
+    inline void ShardedIoContext::set_error(const std::error_code& ec)
+    {
+        std::lock_guard _(error_lock_);
+        if (!error_)
+        {
+            error_ = ec;
+        }
+    }
+
+    inline std::size_t ShardedIoContext::run(std::error_code& ec)
+    {
+        return run_impl(std::nullopt, ec);
+    }
+
+    inline std::size_t ShardedIoContext::run_impl(std::optional<Clock::time_point> deadline
+        , std::error_code& ec)
+    {
+        ec = std::error_code();
+        if (stopped())
+        {
+            return 0;
+        }
+        {
+            std::lock_guard _(error_lock_);
+            error_ = std::error_code();
+        }
+
+        running_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic<std::size_t> dispatched(0);
+        std::vector<std::thread> pool;
+        try
+        {
+            pool.reserve(shards_count() - 1);
+            for (std::uint32_t i = 1; i < shards_count(); ++i)
+            {
+                pool.emplace_back([this, i, &dispatched]()
+                {
+                    if (pin_threads_)
+                    {
+                        const std::uint32_t cpus = (std::max)(1u, std::thread::hardware_concurrency());
+                        (void)detail::PinThisThreadToCpu(i % cpus);
+                    }
+                    std::error_code thread_ec;
+                    dispatched += run_shard(i, std::nullopt, thread_ec);
+                    if (thread_ec)
+                    {
+                        set_error(thread_ec);
+                    }
+                });
+            }
+        }
+        catch (const std::system_error& e)
+        {
+            // Nobody would wake up a thief for shards without thread.
+            set_error(e.code());
+            stop();
+        }
+
+        std::error_code thread_ec;
+        dispatched += run_shard(0, deadline, thread_ec);
+        if (thread_ec)
+        {
+            set_error(thread_ec);
+        }
+        for (std::thread& thread : pool)
+        {
+            thread.join();
+        }
+        running_.fetch_sub(1, std::memory_order_relaxed);
+
+        std::lock_guard _(error_lock_);
+        ec = error_;
+        return dispatched.load();
+    }
+
+    inline std::span<PortEntry> ShardedIoContext::steal(std::uint32_t thief
+        , std::span<PortEntry> entries_to_write
+        , std::uint32_t& victim)
+    {
+        // Leave something for the owner.
+        entries_to_write = entries_to_write.first(
+            (std::min)(entries_to_write.size(), kStealBatchSize));
+        const std::uint32_t count = shards_count();
+        for (std::uint32_t i = 1; i < count; ++i)
+        {
+            std::error_code ec;
+            victim = (thief + i) % count;
+            std::span<PortEntry> ready = ports_[victim].query_many(entries_to_write, ec);
+            if (!ready.empty())
+            {
+                return ready;
+            }
+        }
+        victim = thief;
+        return entries_to_write.first(0);
+    }
+
+    inline void ShardedIoContext::wake_thief(std::uint32_t busy_shard)
+    {
+        if (idle_count_.load(std::memory_order_acquire) == 0)
+        {
+            return;
+        }
+        const std::uint32_t count = shards_count();
+        for (std::uint32_t i = 1; i < count; ++i)
+        {
+            const std::uint32_t shard = (busy_shard + i) % count;
+            bool idle = true;
+            if (idle_[shard].compare_exchange_strong(idle, false, std::memory_order_acq_rel))
+            {
+                idle_count_.fetch_sub(1, std::memory_order_acq_rel);
+                std::error_code ec;
+                ports_[shard].post(PortEntry(0, kStealKey, nullptr), ec);
+                return;
+            }
+        }
+    }
+
+    inline std::size_t ShardedIoContext::run_shard(std::uint32_t shard
+        , std::optional<Clock::time_point> deadline
+        , std::error_code& ec)
+    {
+        detail::ThisThreadShard& this_thread = detail::tls_this_thread_shard;
+        const detail::ThisThreadShard prev_shard = this_thread;
+        this_thread.context = this;
+        this_thread.shard = shard;
+
+        IoCompletionPort& own_port = ports_[shard];
+        std::size_t dispatched = 0;
+        PortEntry entries[kBatchSize];
+        // Try once on start: shards may be filled before run().
+        bool stealing = (shards_count() > 1);
+        while (!stopped())
+        {
+            if (deadline && (Clock::now() >= *deadline))
+            {
+                deadline.reset();
+                stop();
+                continue;
+            }
+
+            std::error_code wait_ec;
+            std::uint32_t victim = shard;
+            std::span<PortEntry> ready = own_port.query_many(entries, wait_ec);
+            bool backlog = (ready.size() == kBatchSize);
+            if (ready.empty() && stealing)
+            {
+                ready = steal(shard, entries, victim);
+                wait_ec = std::error_code();
+                stealing = !ready.empty();
+                backlog = (ready.size() == kStealBatchSize);
+            }
+            if (ready.empty())
+            {
+                auto wait = std::chrono::milliseconds(detail::kWaitInfinite);
+                if (deadline)
+                {
+                    const auto left = std::chrono::ceil<std::chrono::milliseconds>(*deadline - Clock::now());
+                    wait = (std::max)(left, std::chrono::milliseconds(0));
+                }
+                idle_[shard].store(true, std::memory_order_release);
+                idle_count_.fetch_add(1, std::memory_order_acq_rel);
+                ready = own_port.wait_for_many(entries, wait, wait_ec);
+                if (idle_[shard].exchange(false, std::memory_order_acq_rel))
+                {
+                    // Not woken up by wake_thief().
+                    idle_count_.fetch_sub(1, std::memory_order_acq_rel);
+                }
+                backlog = (ready.size() == kBatchSize);
+                if (ready.empty() && wait_ec)
+                {
+                    if (wait_ec == detail::make_timeout_error_code())
+                    {
+                        continue;
+                    }
+                    ec = wait_ec;
+                    stop();
+                    break;
+                }
+            }
+            if (backlog)
+            {
+                wake_thief(shard);
+            }
+
+            Clock::time_point batch_start = Clock::now();
+            for (std::size_t i = 0; i < ready.size(); ++i)
+            {
+                if ((i > 0)
+                    && (idle_count_.load(std::memory_order_acquire) > 0)
+                    && ((Clock::now() - batch_start) >= kGiveBackTime))
+                {
+                    // Slow dispatch: let idle thread steal the rest.
+                    // Not posted ones (on error) are dispatched here.
+                    std::error_code post_ec;
+                    i += ports_[victim].post_many(ready.subspan(i), post_ec);
+                    wake_thief(shard);
+                    if (i == ready.size())
+                    {
+                        break;
+                    }
+                    batch_start = Clock::now();
+                }
+                const PortEntry& entry = ready[i];
+                const bool sentinel = !entry.overlapped
+                    && ((entry.completion_key == kStopKey) || (entry.completion_key == kStealKey));
+                if (sentinel)
+                {
+                    if (victim != shard)
+                    {
+                        // Not ours: give it back to the owner.
+                        std::error_code post_ec;
+                        ports_[victim].post(entry, post_ec);
+                    }
+                    else if (entry.completion_key == kStealKey)
+                    {
+                        stealing = true;
+                    }
+                    continue;
+                }
+                dispatch_(user_data_, entry, wait_ec);
+                ++dispatched;
+            }
+        }
+
+        this_thread = prev_shard;
+        return dispatched;
+    }
+} // namespace wi
@@ -0,0 +1,167 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <span>
+#include <system_error>
+#include <thread>
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace wi
+{
+    // Wait policy for latency-critical loops: busy-polls the port
+    // (non-blocking query_many()) for up to `spin_budget()` and only then
+    // falls back to a blocking wait.
+    //
+    // Budget adapts to the observed time the port stays empty between
+    // the calls (exponentially weighted moving average):
+    //  - entries usually arrive sooner than `max_spin`: spin for about
+    //    twice that time, but no less than `max_spin / 16`;
+    //  - entries arrive later: do not spin at all, block right away
+    //    (spinning would only burn CPU). Blocking waits are still
+    //    measured, so spinning resumes once traffic gets dense.
+    //
+    // Keep one instance per thread (not thread-safe). Port-agnostic:
+    // used by `IoCompletionPort` and `UserCompletionPort` get_many()
+    // and wait_for_many() overloads. IoCompletionPort counts the whole
+    // call as single wait in PortStats, not every poll.
+    // Note: on Windows each poll is a ::GetQueuedCompletionStatusEx() call.
+    class AdaptiveSpinWait
+    {
+    public:
+        static constexpr std::chrono::nanoseconds kDefaultMaxSpin = std::chrono::microseconds(50);
+
+        explicit AdaptiveSpinWait(std::chrono::nanoseconds max_spin = kDefaultMaxSpin) noexcept;
+
+        // Same as `port.wait_for_many()` with `milliseconds` time-out
+        // (detail::kWaitInfinite to block until any entry is available).
+        template<typename Port, typename Entry>
+        std::span<Entry> wait_many(Port& port
+            , std::span<Entry> entries_to_write
+            , std::uint32_t milliseconds
+            , bool alertable
+            , std::error_code& ec);
+
+        std::chrono::nanoseconds spin_budget() const noexcept;
+        std::chrono::nanoseconds max_spin() const noexcept;
+
+    private:
+        void on_waited(std::chrono::nanoseconds idle) noexcept;
+
+    private:
+        std::chrono::nanoseconds max_spin_;
+        std::chrono::nanoseconds budget_;
+        // Average time the port was empty.
+        std::chrono::nanoseconds idle_average_;
+    };
+} // namespace wi
+
+namespace wi::detail
+{
+    // Hint to the CPU that we are in a spin-wait loop.
+    inline void CpuRelax() noexcept
+    {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        _mm_pause();
+#elif defined(_MSC_VER) && defined(_M_ARM64)
+        __yield();
+#elif defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#else
+        std::this_thread::yield();
+#endif
+    }
+} // namespace wi::detail
+
+///////////////////////////////////////////////////////////////////////////////
+// Implementation.
+namespace wi
+{
+    /*explicit*/ inline AdaptiveSpinWait::AdaptiveSpinWait(
+        std::chrono::nanoseconds max_spin /*= kDefaultMaxSpin*/) noexcept
+        : max_spin_((std::max)(max_spin, std::chrono::nanoseconds(0)))
+        , budget_(max_spin_)
+        , idle_average_(max_spin_ / 2)
+    {
+    }
+
+    inline std::chrono::nanoseconds AdaptiveSpinWait::spin_budget() const noexcept
+    {
+        return budget_;
+    }
+
+    inline std::chrono::nanoseconds AdaptiveSpinWait::max_spin() const noexcept
+    {
+        return max_spin_;
+    }
+
+    inline void AdaptiveSpinWait::on_waited(std::chrono::nanoseconds idle) noexcept
+    {
+        // Same smoothing factor (1/8) as TCP's RTT estimator.
+        idle_average_ += (idle - idle_average_) / 8;
+        if (idle_average_ > max_spin_)
+        {
+            budget_ = std::chrono::nanoseconds(0);
+            return;
+        }
+        budget_ = std::clamp(idle_average_ * 2, max_spin_ / 16, max_spin_);
+    }
+
+    template<typename Port, typename Entry>
+    std::span<Entry> AdaptiveSpinWait::wait_many(Port& port
+        , std::span<Entry> entries_to_write
+        , std::uint32_t milliseconds
+        , bool alertable
+        , std::error_code& ec)
+    {
+        // Same as detail::kWaitInfinite.
+        constexpr std::uint32_t kWaitInfinite = 0xFFFFFFFF;
+        using Clock = std::chrono::steady_clock;
+        const auto start = Clock::now();
+
+        std::span<Entry> ready = port.query_many(entries_to_write, ec, alertable);
+        if (!ready.empty() || (milliseconds == 0))
+        {
+            on_waited(std::chrono::nanoseconds(0));
+            return ready;
+        }
+
+        auto spin = budget_;
+        if (milliseconds != kWaitInfinite)
+        {
+            spin = (std::min)(spin
+                , std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::milliseconds(milliseconds)));
+        }
+        auto now = start;
+        while ((now - start) < spin)
+        {
+            detail::CpuRelax();
+            ready = port.query_many(entries_to_write, ec, alertable);
+            now = Clock::now();
+            if (!ready.empty())
+            {
+                on_waited(now - start);
+                return ready;
+            }
+        }
+
+        std::uint32_t wait_ms = milliseconds;
+        if (milliseconds != kWaitInfinite)
+        {
+            const auto spent = std::chrono::duration_cast<std::chrono::milliseconds>(now - start);
+            wait_ms = (milliseconds > std::uint32_t(spent.count()))
+                ? (milliseconds - std::uint32_t(spent.count()))
+                : 0;
+        }
+        ready = port.wait_for_many(entries_to_write, std::chrono::milliseconds(wait_ms), ec, alertable);
+        // Time-out is the lower bound of idle time; good enough.
+        on_waited(Clock::now() - start);
+        return ready;
+    }
+} // namespace wi
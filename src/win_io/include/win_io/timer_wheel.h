@@ -0,0 +1,326 @@
+#pragma once
+#include <win_io/io_completion_port.h>
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <utility>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace wi::detail
+{
+    // Node of circular doubly-linked list of timers in the wheel's slot.
+    struct TimerLink
+    {
+        TimerLink* prev = nullptr;
+        TimerLink* next = nullptr;
+    };
+} // namespace wi::detail
+
+namespace wi
+{
+    // Intrusive timer for TimerWheel. Owned by the user: no allocations
+    // are done by the wheel. Must outlive the time it's scheduled.
+    // `entry` is what run loop dispatches once the timer expires.
+    struct WheelTimer : detail::TimerLink
+    {
+        PortEntry entry;
+
+        explicit WheelTimer(PortEntry expired_entry = PortEntry()) noexcept;
+        WheelTimer(const WheelTimer&) = delete;
+        WheelTimer& operator=(const WheelTimer&) = delete;
+        ~WheelTimer();
+
+        bool is_scheduled() const noexcept;
+
+    private:
+        friend class TimerWheel;
+        std::uint64_t expires_tick_ = 0;
+    };
+
+    // Hierarchical timing wheel (Varghese & Lauck): 4 levels
+    // of 256 slots, each next level covers 256 times longer period.
+    // Timers far in the future sit in upper levels and are moved
+    // (cascaded) down once their lower level completes a revolution.
+    //
+    // schedule() and cancel() are O(1); advance() is O(expired + cascaded)
+    // plus O(1) per elapsed tick. Timers are rounded up to `resolution`;
+    // longest delay is 2^32 ticks (~49 days with 1ms), longer is clamped.
+    //
+    // Not thread-safe, see IoContext for the run loop integration.
+    class TimerWheel
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr unsigned kSlotBits = 8;
+        static constexpr std::size_t kSlotsCount = std::size_t(1) << kSlotBits;
+        static constexpr std::size_t kLevelsCount = 4;
+
+        explicit TimerWheel(Clock::duration resolution = std::chrono::milliseconds(1)
+            , Clock::time_point start = Clock::now()) noexcept;
+        TimerWheel(const TimerWheel&) = delete;
+        TimerWheel& operator=(const TimerWheel&) = delete;
+        ~TimerWheel();
+
+        // Reschedules `timer` if already scheduled.
+        void schedule(WheelTimer& timer, Clock::time_point when) noexcept;
+        // No-op if `timer` is not scheduled.
+        void cancel(WheelTimer& timer) noexcept;
+
+        // Expires all timers that are due at `now`, calling
+        // `on_expired(WheelTimer&)` for each. Timer is already unlinked
+        // and can be re-scheduled from the callback.
+        template<typename F>
+        std::size_t advance(Clock::time_point now, F&& on_expired);
+
+        // Lower bound of the next expiration time: either exact
+        // (timer in the lowest level) or the time of next cascade.
+        // Use it as the wait time-out.
+        std::optional<Clock::time_point> next_expiry() const noexcept;
+
+        std::size_t size() const noexcept;
+        bool is_empty() const noexcept;
+        Clock::duration resolution() const noexcept;
+
+    private:
+        // Circular list head.
+        using Slot = detail::TimerLink;
+
+        std::uint64_t to_tick(Clock::time_point time) const noexcept;
+        Clock::time_point to_time(std::uint64_t tick) const noexcept;
+        void link(WheelTimer& timer) noexcept;
+        static void unlink(detail::TimerLink& timer) noexcept;
+        void cascade(std::size_t level) noexcept;
+
+    private:
+        Clock::time_point start_;
+        Clock::duration resolution_;
+        // All timers with expires_tick_ <= current_tick_ are fired.
+        std::uint64_t current_tick_;
+        std::size_t size_;
+        Slot slots_[kLevelsCount][kSlotsCount];
+    };
+} // namespace wi
+
+namespace wi
+{
+    template<typename F>
+    std::size_t TimerWheel::advance(Clock::time_point now, F&& on_expired)
+    {
+        const std::uint64_t now_tick = to_tick(now);
+        std::size_t expired = 0;
+        while (current_tick_ < now_tick)
+        {
+            if (size_ == 0)
+            {
+                // Nothing to cascade or expire; jump straight to now.
+                current_tick_ = now_tick;
+                break;
+            }
+
+            ++current_tick_;
+            // Higher levels first, so cascaded timers get to
+            // lower levels before those are cascaded too.
+            for (std::size_t level = kLevelsCount - 1; level > 0; --level)
+            {
+                const std::uint64_t mask = (std::uint64_t(1) << (kSlotBits * level)) - 1;
+                if ((current_tick_ & mask) == 0)
+                {
+                    cascade(level);
+                }
+            }
+
+            Slot& slot = slots_[0][current_tick_ & (kSlotsCount - 1)];
+            while (slot.next != &slot)
+            {
+                WheelTimer& timer = static_cast<WheelTimer&>(*slot.next);
+                assert((timer.expires_tick_ == current_tick_) && "[Io] Timer in the wrong slot");
+                unlink(timer);
+                --size_;
+                ++expired;
+                on_expired(timer);
+            }
+        }
+        return expired;
+    }
+} // namespace wi
+
+///////////////////////////////////////////////////////////////////////////////
+// Implementation.
+namespace wi
+{
+    /*explicit*/ inline WheelTimer::WheelTimer(PortEntry expired_entry /*= PortEntry()*/) noexcept
+        : entry(expired_entry)
+    {
+    }
+
+    inline WheelTimer::~WheelTimer()
+    {
+        assert(!is_scheduled() && "[Io] Destroying scheduled WheelTimer");
+    }
+
+    inline bool WheelTimer::is_scheduled() const noexcept
+    {
+        return (next != nullptr);
+    }
+
+    /*explicit*/ inline TimerWheel::TimerWheel(Clock::duration resolution /*= 1ms*/
+        , Clock::time_point start /*= Clock::now()*/) noexcept
+        : start_(start)
+        , resolution_((std::max)(resolution, Clock::duration(1)))
+        , current_tick_(0)
+        , size_(0)
+        , slots_()
+    {
+        for (auto& level : slots_)
+        {
+            for (Slot& slot : level)
+            {
+                slot.prev = &slot;
+                slot.next = &slot;
+            }
+        }
+    }
+
+    inline TimerWheel::~TimerWheel()
+    {
+        // Leave timers in not-scheduled state.
+        for (auto& level : slots_)
+        {
+            for (Slot& slot : level)
+            {
+                while (slot.next != &slot)
+                {
+                    unlink(*slot.next);
+                }
+            }
+        }
+    }
+
+    inline std::size_t TimerWheel::size() const noexcept
+    {
+        return size_;
+    }
+
+    inline bool TimerWheel::is_empty() const noexcept
+    {
+        return (size_ == 0);
+    }
+
+    inline TimerWheel::Clock::duration TimerWheel::resolution() const noexcept
+    {
+        return resolution_;
+    }
+
+    inline std::uint64_t TimerWheel::to_tick(Clock::time_point time) const noexcept
+    {
+        if (time <= start_)
+        {
+            return 0;
+        }
+        return std::uint64_t((time - start_) / resolution_);
+    }
+
+    inline TimerWheel::Clock::time_point TimerWheel::to_time(std::uint64_t tick) const noexcept
+    {
+        return (start_ + resolution_ * std::int64_t(tick));
+    }
+
+    inline void TimerWheel::schedule(WheelTimer& timer, Clock::time_point when) noexcept
+    {
+        if (timer.is_scheduled())
+        {
+            unlink(timer);
+            --size_;
+        }
+        // Round up: never fire earlier than asked.
+        std::uint64_t tick = to_tick(when);
+        if (to_time(tick) < when)
+        {
+            ++tick;
+        }
+        constexpr std::uint64_t kMaxDelta = (std::uint64_t(1) << (kSlotBits * kLevelsCount)) - 1;
+        tick = std::clamp(tick, current_tick_ + 1, current_tick_ + kMaxDelta);
+        timer.expires_tick_ = tick;
+        link(timer);
+        ++size_;
+    }
+
+    inline void TimerWheel::cancel(WheelTimer& timer) noexcept
+    {
+        if (timer.is_scheduled())
+        {
+            unlink(timer);
+            --size_;
+        }
+    }
+
+    inline void TimerWheel::link(WheelTimer& timer) noexcept
+    {
+        const std::uint64_t delta = timer.expires_tick_ - current_tick_;
+        std::size_t level = 0;
+        while ((level < (kLevelsCount - 1))
+            && (delta >= (std::uint64_t(1) << (kSlotBits * (level + 1)))))
+        {
+            ++level;
+        }
+        const std::size_t index = std::size_t(timer.expires_tick_ >> (kSlotBits * level)) & (kSlotsCount - 1);
+        Slot& slot = slots_[level][index];
+        timer.next = &slot;
+        timer.prev = slot.prev;
+        slot.prev->next = &timer;
+        slot.prev = &timer;
+    }
+
+    /*static*/ inline void TimerWheel::unlink(detail::TimerLink& timer) noexcept
+    {
+        timer.prev->next = timer.next;
+        timer.next->prev = timer.prev;
+        timer.prev = nullptr;
+        timer.next = nullptr;
+    }
+
+    inline void TimerWheel::cascade(std::size_t level) noexcept
+    {
+        const std::size_t index = std::size_t(current_tick_ >> (kSlotBits * level)) & (kSlotsCount - 1);
+        Slot& slot = slots_[level][index];
+        if (slot.next == &slot)
+        {
+            return;
+        }
+        // Detach whole list first: link() may put timer back to the same level.
+        detail::TimerLink* timer = slot.next;
+        slot.prev->next = nullptr;
+        slot.prev = &slot;
+        slot.next = &slot;
+        while (timer)
+        {
+            detail::TimerLink* next = timer->next;
+            link(static_cast<WheelTimer&>(*timer));
+            timer = next;
+        }
+    }
+
+    inline std::optional<TimerWheel::Clock::time_point> TimerWheel::next_expiry() const noexcept
+    {
+        if (size_ == 0)
+        {
+            return std::nullopt;
+        }
+        // Lowest level holds timers for the rest of its revolution only.
+        const std::uint64_t revolution_end = (current_tick_ | (kSlotsCount - 1)) + 1;
+        for (std::uint64_t tick = current_tick_ + 1; tick < revolution_end; ++tick)
+        {
+            const Slot& slot = slots_[0][tick & (kSlotsCount - 1)];
+            if (slot.next != &slot)
+            {
+                return to_time(tick);
+            }
+        }
+        return to_time(revolution_end);
+    }
+} // namespace wi
@@ -0,0 +1,563 @@
+#pragma once
+#include <win_io/io_completion_port.h>
+#include <win_io/detail/mpmc_queue.h>
+#include <win_io/detail/futex.h>
+#include <win_io/spin_wait_policy.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <system_error>
+#include <thread>
+
+#include <cassert>
+#include <cstdint>
+
+namespace wi::detail
+{
+    struct UserPortThread;
+} // namespace wi::detail
+
+namespace wi
+{
+    // Completion port that lives entirely in user space.
+    // Has the same API as `IoCompletionPort`, but there is no kernel
+    // object behind, so only posted entries are delivered (no devices).
+    // Use it to hop threads/schedule work: post() is lock-free push
+    // plus, only when some thread is parked, a single futex wake.
+    //
+    // Same as I/O Completion Port:
+    //  - idle waiters are woken in LIFO order (most recently parked first)
+    //    to keep caches warm;
+    //  - no more than `concurrent_threads_hint` threads are running at once.
+    //    Thread is "running" after it dequeued anything and until it comes
+    //    back for more (to any wait function of the port) or exits.
+    //    Note: unlike the kernel, we can't know when running thread
+    //    blocks on something else.
+    //
+    // Capacity is bounded; post() fails with `no_buffer_space` when full.
+    class UserCompletionPort
+    {
+    public:
+        static constexpr std::uint32_t kDefaultCapacity = 64 * 1024;
+
+        static std::optional<UserCompletionPort> make(std::error_code& ec) noexcept;
+        static std::optional<UserCompletionPort> make(std::uint32_t concurrent_threads_hint
+            , std::error_code& ec) noexcept;
+        static std::optional<UserCompletionPort> make(std::uint32_t concurrent_threads_hint
+            , std::uint32_t capacity
+            , std::error_code& ec) noexcept;
+
+        // Construct invalid object. Same as moved-from state.
+        explicit UserCompletionPort() noexcept = default;
+        UserCompletionPort(const UserCompletionPort&) = delete;
+        UserCompletionPort& operator=(const UserCompletionPort&) = delete;
+        UserCompletionPort(UserCompletionPort&& rhs) noexcept;
+        UserCompletionPort& operator=(UserCompletionPort&& rhs) noexcept;
+        ~UserCompletionPort();
+
+        void post(const PortEntry& data, std::error_code& ec);
+
+        // Posts `entries` in order, waking up no more than
+        // min(entries, free concurrency slots) parked threads at once.
+        // Returns number of entries posted; on `no_buffer_space`,
+        // the rest is not posted.
+        std::size_t post_many(std::span<const PortEntry> entries, std::error_code& ec);
+
+        // Blocking call.
+        std::optional<PortEntry> get(std::error_code& ec);
+
+        std::span<PortEntry> get_many(std::span<PortEntry> entries_to_write
+            , std::error_code& ec
+            , bool alertable = false);
+
+        // Busy-polls first, blocks only if nothing arrives in time.
+        // See AdaptiveSpinWait.
+        std::span<PortEntry> get_many(std::span<PortEntry> entries_to_write
+            , AdaptiveSpinWait& spin
+            , std::error_code& ec
+            , bool alertable = false);
+
+        // Non-blocking call.
+        std::optional<PortEntry> query(std::error_code& ec);
+
+        std::span<PortEntry> query_many(std::span<PortEntry> entries_to_write
+            , std::error_code& ec
+            , bool alertable = false);
+
+        // Blocking call with time-out.
+        template<typename Rep, typename Period>
+        std::optional<PortEntry> wait_for(std::chrono::duration<Rep, Period> time
+            , std::error_code& ec);
+
+        template<typename Rep, typename Period>
+        std::span<PortEntry> wait_for_many(std::span<PortEntry> entries_to_write
+            , std::chrono::duration<Rep, Period> time
+            , std::error_code& ec
+            , bool alertable = false);
+
+        template<typename Rep, typename Period>
+        std::span<PortEntry> wait_for_many(std::span<PortEntry> entries_to_write
+            , std::chrono::duration<Rep, Period> time
+            , AdaptiveSpinWait& spin
+            , std::error_code& ec
+            , bool alertable = false);
+
+        // Not supported: there is no kernel object to associate with.
+        void associate_device(WinHANDLE device, WinULONG_PTR key
+            , std::error_code& ec);
+
+        void associate_socket(WinSOCKET socket, WinULONG_PTR key
+            , std::error_code& ec);
+
+        // Always nullptr.
+        WinHANDLE native_handle();
+
+    private:
+        friend struct detail::UserPortThread;
+        struct Waiter;
+        struct State;
+
+        std::optional<PortEntry> wait_impl(WinDWORD milliseconds, std::error_code& ec);
+        std::span<PortEntry> wait_many_impl(std::span<PortEntry> entries_to_write
+            , WinDWORD milliseconds
+            , std::error_code& ec);
+        std::size_t try_dequeue(std::span<PortEntry> entries_to_write);
+
+    private:
+        // Shared with running threads, see detail::UserPortThread.
+        std::shared_ptr<State> state_;
+    };
+} // namespace wi
+
+namespace wi
+{
+    template<typename Rep, typename Period>
+    std::optional<PortEntry> UserCompletionPort::wait_for(
+        std::chrono::duration<Rep, Period> time, std::error_code& ec)
+    {
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(time);
+        return wait_impl(static_cast<WinDWORD>(ms.count()), ec);
+    }
+
+    template<typename Rep, typename Period>
+    std::span<PortEntry> UserCompletionPort::wait_for_many(std::span<PortEntry> entries_to_write
+        , std::chrono::duration<Rep, Period> time
+        , std::error_code& ec
+        , bool alertable /*= false*/)
+    {
+        (void)alertable;
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(time);
+        return wait_many_impl(entries_to_write, static_cast<WinDWORD>(ms.count()), ec);
+    }
+
+    template<typename Rep, typename Period>
+    std::span<PortEntry> UserCompletionPort::wait_for_many(std::span<PortEntry> entries_to_write
+        , std::chrono::duration<Rep, Period> time
+        , AdaptiveSpinWait& spin
+        , std::error_code& ec
+        , bool alertable /*= false*/)
+    {
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(time);
+        return spin.wait_many(*this, entries_to_write, static_cast<WinDWORD>(ms.count()), alertable, ec);
+    }
+} // namespace wi
+
+namespace wi
+{
+    struct UserCompletionPort::Waiter
+    {
+        std::atomic<std::uint32_t> signaled{0};
+        Waiter* prev = nullptr;
+        Waiter* next = nullptr;
+    };
+
+    struct UserCompletionPort::State
+    {
+        detail::MPMCQueue<PortEntry> queue;
+        std::uint32_t concurrency;
+        alignas(detail::kCacheLineSize) std::atomic<std::uint32_t> running{0};
+
+        alignas(detail::kCacheLineSize) std::atomic<std::uint32_t> parked_count{0};
+        std::mutex parked_lock;
+        // Top of the stack is the most recently parked thread.
+        Waiter* parked_top = nullptr;
+
+        explicit State(std::uint32_t concurrent_threads, std::uint32_t capacity)
+            : queue(capacity)
+            , concurrency(concurrent_threads)
+        {
+        }
+
+        bool can_run() const;
+        void notify_posted(std::size_t count);
+        void park(Waiter& waiter);
+        bool try_unpark(Waiter& waiter);
+        void wake_up(std::size_t count);
+    };
+} // namespace wi
+
+namespace wi::detail
+{
+    // Tracks which port the thread is running for, see UserCompletionPort.
+    // Port's state is shared, so the thread may exit after
+    // the port was destroyed.
+    struct UserPortThread
+    {
+        using State = UserCompletionPort::State;
+
+        std::shared_ptr<State> state;
+        bool is_running = false;
+
+        ~UserPortThread();
+        void enter(const std::shared_ptr<State>& port_state);
+        // `next_port` - port the thread is going to wait on, if any.
+        // If it's not the one the thread was running for, the thread
+        // gives its slot away: parked thread is woken up to pick up
+        // entries held back by `concurrency`.
+        void leave(const State* next_port = nullptr);
+    };
+
+    inline thread_local UserPortThread tls_user_port_thread;
+
+    inline UserPortThread::~UserPortThread()
+    {
+        leave();
+    }
+
+    inline void UserPortThread::enter(const std::shared_ptr<State>& port_state)
+    {
+        assert(!is_running);
+        if (state != port_state)
+        {
+            state = port_state;
+        }
+        state->running.fetch_add(1, std::memory_order_acq_rel);
+        is_running = true;
+    }
+
+    inline void UserPortThread::leave(const State* next_port /*= nullptr*/)
+    {
+        if (is_running)
+        {
+            state->running.fetch_sub(1, std::memory_order_acq_rel);
+            is_running = false;
+            // Thread was holding one of `concurrency` slots; someone
+            // parked may be waiting for it to pick up queued entries.
+            if ((state.get() != next_port) && !state->queue.is_empty())
+            {
+                state->notify_posted(1);
+            }
+        }
+    }
+} // namespace wi::detail
+
+namespace wi
+{
+
+    /*static*/ inline std::optional<UserCompletionPort> UserCompletionPort::make(std::error_code& ec) noexcept
+    {
+        // As many concurrently running threads as there are processors in the system.
+        return make(0, ec);
+    }
+
+    /*static*/ inline std::optional<UserCompletionPort> UserCompletionPort::make(std::uint32_t concurrent_threads_hint
+        , std::error_code& ec) noexcept
+    {
+        return make(concurrent_threads_hint, kDefaultCapacity, ec);
+    }
+
+    /*static*/ inline std::optional<UserCompletionPort> UserCompletionPort::make(std::uint32_t concurrent_threads_hint
+        , std::uint32_t capacity
+        , std::error_code& ec) noexcept
+    {
+        if (concurrent_threads_hint == 0)
+        {
+            concurrent_threads_hint = (std::max)(1u, std::thread::hardware_concurrency());
+        }
+
+        std::optional<UserCompletionPort> value;
+        UserCompletionPort& o = value.emplace();
+        try
+        {
+            o.state_ = std::make_shared<State>(concurrent_threads_hint, capacity);
+        }
+        catch (const std::bad_alloc&)
+        {
+            ec = std::make_error_code(std::errc::not_enough_memory);
+            return std::nullopt;
+        }
+        ec = std::error_code();
+        return value;
+    }
+
+    inline UserCompletionPort::UserCompletionPort(UserCompletionPort&& rhs) noexcept = default;
+    inline UserCompletionPort& UserCompletionPort::operator=(UserCompletionPort&& rhs) noexcept = default;
+
+    inline UserCompletionPort::~UserCompletionPort()
+    {
+        assert((!state_ || (state_->parked_top == nullptr))
+            && "[Io] UserCompletionPort destroyed while threads are waiting on it");
+    }
+
+    inline void UserCompletionPort::post(const PortEntry& data, std::error_code& ec)
+    {
+        if (!state_->queue.try_push(data))
+        {
+            ec = std::make_error_code(std::errc::no_buffer_space);
+            return;
+        }
+        ec = std::error_code();
+        state_->notify_posted(1);
+    }
+
+    inline std::size_t UserCompletionPort::post_many(std::span<const PortEntry> entries, std::error_code& ec)
+    {
+        ec = std::error_code();
+        std::size_t count = 0;
+        for (; count < entries.size(); ++count)
+        {
+            if (!state_->queue.try_push(entries[count]))
+            {
+                ec = std::make_error_code(std::errc::no_buffer_space);
+                break;
+            }
+        }
+        if (count > 0)
+        {
+            state_->notify_posted(count);
+        }
+        return count;
+    }
+
+
+    inline std::optional<PortEntry> UserCompletionPort::get(std::error_code& ec)
+    {
+        return wait_impl(detail::kWaitInfinite, ec);
+    }
+
+    inline std::span<PortEntry> UserCompletionPort::get_many(std::span<PortEntry> entries_to_write
+        , std::error_code& ec
+        , bool alertable /*= false*/)
+    {
+        (void)alertable;
+        return wait_many_impl(entries_to_write, detail::kWaitInfinite, ec);
+    }
+
+    inline std::span<PortEntry> UserCompletionPort::get_many(std::span<PortEntry> entries_to_write
+        , AdaptiveSpinWait& spin
+        , std::error_code& ec
+        , bool alertable /*= false*/)
+    {
+        return spin.wait_many(*this, entries_to_write, detail::kWaitInfinite, alertable, ec);
+    }
+
+    inline std::optional<PortEntry> UserCompletionPort::query(std::error_code& ec)
+    {
+        return wait_impl(0/*no blocking wait*/, ec);
+    }
+
+    inline std::span<PortEntry> UserCompletionPort::query_many(std::span<PortEntry> entries_to_write
+        , std::error_code& ec
+        , bool alertable /*= false*/)
+    {
+        (void)alertable;
+        return wait_many_impl(entries_to_write, 0/*no blocking wait*/, ec);
+    }
+
+    inline void UserCompletionPort::associate_device(WinHANDLE device, WinULONG_PTR key
+        , std::error_code& ec)
+    {
+        (void)device;
+        (void)key;
+        ec = std::make_error_code(std::errc::operation_not_supported);
+    }
+
+    inline void UserCompletionPort::associate_socket(WinSOCKET socket, WinULONG_PTR key
+        , std::error_code& ec)
+    {
+        (void)socket;
+        (void)key;
+        ec = std::make_error_code(std::errc::operation_not_supported);
+    }
+
+    inline WinHANDLE UserCompletionPort::native_handle()
+    {
+        return nullptr;
+    }
+
+    inline std::optional<PortEntry> UserCompletionPort::wait_impl(
+        WinDWORD milliseconds, std::error_code& ec)
+    {
+        PortEntry data;
+        if (wait_many_impl(std::span<PortEntry>(&data, 1), milliseconds, ec).empty())
+        {
+            return std::nullopt;
+        }
+        return data;
+    }
+
+    inline std::size_t UserCompletionPort::try_dequeue(std::span<PortEntry> entries_to_write)
+    {
+        std::size_t count = 0;
+        while ((count < entries_to_write.size())
+            && state_->queue.try_pop(entries_to_write[count]))
+        {
+            ++count;
+        }
+        return count;
+    }
+
+
+    inline std::span<PortEntry> UserCompletionPort::wait_many_impl(std::span<PortEntry> entries_to_write
+        , WinDWORD milliseconds
+        , std::error_code& ec)
+    {
+        using Clock = std::chrono::steady_clock;
+        const auto deadline = Clock::now() + std::chrono::milliseconds(milliseconds);
+        auto time_left = [&]() -> WinDWORD
+        {
+            if (milliseconds == detail::kWaitInfinite)
+            {
+                return detail::kWaitInfinite;
+            }
+            const auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now());
+            return WinDWORD((std::max)(left.count(), decltype(left.count())(0)));
+        };
+
+        detail::UserPortThread& this_thread = detail::tls_user_port_thread;
+        // Came back to the port (or blocks on this one
+        // instead of the other): not running anymore.
+        this_thread.leave(state_.get());
+
+        while (true)
+        {
+            if (state_->can_run())
+            {
+                if (const std::size_t count = try_dequeue(entries_to_write); count > 0)
+                {
+                    this_thread.enter(state_);
+                    ec = std::error_code();
+                    return entries_to_write.first(count);
+                }
+            }
+
+            WinDWORD wait_ms = time_left();
+            if (wait_ms == 0)
+            {
+                ec = detail::make_timeout_error_code();
+                return entries_to_write.first(0);
+            }
+
+            Waiter waiter;
+            state_->park(waiter);
+            // Pairs with the fence in post().
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (state_->can_run() && !state_->queue.is_empty())
+            {
+                (void)state_->try_unpark(waiter);
+                continue;
+            }
+
+            while (waiter.signaled.load(std::memory_order_acquire) == 0)
+            {
+                if (!detail::FutexWait(waiter.signaled, 0, wait_ms)
+                    || ((wait_ms = time_left()) == 0))
+                {
+                    break;
+                }
+            }
+            if ((waiter.signaled.load(std::memory_order_acquire) == 0)
+                && state_->try_unpark(waiter))
+            {
+                // Timed out and nobody woke us up.
+                ec = detail::make_timeout_error_code();
+                return entries_to_write.first(0);
+            }
+            // Woken up: try to dequeue again.
+        }
+    }
+
+    inline bool UserCompletionPort::State::can_run() const
+    {
+        return (running.load(std::memory_order_acquire) < concurrency);
+    }
+
+    inline void UserCompletionPort::State::notify_posted(std::size_t count)
+    {
+        // Pairs with the fence in wait_many_impl(): either we see
+        // parked thread or parked thread sees pushed entry.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (parked_count.load(std::memory_order_relaxed) == 0)
+        {
+            return;
+        }
+        const std::uint32_t running_now = running.load(std::memory_order_acquire);
+        if (running_now >= concurrency)
+        {
+            return;
+        }
+        wake_up((std::min)(count, std::size_t(concurrency - running_now)));
+    }
+
+    inline void UserCompletionPort::State::park(Waiter& waiter)
+    {
+        std::lock_guard _(parked_lock);
+        waiter.prev = nullptr;
+        waiter.next = parked_top;
+        if (parked_top)
+        {
+            parked_top->prev = &waiter;
+        }
+        parked_top = &waiter;
+        parked_count.fetch_add(1, std::memory_order_seq_cst);
+    }
+
+    // Returns false if `waiter` was already woken up (and removed).
+    inline bool UserCompletionPort::State::try_unpark(Waiter& waiter)
+    {
+        std::lock_guard _(parked_lock);
+        if (waiter.signaled.load(std::memory_order_relaxed) != 0)
+        {
+            return false;
+        }
+        if (waiter.prev)
+        {
+            waiter.prev->next = waiter.next;
+        }
+        else
+        {
+            parked_top = waiter.next;
+        }
+        if (waiter.next)
+        {
+            waiter.next->prev = waiter.prev;
+        }
+        parked_count.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    inline void UserCompletionPort::State::wake_up(std::size_t count)
+    {
+        std::lock_guard _(parked_lock);
+        for (; (count > 0) && parked_top; --count)
+        {
+            Waiter* waiter = parked_top;
+            parked_top = waiter->next;
+            if (waiter->next)
+            {
+                waiter->next->prev = nullptr;
+            }
+            parked_count.fetch_sub(1, std::memory_order_relaxed);
+            waiter->signaled.store(1, std::memory_order_release);
+            // Still under the lock: `waiter` can't leave try_unpark() and
+            // destroy itself, but may return after spurious wake-up.
+            // Waking (possibly reused) address is harmless in that case.
+            detail::FutexWakeOne(waiter->signaled);
+        }
+    }
+} // namespace wi
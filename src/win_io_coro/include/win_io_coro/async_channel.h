@@ -0,0 +1,413 @@
+#pragma once
+#include <win_io_coro/detail/intrusive_queue.h>
+#include <win_io_coro/io_coro_scheduler.h>
+#include <win_io_coro/io_operation_task.h>
+
+#include <coroutine>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <cassert>
+#include <cstddef>
+
+namespace wi
+{
+    namespace coro
+    {
+        // Bounded MPMC channel for coroutines: send() suspends while
+        // the buffer is full, receive() - while it's empty. Value is
+        // handed directly to the waiting receiver, if any; capacity 0
+        // makes send() wait for the receiver (rendezvous).
+        // Waiters are queued intrusively, in FIFO order, and resumed
+        // through the IoScheduler (see IoScheduler::post()), never inline.
+        // 
+        // close(): waiting and new senders fail; receivers get values
+        // left in the buffer, then std::nullopt.
+        template<typename T>
+        class AsyncChannel
+        {
+        public:
+            class SendTask : public detail::IntrusiveQueue<SendTask>::Item
+            {
+            public:
+                explicit SendTask(AsyncChannel& channel, T value);
+                SendTask(SendTask&& rhs) = delete;
+                SendTask& operator=(SendTask&& rhs) = delete;
+                SendTask(const SendTask& rhs) = delete;
+                SendTask& operator=(const SendTask& rhs) = delete;
+
+                bool await_ready() const noexcept;
+                bool await_suspend(std::coroutine_handle<> awaiter) noexcept;
+                // False if the channel is closed (value is dropped).
+                bool await_resume() noexcept;
+
+            private:
+                friend class AsyncChannel;
+                AsyncChannel* channel_;
+                std::optional<T> value_;
+                bool sent_;
+                IoOperationTask operation_;
+            };
+
+            class ReceiveTask : public detail::IntrusiveQueue<ReceiveTask>::Item
+            {
+            public:
+                explicit ReceiveTask(AsyncChannel& channel);
+                ReceiveTask(ReceiveTask&& rhs) = delete;
+                ReceiveTask& operator=(ReceiveTask&& rhs) = delete;
+                ReceiveTask(const ReceiveTask& rhs) = delete;
+                ReceiveTask& operator=(const ReceiveTask& rhs) = delete;
+
+                bool await_ready() const noexcept;
+                bool await_suspend(std::coroutine_handle<> awaiter) noexcept;
+                // std::nullopt if the channel is closed and empty.
+                std::optional<T> await_resume() noexcept;
+
+            private:
+                friend class AsyncChannel;
+                AsyncChannel* channel_;
+                std::optional<T> value_;
+                IoOperationTask operation_;
+            };
+
+        public:
+            explicit AsyncChannel(IoScheduler& scheduler, std::size_t capacity);
+            AsyncChannel(const AsyncChannel& rhs) = delete;
+            AsyncChannel& operator=(const AsyncChannel& rhs) = delete;
+            AsyncChannel(AsyncChannel&& rhs) = delete;
+            AsyncChannel& operator=(AsyncChannel&& rhs) = delete;
+            ~AsyncChannel();
+
+            // Should be used together with co_await.
+            SendTask send(T value);
+            ReceiveTask receive();
+
+            // Never suspend. `value` is moved from only if sent.
+            bool try_send(T& value);
+            std::optional<T> try_receive();
+
+            void close();
+            bool is_closed();
+
+        private:
+            // False if done right away: `task` should not be suspended.
+            bool start_send(SendTask& task);
+            bool start_receive(ReceiveTask& task);
+
+            // Under `lock_`.
+            void push_back(T&& value);
+            T pop_front();
+
+        private:
+            IoScheduler& scheduler_;
+            std::mutex lock_;
+            // Ring buffer of `capacity_` elements.
+            std::vector<std::optional<T>> buffer_;
+            std::size_t capacity_;
+            std::size_t head_;
+            std::size_t size_;
+            bool closed_;
+            // Consumers are serialized by `lock_`.
+            // At any time, either senders or receivers wait, not both.
+            detail::IntrusiveMPSCQueue<SendTask> senders_;
+            detail::IntrusiveMPSCQueue<ReceiveTask> receivers_;
+        };
+
+    } // namespace coro
+} // namespace wi
+
+namespace wi
+{
+    namespace coro
+    {
+
+        template<typename T>
+        /*explicit*/ AsyncChannel<T>::SendTask::SendTask(AsyncChannel& channel, T value)
+            : channel_(&channel)
+            , value_(std::move(value))
+            , sent_(false)
+            , operation_()
+        {
+        }
+
+        template<typename T>
+        bool AsyncChannel<T>::SendTask::await_ready() const noexcept
+        {
+            return false;
+        }
+
+        template<typename T>
+        bool AsyncChannel<T>::SendTask::await_suspend(std::coroutine_handle<> awaiter) noexcept
+        {
+            if (!channel_->start_send(*this))
+            {
+                return false;
+            }
+            // May be received (and posted) already; not suspended then.
+            return operation_.await_suspend(awaiter);
+        }
+
+        template<typename T>
+        bool AsyncChannel<T>::SendTask::await_resume() noexcept
+        {
+            return sent_;
+        }
+
+        template<typename T>
+        /*explicit*/ AsyncChannel<T>::ReceiveTask::ReceiveTask(AsyncChannel& channel)
+            : channel_(&channel)
+            , value_()
+            , operation_()
+        {
+        }
+
+        template<typename T>
+        bool AsyncChannel<T>::ReceiveTask::await_ready() const noexcept
+        {
+            return false;
+        }
+
+        template<typename T>
+        bool AsyncChannel<T>::ReceiveTask::await_suspend(std::coroutine_handle<> awaiter) noexcept
+        {
+            if (!channel_->start_receive(*this))
+            {
+                return false;
+            }
+            // May be sent (and posted) already; not suspended then.
+            return operation_.await_suspend(awaiter);
+        }
+
+        template<typename T>
+        std::optional<T> AsyncChannel<T>::ReceiveTask::await_resume() noexcept
+        {
+            return std::move(value_);
+        }
+
+        template<typename T>
+        /*explicit*/ AsyncChannel<T>::AsyncChannel(IoScheduler& scheduler, std::size_t capacity)
+            : scheduler_(scheduler)
+            , lock_()
+            , buffer_(capacity)
+            , capacity_(capacity)
+            , head_(0)
+            , size_(0)
+            , closed_(false)
+            , senders_()
+            , receivers_()
+        {
+        }
+
+        template<typename T>
+        AsyncChannel<T>::~AsyncChannel()
+        {
+            assert(senders_.is_empty() && receivers_.is_empty()
+                && "Destroying AsyncChannel with waiting coroutines");
+        }
+
+        template<typename T>
+        typename AsyncChannel<T>::SendTask AsyncChannel<T>::send(T value)
+        {
+            return SendTask(*this, std::move(value));
+        }
+
+        template<typename T>
+        typename AsyncChannel<T>::ReceiveTask AsyncChannel<T>::receive()
+        {
+            return ReceiveTask(*this);
+        }
+
+        template<typename T>
+        void AsyncChannel<T>::push_back(T&& value)
+        {
+            assert(size_ < capacity_);
+            buffer_[(head_ + size_) % capacity_].emplace(std::move(value));
+            ++size_;
+        }
+
+        template<typename T>
+        T AsyncChannel<T>::pop_front()
+        {
+            assert(size_ > 0);
+            std::optional<T>& slot = buffer_[head_];
+            T value = std::move(*slot);
+            slot.reset();
+            head_ = (head_ + 1) % capacity_;
+            --size_;
+            return value;
+        }
+
+        template<typename T>
+        bool AsyncChannel<T>::start_send(SendTask& task)
+        {
+            ReceiveTask* receiver = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(lock_);
+                if (closed_)
+                {
+                    task.sent_ = false;
+                    return false;
+                }
+                if (receivers_.pop(receiver))
+                {
+                    // Buffer is empty, hand over directly.
+                    receiver->value_.emplace(std::move(*task.value_));
+                }
+                else if (size_ < capacity_)
+                {
+                    push_back(std::move(*task.value_));
+                }
+                else
+                {
+                    senders_.push(&task);
+                    return true;
+                }
+                task.sent_ = true;
+            }
+            if (receiver)
+            {
+                scheduler_.post(receiver->operation_);
+            }
+            return false;
+        }
+
+        template<typename T>
+        bool AsyncChannel<T>::start_receive(ReceiveTask& task)
+        {
+            SendTask* sender = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(lock_);
+                if (size_ > 0)
+                {
+                    task.value_.emplace(pop_front());
+                    if (senders_.pop(sender))
+                    {
+                        // Free slot for the first waiting sender.
+                        push_back(std::move(*sender->value_));
+                        sender->sent_ = true;
+                    }
+                }
+                else if (senders_.pop(sender))
+                {
+                    // Capacity 0: take directly.
+                    task.value_.emplace(std::move(*sender->value_));
+                    sender->sent_ = true;
+                }
+                else if (!closed_)
+                {
+                    receivers_.push(&task);
+                    return true;
+                }
+                // Otherwise, closed and empty: std::nullopt.
+            }
+            if (sender)
+            {
+                scheduler_.post(sender->operation_);
+            }
+            return false;
+        }
+
+        template<typename T>
+        bool AsyncChannel<T>::try_send(T& value)
+        {
+            ReceiveTask* receiver = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(lock_);
+                if (closed_)
+                {
+                    return false;
+                }
+                if (receivers_.pop(receiver))
+                {
+                    receiver->value_.emplace(std::move(value));
+                }
+                else if (size_ < capacity_)
+                {
+                    push_back(std::move(value));
+                    return true;
+                }
+                else
+                {
+                    return false;
+                }
+            }
+            scheduler_.post(receiver->operation_);
+            return true;
+        }
+
+        template<typename T>
+        std::optional<T> AsyncChannel<T>::try_receive()
+        {
+            std::optional<T> value;
+            SendTask* sender = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(lock_);
+                if (size_ > 0)
+                {
+                    value.emplace(pop_front());
+                    if (senders_.pop(sender))
+                    {
+                        push_back(std::move(*sender->value_));
+                        sender->sent_ = true;
+                    }
+                }
+                else if (senders_.pop(sender))
+                {
+                    value.emplace(std::move(*sender->value_));
+                    sender->sent_ = true;
+                }
+            }
+            if (sender)
+            {
+                scheduler_.post(sender->operation_);
+            }
+            return value;
+        }
+
+        template<typename T>
+        void AsyncChannel<T>::close()
+        {
+            {
+                std::lock_guard<std::mutex> lock(lock_);
+                closed_ = true;
+            }
+            // Don't touch the task once posted: it may be resumed
+            // (and destroyed) right away.
+            while (true)
+            {
+                SendTask* sender = nullptr;
+                {
+                    std::lock_guard<std::mutex> lock(lock_);
+                    if (!senders_.pop(sender))
+                    {
+                        break;
+                    }
+                    sender->sent_ = false;
+                }
+                scheduler_.post(sender->operation_);
+            }
+            while (true)
+            {
+                ReceiveTask* receiver = nullptr;
+                {
+                    std::lock_guard<std::mutex> lock(lock_);
+                    if (!receivers_.pop(receiver))
+                    {
+                        break;
+                    }
+                }
+                scheduler_.post(receiver->operation_);
+            }
+        }
+
+        template<typename T>
+        bool AsyncChannel<T>::is_closed()
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            return closed_;
+        }
+
+    } // namespace coro
+} // namespace wi
@@ -0,0 +1,71 @@
+#pragma once
+#include <win_io_coro/detail/intrusive_queue.h>
+#include <win_io_coro/io_operation_task.h>
+
+#include <coroutine>
+#include <mutex>
+
+namespace wi
+{
+    namespace coro
+    {
+        class IoScheduler;
+        class AsyncMutex;
+
+        // Awaitable returned by AsyncMutex::lock().
+        class LockTask : public detail::IntrusiveQueue<LockTask>::Item
+        {
+        public:
+            explicit LockTask(AsyncMutex& mutex);
+            LockTask(LockTask&& rhs) = delete;
+            LockTask& operator=(LockTask&& rhs) = delete;
+            LockTask(const LockTask& rhs) = delete;
+            LockTask& operator=(const LockTask& rhs) = delete;
+
+            bool await_ready() noexcept;
+            bool await_suspend(std::coroutine_handle<> awaiter) noexcept;
+            void await_resume() noexcept;
+
+        private:
+            friend class AsyncMutex;
+            AsyncMutex* mutex_;
+            IoOperationTask operation_;
+        };
+
+        // Mutex for coroutines: co_await lock() suspends, instead of
+        // blocking the thread, while the mutex is locked. Not recursive.
+        // Waiters are queued intrusively, in FIFO order. unlock() hands
+        // the ownership to the first waiter directly and resumes it
+        // through the IoScheduler (see IoScheduler::post()), never inline.
+        // Ownership is not bound to the thread: coroutine may be
+        // resumed on other thread while holding the lock.
+        class AsyncMutex
+        {
+        public:
+            explicit AsyncMutex(IoScheduler& scheduler);
+            AsyncMutex(const AsyncMutex& rhs) = delete;
+            AsyncMutex& operator=(const AsyncMutex& rhs) = delete;
+            AsyncMutex(AsyncMutex&& rhs) = delete;
+            AsyncMutex& operator=(AsyncMutex&& rhs) = delete;
+            ~AsyncMutex();
+
+            // Should be used together with co_await.
+            LockTask lock();
+            bool try_lock();
+            void unlock();
+
+        private:
+            friend class LockTask;
+            // False if locked: `task` should not be suspended.
+            bool add(LockTask& task);
+
+        private:
+            IoScheduler& scheduler_;
+            std::mutex lock_;
+            bool locked_;
+            // Consumers are serialized by `lock_`.
+            detail::IntrusiveMPSCQueue<LockTask> waiters_;
+        };
+
+    } // namespace coro
+} // namespace wi
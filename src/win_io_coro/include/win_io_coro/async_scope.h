@@ -0,0 +1,189 @@
+#pragma once
+#include <win_io_coro/frame_pool.h>
+#include <win_io_coro/io_operation_task.h>
+
+#include <atomic>
+#include <concepts>
+#include <coroutine>
+#include <exception>
+#include <stop_token>
+#include <type_traits>
+#include <utility>
+
+#include <cstddef>
+
+namespace wi
+{
+    namespace coro
+    {
+        class IoScheduler;
+        class AsyncScope;
+
+        namespace detail
+        {
+            // Coroutine that co_awaits single spawned awaitable and reports
+            // to AsyncScope once finished. Starts immediately, destroys
+            // itself at the end (same as DetachedTask). Frame is from FramePool.
+            struct ScopeChild
+            {
+                struct promise_type : PooledFrame
+                {
+                    struct FinalAwaiter
+                    {
+                        bool await_ready() const noexcept;
+                        void await_suspend(std::coroutine_handle<promise_type> coro) noexcept;
+                        void await_resume() const noexcept;
+                    };
+
+                    // Gets coroutine's arguments: AsyncScope is the first one.
+                    template<typename... Args>
+                    explicit promise_type(AsyncScope& scope, Args&...) noexcept;
+
+                    ScopeChild get_return_object() noexcept;
+                    std::suspend_never initial_suspend() noexcept;
+                    FinalAwaiter final_suspend() noexcept;
+                    void return_void() noexcept;
+                    void unhandled_exception() noexcept;
+
+                    AsyncScope* scope_;
+                };
+            };
+
+            template<typename Awaitable>
+            ScopeChild run_scope_awaitable(AsyncScope& scope, Awaitable awaitable);
+
+            // `function` is kept in the frame, so lambda's captures
+            // outlive the coroutine it returns.
+            template<typename Function>
+            ScopeChild run_scope_function(AsyncScope& scope, Function function);
+        } // namespace detail
+
+        // Awaitable returned by AsyncScope::join().
+        class JoinTask
+        {
+        public:
+            explicit JoinTask(AsyncScope& scope);
+            JoinTask(JoinTask&& rhs) = delete;
+            JoinTask& operator=(JoinTask&& rhs) = delete;
+            JoinTask(const JoinTask& rhs) = delete;
+            JoinTask& operator=(const JoinTask& rhs) = delete;
+
+            bool await_ready() const noexcept;
+            bool await_suspend(std::coroutine_handle<> awaiter) noexcept;
+            void await_resume() noexcept;
+
+        private:
+            friend class AsyncScope;
+            AsyncScope* scope_;
+            IoOperationTask operation_;
+        };
+
+        // Owner of detached ("fire-and-forget") coroutines, e.g., one per
+        // connection: spawn() starts the work without waiting for it,
+        // the scope only counts live children. Child frames are from
+        // FramePool; nothing else is allocated per child.
+        // 
+        // request_stop() reaches every child through get_stop_token()
+        // (pass it down to IoScheduler::get(), AsyncFile::read(), ...);
+        // spawn() fails after. co_await join() resumes once all children
+        // finished, through the IoScheduler. To shut down:
+        //   scope.request_stop(); co_await scope.join();
+        // 
+        // Exception that escapes the child terminates the program.
+        class AsyncScope
+        {
+        public:
+            explicit AsyncScope(IoScheduler& scheduler);
+            AsyncScope(const AsyncScope& rhs) = delete;
+            AsyncScope& operator=(const AsyncScope& rhs) = delete;
+            AsyncScope(AsyncScope&& rhs) = delete;
+            AsyncScope& operator=(AsyncScope&& rhs) = delete;
+            // All children must be finished (see join()).
+            ~AsyncScope();
+
+            // Starts `work` right away. `work` is either awaitable
+            // (e.g., Task<>, its result is ignored) or function invoked
+            // with get_stop_token() that returns one.
+            // False (nothing is started) once stop is requested.
+            // Thread-safe. Children may spawn more children, even
+            // while join() is in progress, but not after it's finished.
+            template<typename Work>
+            bool spawn(Work&& work);
+
+            // Should be used together with co_await. Once.
+            JoinTask join();
+
+            void request_stop() noexcept;
+            bool stop_requested() const noexcept;
+            std::stop_token get_stop_token() const noexcept;
+
+            // Children that are not finished yet.
+            // Approximate: may be stale once returned.
+            std::size_t live() const noexcept;
+
+        private:
+            friend class JoinTask;
+            friend struct detail::ScopeChild::promise_type::FinalAwaiter;
+            // False if stop is requested.
+            bool add_child() noexcept;
+            void on_child_finished() noexcept;
+
+        private:
+            IoScheduler& scheduler_;
+            std::stop_source stop_source_;
+            // Children + 1, until join() is awaited:
+            // whoever brings it to 0 resumes `joiner_`.
+            std::atomic<std::size_t> count_;
+            std::atomic<std::size_t> live_;
+            JoinTask* joiner_;
+        };
+
+    } // namespace coro
+} // namespace wi
+
+namespace wi
+{
+    namespace coro
+    {
+        namespace detail
+        {
+            template<typename... Args>
+            /*explicit*/ ScopeChild::promise_type::promise_type(AsyncScope& scope, Args&...) noexcept
+                : scope_(&scope)
+            {
+            }
+
+            template<typename Awaitable>
+            ScopeChild run_scope_awaitable(AsyncScope& scope, Awaitable awaitable)
+            {
+                (void)scope;
+                (void)co_await std::move(awaitable);
+            }
+
+            template<typename Function>
+            ScopeChild run_scope_function(AsyncScope& scope, Function function)
+            {
+                (void)co_await function(scope.get_stop_token());
+            }
+        } // namespace detail
+
+        template<typename Work>
+        bool AsyncScope::spawn(Work&& work)
+        {
+            if (!add_child())
+            {
+                return false;
+            }
+            if constexpr (std::invocable<std::decay_t<Work>&, std::stop_token>)
+            {
+                (void)detail::run_scope_function(*this, std::decay_t<Work>(std::forward<Work>(work)));
+            }
+            else
+            {
+                (void)detail::run_scope_awaitable(*this, std::decay_t<Work>(std::forward<Work>(work)));
+            }
+            return true;
+        }
+
+    } // namespace coro
+} // namespace wi
@@ -0,0 +1,73 @@
+#pragma once
+#include <win_io_coro/detail/intrusive_queue.h>
+#include <win_io_coro/io_operation_task.h>
+
+#include <coroutine>
+#include <mutex>
+
+#include <cstddef>
+
+namespace wi
+{
+    namespace coro
+    {
+        class IoScheduler;
+        class AsyncSemaphore;
+
+        // Awaitable returned by AsyncSemaphore::acquire().
+        class AcquireTask : public detail::IntrusiveQueue<AcquireTask>::Item
+        {
+        public:
+            explicit AcquireTask(AsyncSemaphore& semaphore);
+            AcquireTask(AcquireTask&& rhs) = delete;
+            AcquireTask& operator=(AcquireTask&& rhs) = delete;
+            AcquireTask(const AcquireTask& rhs) = delete;
+            AcquireTask& operator=(const AcquireTask& rhs) = delete;
+
+            bool await_ready() noexcept;
+            bool await_suspend(std::coroutine_handle<> awaiter) noexcept;
+            void await_resume() noexcept;
+
+        private:
+            friend class AsyncSemaphore;
+            AsyncSemaphore* semaphore_;
+            IoOperationTask operation_;
+        };
+
+        // Counting semaphore for coroutines, e.g., to limit queue depth.
+        // Waiters are queued intrusively, in FIFO order. release() hands
+        // the permit to the first waiter directly and resumes it through
+        // the IoScheduler (see IoScheduler::post()), never inline.
+        class AsyncSemaphore
+        {
+        public:
+            explicit AsyncSemaphore(IoScheduler& scheduler, std::size_t count);
+            AsyncSemaphore(const AsyncSemaphore& rhs) = delete;
+            AsyncSemaphore& operator=(const AsyncSemaphore& rhs) = delete;
+            AsyncSemaphore(AsyncSemaphore&& rhs) = delete;
+            AsyncSemaphore& operator=(AsyncSemaphore&& rhs) = delete;
+            ~AsyncSemaphore();
+
+            // Should be used together with co_await.
+            AcquireTask acquire();
+            bool try_acquire();
+            void release(std::size_t count = 1);
+
+            // Approximate: may be stale once returned.
+            std::size_t available();
+
+        private:
+            friend class AcquireTask;
+            // False if acquired: `task` should not be suspended.
+            bool add(AcquireTask& task);
+
+        private:
+            IoScheduler& scheduler_;
+            std::mutex lock_;
+            std::size_t count_;
+            // Consumers are serialized by `lock_`.
+            detail::IntrusiveMPSCQueue<AcquireTask> waiters_;
+        };
+
+    } // namespace coro
+} // namespace wi
@@ -1,8 +1,15 @@
 #pragma once
 #include <win_io/io_completion_port.h>
+#include <win_io/io_operation.h>
+#include <win_io_coro/detail/slab_free_list.h>
+#include <win_io_coro/sector_buffer_pool.h>
 
 #include <system_error>
 #include <coroutine>
+#include <atomic>
+#include <optional>
+#include <stop_token>
+#include <thread>
 
 #include <cassert>
 
@@ -12,10 +19,12 @@ namespace wi::coro
 {
     class AsyncFile;
 
+    // Data of the completed read: part of the sector-aligned block
+    // that was read; the block goes back to the pool on destruction.
     class ReadBuffer
     {
     public:
-        explicit ReadBuffer(std::uint8_t* pages_start, std::uint64_t user_offset, std::uint64_t user_size);
+        explicit ReadBuffer(SectorBuffer block, std::uint64_t user_offset, std::uint64_t user_size);
         std::span<std::uint8_t> GetData() const noexcept;
 
     public:
@@ -27,7 +36,7 @@ namespace wi::coro
         ~ReadBuffer();
 
     private:
-        std::uint8_t* _pages_start = nullptr;
+        SectorBuffer _block;
         std::uint64_t _user_offset = 0;
         std::uint64_t _user_size = 0;
     };
@@ -40,10 +49,21 @@ namespace wi::coro
 
     // Can't be destroyed while read is in progress.
     // It's possible to cancel & block in destructor if needed.
+    //
+    // Read that finishes synchronously (file is opened with
+    // FILE_SKIP_COMPLETION_PORT_ON_SUCCESS, so cached reads complete
+    // inside ReadFile()) is reported with on_end() while still inside
+    // await_suspend(); in that case the awaiter is not suspended at all
+    // (await_suspend() returns false) instead of being resumed from there,
+    // so loops of such reads don't grow the stack.
+    // 
+    // With std::stop_token, stop request cancels the read in progress
+    // (see cancel()); the awaiter gets std::errc::operation_canceled.
     class AsyncReadTask
     {
     public:
-        explicit AsyncReadTask(AsyncFile& file, std::uint64_t offset, std::uint32_t size);
+        explicit AsyncReadTask(AsyncFile& file, std::uint64_t offset, std::uint32_t size
+            , std::stop_token stop_token = {});
 
         AsyncReadTask(AsyncReadTask&& rhs) = delete;
         AsyncReadTask& operator=(AsyncReadTask&& rhs) = delete;
@@ -54,6 +74,17 @@ namespace wi::coro
         bool await_suspend(std::coroutine_handle<> awaiter) noexcept;
         ReadResult await_resume() noexcept;
 
+        // Best effort: asks the system to cancel the read in progress
+        // (CancelIoEx()); the awaiter is resumed as usual, with
+        // ERROR_OPERATION_ABORTED if cancelled indeed. Thread-safe.
+        // Used by when_any() for the losers.
+        void cancel() noexcept;
+
+        // Called when the read is issued.
+        void on_start(WinOVERLAPPED* overlapped) noexcept;
+        // Called before the read's OVERLAPPED is freed: waits
+        // for cancel() that may still use it.
+        void release_overlapped() noexcept;
         // Called by the IOCP scheduler.
         void on_end(std::error_code ec, ReadBuffer data);
 
@@ -64,18 +95,49 @@ namespace wi::coro
         std::error_code _error;
         ReadBuffer _data;
         std::coroutine_handle<> _awaiter;
+
+        enum class State
+        {
+            Pending,
+            Suspended,
+            Completed,
+        };
+        std::atomic<State> _state;
+        // In-flight read, for cancel().
+        std::atomic<WinOVERLAPPED*> _overlapped;
+        // cancel() calls that may use `_overlapped`.
+        std::atomic<std::uint32_t> _cancels_running;
+
+        struct OnStop
+        {
+            AsyncReadTask* _task;
+            void operator()() const noexcept;
+        };
+
+        std::stop_token _stop_token;
+        std::atomic<bool> _stop_requested;
+        // Registered while the read is in progress (till await_resume()).
+        std::optional<std::stop_callback<OnStop>> _on_stop;
     };
 
+    // Read buffers are from SectorBufferPool::shared(), unless
+    // other pool is given (must outlive the file and its buffers).
     class AsyncFile
     {
     public:
         static AsyncFile open(IoCompletionPort& iocp
             , const char* file_path
             , std::error_code& ec);
+        static AsyncFile open(IoCompletionPort& iocp
+            , const char* file_path
+            , SectorBufferPool& buffers_pool
+            , std::error_code& ec);
 
         HANDLE native_handle() const;
         std::uint64_t file_size() const;
+        SectorBufferPool& buffers_pool() const;
         AsyncReadTask read(std::uint64_t offset, std::uint32_t size);
+        AsyncReadTask read(std::uint64_t offset, std::uint32_t size, std::stop_token stop_token);
 
         AsyncFile(const AsyncFile&) = delete;
         AsyncFile& operator=(const AsyncFile&) = delete;
@@ -87,13 +149,15 @@ namespace wi::coro
         static constexpr ULONG_PTR kAsyncIOCPFileKey = 42;
 
     private:
-        explicit AsyncFile(HANDLE handle, IoCompletionPort& iocp, std::uint64_t file_size);
+        explicit AsyncFile(HANDLE handle, IoCompletionPort& iocp
+            , std::uint64_t file_size, SectorBufferPool& buffers_pool);
         void close_file();
 
     private:
         HANDLE _file_handle;
         IoCompletionPort* _iocp;
         std::uint64_t _file_size;
+        SectorBufferPool* _buffers_pool;
     };
 
     std::size_t HandleIOCP_Once(IoCompletionPort& iocp);
@@ -113,9 +177,17 @@ namespace wi::coro
         }
     } // namespace wi
 
-    /*static*/ AsyncFile AsyncFile::open(IoCompletionPort& iocp
+    /*static*/ inline AsyncFile AsyncFile::open(IoCompletionPort& iocp
         , const char* file_path
         , std::error_code& ec)
+    {
+        return open(iocp, file_path, SectorBufferPool::shared(), ec);
+    }
+
+    /*static*/ inline AsyncFile AsyncFile::open(IoCompletionPort& iocp
+        , const char* file_path
+        , SectorBufferPool& buffers_pool
+        , std::error_code& ec)
     {
         const HANDLE handle = ::CreateFileA(file_path
             , GENERIC_READ
@@ -124,7 +196,7 @@ namespace wi::coro
             , OPEN_EXISTING
             , FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED | FILE_FLAG_NO_BUFFERING
             , nullptr);
-        AsyncFile file(handle, iocp, 0); // close on early return.
+        AsyncFile file(handle, iocp, 0, buffers_pool); // close on early return.
         if (handle == INVALID_HANDLE_VALUE)
         {
             ec = detail::make_last_error_code();
@@ -155,10 +227,12 @@ namespace wi::coro
         return file;
     }
 
-    /*explicit*/ inline AsyncFile::AsyncFile(HANDLE handle, IoCompletionPort& iocp, std::uint64_t file_size)
-        : _file_handle(handle)
-        , _iocp(&iocp)
-        , _file_size(file_size)
+    /*explicit*/ inline AsyncFile::AsyncFile(HANDLE handle, IoCompletionPort& iocp
+        , std::uint64_t file_size, SectorBufferPool& buffers_pool)
+            : _file_handle(handle)
+            , _iocp(&iocp)
+            , _file_size(file_size)
+            , _buffers_pool(&buffers_pool)
     {
     }
 
@@ -182,6 +256,7 @@ namespace wi::coro
         : _file_handle(std::exchange(rhs._file_handle, INVALID_HANDLE_VALUE))
         , _iocp(std::exchange(rhs._iocp, nullptr))
         , _file_size(std::exchange(rhs._file_size, 0))
+        , _buffers_pool(rhs._buffers_pool)
     {
     }
 
@@ -193,6 +268,7 @@ namespace wi::coro
             _file_handle = std::exchange(rhs._file_handle, INVALID_HANDLE_VALUE);
             _iocp = std::exchange(rhs._iocp, nullptr);
             _file_size = std::exchange(rhs._file_size, 0);
+            _buffers_pool = rhs._buffers_pool;
         }
         return *this;
     }
@@ -207,16 +283,36 @@ namespace wi::coro
         return _file_size;
     }
 
+    inline SectorBufferPool& AsyncFile::buffers_pool() const
+    {
+        return *_buffers_pool;
+    }
+
     inline AsyncReadTask AsyncFile::read(std::uint64_t offset, std::uint32_t size)
     {
         return AsyncReadTask(*this, offset, size);
     }
 
+    inline AsyncReadTask AsyncFile::read(std::uint64_t offset, std::uint32_t size, std::stop_token stop_token)
+    {
+        return AsyncReadTask(*this, offset, size, std::move(stop_token));
+    }
+
     /*explicit*/ inline AsyncReadTask::AsyncReadTask(AsyncFile& file
-        , std::uint64_t offset, std::uint32_t size)
+        , std::uint64_t offset, std::uint32_t size
+        , std::stop_token stop_token /*= {}*/)
             : _file(&file)
             , _offset(offset)
             , _size(size)
+            , _error()
+            , _data()
+            , _awaiter()
+            , _state(State::Pending)
+            , _overlapped(nullptr)
+            , _cancels_running(0)
+            , _stop_token(std::move(stop_token))
+            , _stop_requested(false)
+            , _on_stop()
     {
     }
 
@@ -228,21 +324,72 @@ namespace wi::coro
 
     inline ReadResult AsyncReadTask::await_resume() noexcept
     {
+        // Nothing to cancel anymore. Waits for the stop callback
+        // that runs on other thread right now, if any.
+        _on_stop.reset();
         return ReadResult{_error, std::move(_data)};
     }
 
     inline void AsyncReadTask::on_end(std::error_code ec, ReadBuffer data)
     {
         assert(_awaiter);
+        if (ec && _stop_requested.load(std::memory_order_acquire))
+        {
+            // Most likely ERROR_OPERATION_ABORTED, report as such.
+            ec = std::make_error_code(std::errc::operation_canceled);
+        }
         _error = ec;
         _data = std::move(data);
-        _awaiter.resume();
+        assert(!_overlapped.load(std::memory_order_relaxed));
+        // Pending: still inside await_suspend(), which will see
+        // Completed and continue the awaiter without suspending.
+        if (_state.exchange(State::Completed, std::memory_order_acq_rel) == State::Suspended)
+        {
+            _awaiter.resume();
+        }
+    }
+
+    inline void AsyncReadTask::on_start(WinOVERLAPPED* overlapped) noexcept
+    {
+        _overlapped.store(overlapped, std::memory_order_release);
+    }
+
+    inline void AsyncReadTask::release_overlapped() noexcept
+    {
+        // Pairs with cancel(): either it sees no OVERLAPPED,
+        // or we see it running and wait.
+        _overlapped.store(nullptr, std::memory_order_seq_cst);
+        while (_cancels_running.load(std::memory_order_seq_cst) != 0)
+        {
+            std::this_thread::yield();
+        }
     }
 
-    /*explicit*/ inline ReadBuffer::ReadBuffer(std::uint8_t* pages_start
+    inline void AsyncReadTask::cancel() noexcept
+    {
+        // OVERLAPPED is not freed while the counter is non-0
+        // (see release_overlapped()).
+        _cancels_running.fetch_add(1, std::memory_order_seq_cst);
+        // May race with the completion: then OVERLAPPED is not
+        // in-flight anymore and CancelIoEx() finds nothing to cancel.
+        WinOVERLAPPED* overlapped = _overlapped.load(std::memory_order_seq_cst);
+        if (overlapped)
+        {
+            (void)::CancelIoEx(_file->native_handle(), reinterpret_cast<LPOVERLAPPED>(overlapped));
+        }
+        _cancels_running.fetch_sub(1, std::memory_order_release);
+    }
+
+    inline void AsyncReadTask::OnStop::operator()() const noexcept
+    {
+        _task->_stop_requested.store(true, std::memory_order_release);
+        _task->cancel();
+    }
+
+    /*explicit*/ inline ReadBuffer::ReadBuffer(SectorBuffer block
         , std::uint64_t user_offset
         , std::uint64_t user_size)
-            : _pages_start(pages_start)
+            : _block(std::move(block))
             , _user_offset(user_offset)
             , _user_size(user_size)
     {
@@ -250,16 +397,16 @@ namespace wi::coro
 
     inline std::span<std::uint8_t> ReadBuffer::GetData() const noexcept
     {
-        assert(_pages_start);
-        return std::span<std::uint8_t>(_pages_start + _user_offset, std::size_t(_user_size));
+        assert(_block);
+        assert((_user_offset + _user_size) <= _block.size());
+        return std::span<std::uint8_t>(_block.data() + _user_offset, std::size_t(_user_size));
     }
 
     inline ReadBuffer& ReadBuffer::operator=(ReadBuffer&& rhs) noexcept
     {
         if (this != &rhs)
         {
-            this->~ReadBuffer();
-            _pages_start = std::exchange(rhs._pages_start, nullptr);
+            _block = std::move(rhs._block);
             _user_offset = std::exchange(rhs._user_offset, 0);
             _user_size = std::exchange(rhs._user_size, 0);
         }
@@ -267,20 +414,13 @@ namespace wi::coro
     }
 
     inline ReadBuffer::ReadBuffer(ReadBuffer&& rhs) noexcept
-        : _pages_start(std::exchange(rhs._pages_start, nullptr))
+        : _block(std::move(rhs._block))
         , _user_offset(std::exchange(rhs._user_offset, 0))
         , _user_size(std::exchange(rhs._user_size, 0))
     {
     }
 
-    inline ReadBuffer::~ReadBuffer()
-    {
-        if (_pages_start)
-        {
-            (void)::VirtualFree(_pages_start, 0, MEM_RELEASE);
-            _pages_start = nullptr;
-        }
-    }
+    inline ReadBuffer::~ReadBuffer() = default;
 
     // #XXX: temporary. Use API to know for real.
     constexpr std::uint64_t kSectorSize = 4 * 1024;
@@ -314,59 +454,62 @@ namespace wi::coro
         }
     };
 
-    template<std::size_t Alignment>
-    static std::uint8_t* GetAligned(std::uint8_t* base)
-    {
-        static_assert(std::has_single_bit(Alignment)); // power of 2.
-        assert(base);
-
-        constexpr std::uintptr_t mask = ~static_cast<std::uintptr_t>(Alignment - 1);
-        const std::uintptr_t memory = (reinterpret_cast<std::uintptr_t>(base) + Alignment - 1) & mask;
-        std::uint8_t* const ptr = reinterpret_cast<std::uint8_t*>(memory);
-        assert((std::uint64_t(ptr) % Alignment) == 0);
-        return ptr;
-    }
-
-    struct SingleReadOverlapped : OVERLAPPED
+    // Request state of the read in progress. Kept apart from the read
+    // buffer, in the compact array (slab) of such records: the buffer
+    // is sector-aligned data only.
+    struct SingleReadOverlapped : IoOperation
     {
         std::uint64_t _user_offset; // #
         std::uint64_t _user_size;   // # Not needed. Stored in `AsyncReadTask* _callback`.
-        std::uint8_t* _pages_start;
-        std::uint64_t _overlapped_size;
+        SectorBuffer _buffer;
         AsyncReadTask* _callback;
 
-        SingleReadOverlapped()
-            : OVERLAPPED()
+        explicit SingleReadOverlapped(SectorBuffer buffer)
+            : IoOperation(&SingleReadOverlapped::OnComplete, this)
             , _user_offset(0)
             , _user_size(0)
-            , _pages_start(nullptr)
-            , _overlapped_size(0)
+            , _buffer(std::move(buffer))
             , _callback(nullptr)
         {
         }
 
         ~SingleReadOverlapped() = default;
 
-        std::uint8_t* GetReadBufferStart() const
+        static detail::SlabFreeList& Records()
         {
-            return (_pages_start + _overlapped_size);
+            // Never destroyed: reads may complete during static destruction.
+            static detail::SlabFreeList* const records = new detail::SlabFreeList(
+                sizeof(SingleReadOverlapped), alignof(SingleReadOverlapped), 256);
+            return *records;
         }
 
-        static SingleReadOverlapped* EmplaceIntoPage(std::uint8_t* pages_start, std::uint64_t overlapped_size)
+        static void* operator new(std::size_t size)
         {
-            assert(pages_start);
-            std::uint8_t* ptr = GetAligned<alignof(SingleReadOverlapped)>(pages_start);
-            assert((ptr + sizeof(SingleReadOverlapped)) <= (ptr + overlapped_size));
-            auto* ovs = new(static_cast<void*>(ptr)) SingleReadOverlapped();
-            ovs->_pages_start = pages_start;
-            ovs->_overlapped_size = overlapped_size;
-            return ovs;
+            assert(size == sizeof(SingleReadOverlapped));
+            (void)size;
+            return Records().allocate();
         }
 
-        void InvokeReadEnd(DWORD read_bytes)
+        static void operator delete(void* ptr, std::size_t size) noexcept
         {
-            std::printf("ok\n");
+            (void)size;
+            Records().deallocate(ptr);
+        }
 
+        static void OnComplete(void* user_data, const PortEntry& entry, std::error_code ec)
+        {
+            auto* self = static_cast<SingleReadOverlapped*>(user_data);
+            assert(entry.overlapped == self->overlapped());
+            if (ec)
+            {
+                self->InvokeReadFail(DWORD(ec.value()));
+                return;
+            }
+            self->InvokeReadEnd(DWORD(entry.bytes_transferred));
+        }
+
+        void InvokeReadEnd(DWORD read_bytes)
+        {
             if (Internal != 0)
             {
                 InvokeReadFail(DWORD(Internal));
@@ -391,14 +534,14 @@ namespace wi::coro
                 return;
             }
 
-            ReadBuffer buffer(_pages_start
-                // There is `_overlapped_size` region reserved for the request;
-                // only then there is read buffer start. Which contains
-                // `delta` bytes of unneeded read.
-                , (_overlapped_size + delta)
+            ReadBuffer buffer(std::move(_buffer)
+                // Read buffer start contains `delta` bytes of unneeded read.
+                , delta
                 , _user_size);
             AsyncReadTask* callback = _callback;
-            this->~SingleReadOverlapped();
+            // Slab reuses the record: no cancel() can see it afterwards.
+            callback->release_overlapped();
+            delete this;
             // DONT touch any member now.
 
             callback->on_end(std::error_code(), std::move(buffer));
@@ -406,11 +549,10 @@ namespace wi::coro
 
         void InvokeReadFail(DWORD last_error)
         {
-            std::printf("error\n");
-
             AsyncReadTask* callback = _callback;
-            (void)::VirtualFree(_pages_start, 0, MEM_RELEASE);
-            this->~SingleReadOverlapped();
+            callback->release_overlapped();
+            // Buffer goes back to the pool.
+            delete this;
             // DONT touch any member now.
 
             callback->on_end(wi::detail::make_last_error_code(last_error), ReadBuffer{});
@@ -431,6 +573,7 @@ namespace wi::coro
     }
 
     static std::error_code ScheduleReadImpl_(HANDLE file
+        , SectorBufferPool& buffers_pool
         , std::uint64_t user_offset
         , std::uint64_t user_size
         , AsyncReadTask& on_finish)
@@ -439,46 +582,29 @@ namespace wi::coro
         assert(user_size != 0);
         assert(user_offset <= MaxReadSizePerSingleCall());
 
-        // Reserve page(s) for OVERLAPPED/request management bookkeeping.
-        std::uint64_t overlapped_size = sizeof(SingleReadOverlapped);
-        static_assert((kSectorSize % alignof(SingleReadOverlapped)) == 0);
-#if (0)
-        if ((kSectorSize % alignof(SingleReadOverlapped)) != 0)
-        {
-            // Additional memory to compensate alignment.
-            overlapped_size += (alignof(SingleReadOverlapped) - 1);
-        }
-#endif
-        // Waste whole page anyway.
-        overlapped_size = Roundup(overlapped_size, kSectorSize);
+        // #XXX: logical and/or physical sector size needed.
+        assert((buffers_pool.sector_size() % kSectorSize) == 0);
 
         const auto io_size = SizeOffsetBySector::FromAnyOffsetAndSize(user_offset, user_size);
-        const SIZE_T all_memory = SIZE_T(io_size._size + overlapped_size);
-        std::uint8_t* pages_start = static_cast<std::uint8_t*>(
-            ::VirtualAlloc(nullptr
-                , all_memory
-                , MEM_COMMIT
-                , PAGE_READWRITE));
-        assert(pages_start);
-        // #XXX: system's page size granularity. May not match to logical
-        // and/or physical sector size needed.
-        assert((std::uint64_t(pages_start) % kSectorSize) == 0);
+        // Pooled: no VirtualAlloc()/page faults per read.
+        SectorBuffer buffer = buffers_pool.allocate(std::size_t(io_size._size));
+        assert((std::uint64_t(buffer.data()) % kSectorSize) == 0);
 
         const ULARGE_INTEGER offset{ .QuadPart = io_size._offset };
-        auto* ov = SingleReadOverlapped::EmplaceIntoPage(pages_start, overlapped_size);
-        ov->Offset = offset.LowPart;
-        ov->OffsetHigh = offset.HighPart;
+        auto* ov = new SingleReadOverlapped(std::move(buffer));
+        ov->_.Offset = offset.LowPart;
+        ov->_.OffsetHigh = offset.HighPart;
         ov->hEvent = nullptr;
         ov->_callback = &on_finish;
         ov->_user_offset = user_offset;
         ov->_user_size = user_size;
+        on_finish.on_start(ov->overlapped());
 
-        std::printf("started\n");
         const BOOL read_finished = ::ReadFile(file
-            , ov->GetReadBufferStart()
+            , ov->_buffer.data()
             , DWORD(io_size._size)
             , nullptr
-            , ov);
+            , reinterpret_cast<LPOVERLAPPED>(ov->overlapped()));
         const DWORD last_error = ::GetLastError();
         if (read_finished)
         {
@@ -488,16 +614,35 @@ namespace wi::coro
         {
             ov->InvokeReadFail(last_error);
         }
-
-        std::printf("schedule end\n");
         return std::error_code();
     }
 
-    bool AsyncReadTask::await_suspend(std::coroutine_handle<> awaiter) noexcept
+    inline bool AsyncReadTask::await_suspend(std::coroutine_handle<> awaiter) noexcept
     {
         _awaiter = awaiter;
-        _error = ScheduleReadImpl_(_file->native_handle(), _offset, _size, *this);
-        return (not _error);
+        _state.store(State::Pending, std::memory_order_relaxed);
+        if (_stop_token.stop_requested())
+        {
+            _error = std::make_error_code(std::errc::operation_canceled);
+            return false;
+        }
+        // Do not overwrite _error: on_end() may already set it.
+        const std::error_code ec = ScheduleReadImpl_(_file->native_handle()
+            , _file->buffers_pool(), _offset, _size, *this);
+        if (ec)
+        {
+            _error = ec;
+            return false;
+        }
+        // Safe to touch *this: the awaiter is not resumed until Suspended.
+        // Invoked right away if stop is requested already.
+        if (_stop_token.stop_possible())
+        {
+            _on_stop.emplace(_stop_token, OnStop{this});
+        }
+        State expected = State::Pending;
+        return _state.compare_exchange_strong(expected, State::Suspended
+            , std::memory_order_acq_rel);
     }
 
     // Temporary, as an example of how to handle.
@@ -506,28 +651,9 @@ namespace wi::coro
         std::error_code ec;
 
         PortEntry entries[64];
-        auto ready = iocp.get_many(entries, ec);
-        if (ec)
-        {
-            for (PortEntry& entry : ready)
-            {
-                assert(entry.completion_key == AsyncFile::kAsyncIOCPFileKey);
-                assert(entry.overlapped);
-                auto* ov = static_cast<SingleReadOverlapped*>(entry.overlapped);
-                ov->InvokeReadFail(ec.value());
-            }
-        }
-        else
-        {
-            for (PortEntry& entry : ready)
-            {
-                assert(entry.completion_key == AsyncFile::kAsyncIOCPFileKey);
-                assert(entry.overlapped);
-                auto* ov = static_cast<SingleReadOverlapped*>(entry.overlapped);
-                ov->InvokeReadEnd(DWORD(entry.bytes_transferred));
-            }
-        }
-        return ready.size();
+        // Each entry's OVERLAPPED is SingleReadOverlapped (IoOperation)
+        // that knows how to complete itself; no key checks needed.
+        return wi::dispatch(iocp.get_many(entries, ec), ec);
     }
 
 } // namespace wi::coro
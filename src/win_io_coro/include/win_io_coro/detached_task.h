@@ -0,0 +1,46 @@
+#pragma once
+#include <win_io_coro/frame_pool.h>
+
+#include <coroutine>
+#include <exception>
+
+namespace wi
+{
+    namespace coro
+    {
+        // Coroutine that starts immediately and destroys itself once
+        // finished; nothing to wait for. Useful to spawn many short
+        // coroutines: frame is allocated from FramePool.
+        // Exception that escapes the coroutine terminates the program.
+        struct DetachedTask
+        {
+            struct promise_type : PooledFrame
+            {
+                DetachedTask get_return_object() noexcept
+                {
+                    return {};
+                }
+
+                std::suspend_never initial_suspend() noexcept
+                {
+                    return {};
+                }
+
+                std::suspend_never final_suspend() noexcept
+                {
+                    return {};
+                }
+
+                void return_void() noexcept
+                {
+                }
+
+                void unhandled_exception() noexcept
+                {
+                    std::terminate();
+                }
+            };
+        };
+
+    } // namespace coro
+} // namespace wi
@@ -11,6 +11,9 @@ namespace wi
     {
         namespace detail
         {
+            template<typename T>
+            class IntrusiveMPSCQueue;
+
             // Lock-free, intrusive, non-owning queue.
             // (Thread-safe pointers-like container).
             // 
@@ -25,6 +28,7 @@ namespace wi
                 {
                 private:
                     friend class IntrusiveQueue;
+                    friend class IntrusiveMPSCQueue<T>;
                     T* next = nullptr;
                 };
 
@@ -43,6 +47,57 @@ namespace wi
             private:
                 std::atomic<T*> head_;
             };
+
+            // Same as IntrusiveQueue, but for single consumer at a time
+            // (multiple producers). Uses same `IntrusiveQueue<T>::Item`.
+            // 
+            // pop() takes all pushed elements with single exchange()
+            // and reverses them into consumer-private FIFO list,
+            // so draining N elements is O(N) instead of O(N^2)
+            // (amortized O(1) per pop(); no CAS loop on the consumer side).
+            // 
+            // Consumers must be serialized by the caller.
+            // push() and taking of pushed elements are seq_cst, so they
+            // can be ordered with caller's seq_cst operations
+            // (see IoScheduler::add()).
+            template<typename T>
+            class IntrusiveMPSCQueue
+            {
+            public:
+                using Item = typename IntrusiveQueue<T>::Item;
+
+                IntrusiveMPSCQueue();
+                IntrusiveMPSCQueue(const IntrusiveMPSCQueue& rhs) = delete;
+                IntrusiveMPSCQueue& operator=(const IntrusiveMPSCQueue& rhs) = delete;
+                IntrusiveMPSCQueue(IntrusiveMPSCQueue&& rhs) = delete;
+                IntrusiveMPSCQueue& operator=(IntrusiveMPSCQueue&& rhs) = delete;
+
+                // Thread-safe.
+                void push(T* value);
+                // Consumer only.
+                bool pop(T*& value);
+                // Consumer only. Unlinks `value` if it's in the queue.
+                // O(N), each element is visited once: for rare events,
+                // like cancellation.
+                bool remove(T* value);
+
+                // Consumer only (or when there are no producers).
+                bool is_empty() const;
+
+            private:
+                // Moves all pushed elements to the end of consumer list.
+                void take_pushed();
+                // Unlinks `value` from consumer list, searching after
+                // `prev` (from the start if nullptr).
+                bool unlink_after(T* prev, T* value);
+
+            private:
+                // LIFO stack of pushed elements.
+                std::atomic<T*> head_;
+                // FIFO list of elements taken from `head_`, oldest first.
+                T* consumer_head_;
+                T* consumer_tail_;
+            };
         } // namespace detail
     } // namespace coro
 } // namespace wi
@@ -128,6 +183,126 @@ namespace wi
                 return true;
             }
 
+            template<typename T>
+            IntrusiveMPSCQueue<T>::IntrusiveMPSCQueue()
+                : head_(nullptr)
+                , consumer_head_(nullptr)
+                , consumer_tail_(nullptr)
+            {
+                static_assert(std::is_base_of<Item, T>::value,
+                    "T should be derived from IntrusiveQueue<T>::Item to stored in the queue");
+            }
+
+            template<typename T>
+            bool IntrusiveMPSCQueue<T>::is_empty() const
+            {
+                return (consumer_head_ == nullptr)
+                    && (head_.load(std::memory_order_acquire) == nullptr);
+            }
+
+            template<typename T>
+            void IntrusiveMPSCQueue<T>::push(T* value)
+            {
+                assert(value);
+                T* head = head_.load(std::memory_order_relaxed);
+                do
+                {
+                    value->next = head;
+                }
+                while (!head_.compare_exchange_weak(
+                    head,
+                    value,
+                    std::memory_order_seq_cst,
+                    std::memory_order_relaxed));
+            }
+
+            template<typename T>
+            void IntrusiveMPSCQueue<T>::take_pushed()
+            {
+                T* stack = head_.exchange(nullptr, std::memory_order_seq_cst);
+                if (!stack)
+                {
+                    return;
+                }
+                // Reverse: most recently pushed element is on top of the stack.
+                T* const last = stack;
+                T* pushed = nullptr;
+                while (stack)
+                {
+                    T* next = stack->next;
+                    stack->next = pushed;
+                    pushed = stack;
+                    stack = next;
+                }
+                if (consumer_tail_)
+                {
+                    consumer_tail_->next = pushed;
+                }
+                else
+                {
+                    consumer_head_ = pushed;
+                }
+                consumer_tail_ = last;
+            }
+
+            template<typename T>
+            bool IntrusiveMPSCQueue<T>::pop(T*& value)
+            {
+                if (!consumer_head_)
+                {
+                    take_pushed();
+                }
+
+                value = consumer_head_;
+                if (!value)
+                {
+                    return false;
+                }
+                consumer_head_ = value->next;
+                if (!consumer_head_)
+                {
+                    consumer_tail_ = nullptr;
+                }
+                value->next = nullptr;
+                return true;
+            }
+
+            template<typename T>
+            bool IntrusiveMPSCQueue<T>::remove(T* value)
+            {
+                assert(value);
+                if (unlink_after(nullptr, value))
+                {
+                    return true;
+                }
+                // Not taken yet: search pushed elements only.
+                T* const taken_tail = consumer_tail_;
+                take_pushed();
+                return unlink_after(taken_tail, value);
+            }
+
+            template<typename T>
+            bool IntrusiveMPSCQueue<T>::unlink_after(T* prev, T* value)
+            {
+                T** link = (prev ? &prev->next : &consumer_head_);
+                while (*link)
+                {
+                    if (*link == value)
+                    {
+                        *link = value->next;
+                        if (consumer_tail_ == value)
+                        {
+                            consumer_tail_ = prev;
+                        }
+                        value->next = nullptr;
+                        return true;
+                    }
+                    prev = *link;
+                    link = &(prev->next);
+                }
+                return false;
+            }
+
         } // namespace detail
     } // namespace coro
 } // namespace wi
@@ -0,0 +1,106 @@
+#pragma once
+#include <win_io/detail/mpmc_queue.h>
+
+#include <span>
+
+#include <cassert>
+#include <cstddef>
+
+namespace wi
+{
+    namespace coro
+    {
+        namespace detail
+        {
+            // Bounded, lock-free, non-owning MPMC queue of pointers.
+            // Alternative to IntrusiveQueue for fixed-capacity hot paths:
+            // push/pop cost does not depend on the number of elements,
+            // producers and consumers touch different cache lines
+            // and no memory is allocated after construction.
+            // 
+            // Elements do not need to be derived from anything,
+            // but push fails when the queue is full.
+            template<typename T>
+            class RingQueue
+            {
+            public:
+                // Rounded up to the power of 2.
+                explicit RingQueue(std::size_t capacity);
+                RingQueue(const RingQueue& rhs) = delete;
+                RingQueue& operator=(const RingQueue& rhs) = delete;
+                RingQueue(RingQueue&& rhs) = delete;
+                RingQueue& operator=(RingQueue&& rhs) = delete;
+
+                // False if full. May fail spuriously, see wi::detail::MPMCQueue.
+                bool try_push(T* value) noexcept;
+                // False if empty.
+                bool try_pop(T*& value) noexcept;
+
+                // Push/pop as much as possible, in order; return the count.
+                std::size_t try_push_many(std::span<T* const> values) noexcept;
+                std::size_t try_pop_many(std::span<T*> values) noexcept;
+
+                // Approximate: may be stale once returned.
+                bool is_empty() const noexcept;
+                std::size_t capacity() const noexcept;
+
+            private:
+                wi::detail::MPMCQueue<T*> queue_;
+            };
+        } // namespace detail
+    } // namespace coro
+} // namespace wi
+
+namespace wi
+{
+    namespace coro
+    {
+        namespace detail
+        {
+
+            template<typename T>
+            /*explicit*/ RingQueue<T>::RingQueue(std::size_t capacity)
+                : queue_(capacity)
+            {
+            }
+
+            template<typename T>
+            bool RingQueue<T>::try_push(T* value) noexcept
+            {
+                assert(value);
+                return queue_.try_push(value);
+            }
+
+            template<typename T>
+            bool RingQueue<T>::try_pop(T*& value) noexcept
+            {
+                return queue_.try_pop(value);
+            }
+
+            template<typename T>
+            std::size_t RingQueue<T>::try_push_many(std::span<T* const> values) noexcept
+            {
+                return queue_.try_push_many(values);
+            }
+
+            template<typename T>
+            std::size_t RingQueue<T>::try_pop_many(std::span<T*> values) noexcept
+            {
+                return queue_.try_pop_many(values);
+            }
+
+            template<typename T>
+            bool RingQueue<T>::is_empty() const noexcept
+            {
+                return queue_.is_empty();
+            }
+
+            template<typename T>
+            std::size_t RingQueue<T>::capacity() const noexcept
+            {
+                return queue_.capacity();
+            }
+
+        } // namespace detail
+    } // namespace coro
+} // namespace wi
@@ -0,0 +1,54 @@
+#pragma once
+#include <mutex>
+#include <vector>
+
+#include <cstddef>
+
+namespace wi
+{
+    namespace coro
+    {
+        namespace detail
+        {
+            // Fixed-size blocks carved from big slabs (contiguous arrays
+            // of `blocks_per_slab` blocks). Freed block goes to the free
+            // list (link is stored in the block itself) and is reused;
+            // slabs are released by the destructor only.
+            // Thread-safe: free list is guarded by the mutex.
+            class SlabFreeList
+            {
+            public:
+                // `block_size` should be a multiple of `alignment`.
+                explicit SlabFreeList(std::size_t block_size
+                    , std::size_t alignment
+                    , std::size_t blocks_per_slab);
+                SlabFreeList(const SlabFreeList& rhs) = delete;
+                SlabFreeList& operator=(const SlabFreeList& rhs) = delete;
+                SlabFreeList(SlabFreeList&& rhs) = delete;
+                SlabFreeList& operator=(SlabFreeList&& rhs) = delete;
+                // All blocks should be deallocated.
+                ~SlabFreeList();
+
+                // Throws std::bad_alloc if new slab can't be allocated.
+                void* allocate();
+                void deallocate(void* block) noexcept;
+
+                std::size_t block_size() const noexcept;
+                std::size_t slabs_count();
+
+            private:
+                struct FreeBlock
+                {
+                    FreeBlock* next;
+                };
+
+                std::mutex lock_;
+                FreeBlock* free_;
+                std::vector<void*> slabs_;
+                std::size_t block_size_;
+                std::size_t alignment_;
+                std::size_t blocks_per_slab_;
+            };
+        } // namespace detail
+    } // namespace coro
+} // namespace wi
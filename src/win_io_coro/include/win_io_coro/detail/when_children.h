@@ -0,0 +1,565 @@
+#pragma once
+#include <win_io_coro/frame_pool.h>
+
+#include <atomic>
+#include <concepts>
+#include <coroutine>
+#include <exception>
+#include <limits>
+#include <optional>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+// Shared implementation of when_all() and when_any().
+
+namespace wi
+{
+    namespace coro
+    {
+        // Result of when_any() over the range of awaitables.
+        template<typename T>
+        struct WhenAnyResult
+        {
+            // Index of the first finished awaitable.
+            std::size_t index;
+            T value;
+        };
+
+        namespace detail
+        {
+            template<typename Awaitable>
+            decltype(auto) get_awaiter(Awaitable&& awaitable);
+
+            template<typename T>
+            concept Awaitable = requires(T& value)
+            {
+                { detail::get_awaiter(value).await_ready() } -> std::convertible_to<bool>;
+            };
+
+            // Awaitable that can be asked to finish earlier
+            // (when it lost when_any()).
+            template<typename T>
+            concept Cancellable = requires(T& value)
+            {
+                value.cancel();
+            };
+
+            template<typename Awaitable>
+            using AwaitResult = decltype(detail::get_awaiter(std::declval<Awaitable&>()).await_resume());
+
+            // void results are returned as std::monostate.
+            template<typename T>
+            using NonVoid = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+            // State of single when_all()/when_any(), shared by the children.
+            // The only thing the children do on finish is decrement
+            // single counter; the last one resumes the awaiter.
+            class WhenState
+            {
+            public:
+                static constexpr std::size_t kNoWinner = (std::numeric_limits<std::size_t>::max)();
+                // Cancels all children, except `winner`.
+                using CancelFunction = void (*)(void* context, std::size_t winner);
+
+                // `cancel` is for when_any() only.
+                explicit WhenState(std::size_t children_count
+                    , CancelFunction cancel = nullptr
+                    , void* cancel_context = nullptr) noexcept;
+                WhenState(const WhenState& rhs) = delete;
+                WhenState& operator=(const WhenState& rhs) = delete;
+
+                // Called by the awaiter once all children are started.
+                // False if all of them finished already (don't suspend).
+                bool suspend(std::coroutine_handle<> awaiter) noexcept;
+                // Called by the child once finished. Returns
+                // the awaiter to resume if it's the last one.
+                std::coroutine_handle<> on_finished(std::size_t index) noexcept;
+
+                std::size_t winner() const noexcept;
+
+            private:
+                // Cancel losers once there is the winner and all children
+                // are started: whoever of the two comes second.
+                // Both keep their share of `count_` while cancelling,
+                // so the awaiter can't be resumed (and children destroyed).
+                void open_cancel_gate() noexcept;
+
+            private:
+                // Children + awaiter.
+                std::atomic<std::size_t> count_;
+                std::coroutine_handle<> awaiter_;
+                std::atomic<std::size_t> winner_;
+                std::atomic<std::uint32_t> cancel_gate_;
+                CancelFunction cancel_;
+                void* cancel_context_;
+            };
+
+            // Coroutine that co_awaits single child awaitable
+            // and reports to WhenState. Frame is from FramePool.
+            template<typename T>
+            class WhenChild
+            {
+            public:
+                using Value = NonVoid<T>;
+
+                struct promise_type : PooledFrame
+                {
+                    struct FinalAwaiter
+                    {
+                        bool await_ready() const noexcept;
+                        std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> coro) noexcept;
+                        void await_resume() const noexcept;
+                    };
+
+                    WhenChild get_return_object() noexcept;
+                    std::suspend_always initial_suspend() noexcept;
+                    FinalAwaiter final_suspend() noexcept;
+                    void return_value(Value value);
+                    void unhandled_exception() noexcept;
+
+                    WhenState* state_ = nullptr;
+                    std::size_t index_ = 0;
+                    std::optional<Value> value_;
+                    std::exception_ptr exception_;
+                };
+
+            public:
+                WhenChild() noexcept = default;
+                WhenChild(WhenChild&& rhs) noexcept;
+                WhenChild& operator=(WhenChild&& rhs) noexcept;
+                WhenChild(const WhenChild& rhs) = delete;
+                WhenChild& operator=(const WhenChild& rhs) = delete;
+                ~WhenChild();
+
+                void start(WhenState& state, std::size_t index);
+                void rethrow_if_failed() const;
+                // Rethrows child's exception, if any.
+                Value take();
+
+            private:
+                explicit WhenChild(std::coroutine_handle<promise_type> coro) noexcept;
+
+            private:
+                std::coroutine_handle<promise_type> coro_;
+            };
+
+            template<typename Awaitable>
+            WhenChild<AwaitResult<Awaitable>> make_when_child(Awaitable& awaitable);
+
+            template<typename Awaitable>
+            void cancel_child(Awaitable& awaitable);
+
+            // Fixed set of (possibly different) awaitables.
+            // Each one is either referenced (lvalue) or owned (rvalue).
+            template<typename... Awaitables>
+            class WhenTuple
+            {
+            public:
+                using AllResult = std::tuple<NonVoid<AwaitResult<std::remove_reference_t<Awaitables>>>...>;
+                using AnyResult = std::variant<NonVoid<AwaitResult<std::remove_reference_t<Awaitables>>>...>;
+
+                explicit WhenTuple(Awaitables&&... awaitables);
+
+                std::size_t size() const noexcept;
+                void start(WhenState& state);
+                void cancel(std::size_t winner);
+                AllResult all_result();
+                AnyResult any_result(std::size_t winner);
+
+            private:
+                template<std::size_t... Is>
+                void start_impl(WhenState& state, std::index_sequence<Is...>);
+                template<std::size_t... Is>
+                void cancel_impl(std::size_t winner, std::index_sequence<Is...>);
+                template<std::size_t... Is>
+                AllResult all_result_impl(std::index_sequence<Is...>);
+                template<std::size_t I>
+                AnyResult any_result_impl(std::size_t winner);
+
+            private:
+                std::tuple<Awaitables...> awaitables_;
+                std::tuple<WhenChild<AwaitResult<std::remove_reference_t<Awaitables>>>...> children_;
+            };
+
+            // Range of awaitables of the same type; not owned.
+            template<typename Awaitable>
+            class WhenRange
+            {
+            public:
+                using Value = NonVoid<AwaitResult<Awaitable>>;
+                using AllResult = std::vector<Value>;
+                using AnyResult = WhenAnyResult<Value>;
+
+                explicit WhenRange(std::span<Awaitable> awaitables);
+
+                std::size_t size() const noexcept;
+                void start(WhenState& state);
+                void cancel(std::size_t winner);
+                AllResult all_result();
+                AnyResult any_result(std::size_t winner);
+
+            private:
+                std::span<Awaitable> awaitables_;
+                std::vector<WhenChild<AwaitResult<Awaitable>>> children_;
+            };
+
+        } // namespace detail
+    } // namespace coro
+} // namespace wi
+
+namespace wi
+{
+    namespace coro
+    {
+        namespace detail
+        {
+
+            template<typename Awaitable>
+            decltype(auto) get_awaiter(Awaitable&& awaitable)
+            {
+                if constexpr (requires { std::forward<Awaitable>(awaitable).operator co_await(); })
+                {
+                    return std::forward<Awaitable>(awaitable).operator co_await();
+                }
+                else
+                {
+                    return std::forward<Awaitable>(awaitable);
+                }
+            }
+
+            /*explicit*/ inline WhenState::WhenState(std::size_t children_count
+                , CancelFunction cancel /*= nullptr*/
+                , void* cancel_context /*= nullptr*/) noexcept
+                    : count_(children_count + 1)
+                    , awaiter_()
+                    , winner_(kNoWinner)
+                    , cancel_gate_(2)
+                    , cancel_(cancel)
+                    , cancel_context_(cancel_context)
+            {
+            }
+
+            inline bool WhenState::suspend(std::coroutine_handle<> awaiter) noexcept
+            {
+                awaiter_ = awaiter;
+                if (cancel_)
+                {
+                    open_cancel_gate();
+                }
+                return (count_.fetch_sub(1, std::memory_order_acq_rel) != 1);
+            }
+
+            inline std::coroutine_handle<> WhenState::on_finished(std::size_t index) noexcept
+            {
+                if (cancel_)
+                {
+                    std::size_t expected = kNoWinner;
+                    if (winner_.compare_exchange_strong(expected, index, std::memory_order_acq_rel))
+                    {
+                        open_cancel_gate();
+                    }
+                }
+                if (count_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    return awaiter_;
+                }
+                return std::noop_coroutine();
+            }
+
+            inline std::size_t WhenState::winner() const noexcept
+            {
+                return winner_.load(std::memory_order_acquire);
+            }
+
+            inline void WhenState::open_cancel_gate() noexcept
+            {
+                if (cancel_gate_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    cancel_(cancel_context_, winner());
+                }
+            }
+
+            template<typename T>
+            bool WhenChild<T>::promise_type::FinalAwaiter::await_ready() const noexcept
+            {
+                return false;
+            }
+
+            template<typename T>
+            std::coroutine_handle<> WhenChild<T>::promise_type::FinalAwaiter::await_suspend(
+                std::coroutine_handle<promise_type> coro) noexcept
+            {
+                promise_type& promise = coro.promise();
+                return promise.state_->on_finished(promise.index_);
+            }
+
+            template<typename T>
+            void WhenChild<T>::promise_type::FinalAwaiter::await_resume() const noexcept
+            {
+            }
+
+            template<typename T>
+            WhenChild<T> WhenChild<T>::promise_type::get_return_object() noexcept
+            {
+                return WhenChild(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            template<typename T>
+            std::suspend_always WhenChild<T>::promise_type::initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            template<typename T>
+            typename WhenChild<T>::promise_type::FinalAwaiter WhenChild<T>::promise_type::final_suspend() noexcept
+            {
+                return {};
+            }
+
+            template<typename T>
+            void WhenChild<T>::promise_type::return_value(Value value)
+            {
+                value_.emplace(std::move(value));
+            }
+
+            template<typename T>
+            void WhenChild<T>::promise_type::unhandled_exception() noexcept
+            {
+                exception_ = std::current_exception();
+            }
+
+            template<typename T>
+            /*explicit*/ WhenChild<T>::WhenChild(std::coroutine_handle<promise_type> coro) noexcept
+                : coro_(coro)
+            {
+            }
+
+            template<typename T>
+            WhenChild<T>::WhenChild(WhenChild&& rhs) noexcept
+                : coro_(std::exchange(rhs.coro_, nullptr))
+            {
+            }
+
+            template<typename T>
+            WhenChild<T>& WhenChild<T>::operator=(WhenChild&& rhs) noexcept
+            {
+                if (this != &rhs)
+                {
+                    if (coro_)
+                    {
+                        coro_.destroy();
+                    }
+                    coro_ = std::exchange(rhs.coro_, nullptr);
+                }
+                return *this;
+            }
+
+            template<typename T>
+            WhenChild<T>::~WhenChild()
+            {
+                if (coro_)
+                {
+                    coro_.destroy();
+                }
+            }
+
+            template<typename T>
+            void WhenChild<T>::start(WhenState& state, std::size_t index)
+            {
+                assert(coro_);
+                coro_.promise().state_ = &state;
+                coro_.promise().index_ = index;
+                coro_.resume();
+            }
+
+            template<typename T>
+            void WhenChild<T>::rethrow_if_failed() const
+            {
+                assert(coro_ && coro_.done());
+                if (coro_.promise().exception_)
+                {
+                    std::rethrow_exception(coro_.promise().exception_);
+                }
+            }
+
+            template<typename T>
+            typename WhenChild<T>::Value WhenChild<T>::take()
+            {
+                rethrow_if_failed();
+                assert(coro_.promise().value_);
+                return std::move(*coro_.promise().value_);
+            }
+
+            template<typename Awaitable>
+            WhenChild<AwaitResult<Awaitable>> make_when_child(Awaitable& awaitable)
+            {
+                if constexpr (std::is_void_v<AwaitResult<Awaitable>>)
+                {
+                    co_await awaitable;
+                    co_return std::monostate();
+                }
+                else
+                {
+                    co_return co_await awaitable;
+                }
+            }
+
+            template<typename Awaitable>
+            void cancel_child(Awaitable& awaitable)
+            {
+                if constexpr (Cancellable<Awaitable>)
+                {
+                    awaitable.cancel();
+                }
+            }
+
+            template<typename... Awaitables>
+            /*explicit*/ WhenTuple<Awaitables...>::WhenTuple(Awaitables&&... awaitables)
+                : awaitables_(std::forward<Awaitables>(awaitables)...)
+                , children_()
+            {
+            }
+
+            template<typename... Awaitables>
+            std::size_t WhenTuple<Awaitables...>::size() const noexcept
+            {
+                return sizeof...(Awaitables);
+            }
+
+            template<typename... Awaitables>
+            void WhenTuple<Awaitables...>::start(WhenState& state)
+            {
+                start_impl(state, std::index_sequence_for<Awaitables...>());
+            }
+
+            template<typename... Awaitables>
+            template<std::size_t... Is>
+            void WhenTuple<Awaitables...>::start_impl(WhenState& state, std::index_sequence<Is...>)
+            {
+                ((std::get<Is>(children_) = make_when_child(std::get<Is>(awaitables_))), ...);
+                (std::get<Is>(children_).start(state, Is), ...);
+            }
+
+            template<typename... Awaitables>
+            void WhenTuple<Awaitables...>::cancel(std::size_t winner)
+            {
+                cancel_impl(winner, std::index_sequence_for<Awaitables...>());
+            }
+
+            template<typename... Awaitables>
+            template<std::size_t... Is>
+            void WhenTuple<Awaitables...>::cancel_impl(std::size_t winner, std::index_sequence<Is...>)
+            {
+                ((Is != winner ? cancel_child(std::get<Is>(awaitables_)) : void()), ...);
+            }
+
+            template<typename... Awaitables>
+            typename WhenTuple<Awaitables...>::AllResult WhenTuple<Awaitables...>::all_result()
+            {
+                return all_result_impl(std::index_sequence_for<Awaitables...>());
+            }
+
+            template<typename... Awaitables>
+            template<std::size_t... Is>
+            typename WhenTuple<Awaitables...>::AllResult WhenTuple<Awaitables...>::all_result_impl(
+                std::index_sequence<Is...>)
+            {
+                // First exception, in input order.
+                (std::get<Is>(children_).rethrow_if_failed(), ...);
+                return AllResult(std::get<Is>(children_).take()...);
+            }
+
+            template<typename... Awaitables>
+            typename WhenTuple<Awaitables...>::AnyResult WhenTuple<Awaitables...>::any_result(std::size_t winner)
+            {
+                return any_result_impl<0>(winner);
+            }
+
+            template<typename... Awaitables>
+            template<std::size_t I>
+            typename WhenTuple<Awaitables...>::AnyResult WhenTuple<Awaitables...>::any_result_impl(std::size_t winner)
+            {
+                if constexpr ((I + 1) < sizeof...(Awaitables))
+                {
+                    if (winner != I)
+                    {
+                        return any_result_impl<I + 1>(winner);
+                    }
+                }
+                assert(winner == I);
+                return AnyResult(std::in_place_index<I>, std::get<I>(children_).take());
+            }
+
+            template<typename Awaitable>
+            /*explicit*/ WhenRange<Awaitable>::WhenRange(std::span<Awaitable> awaitables)
+                : awaitables_(awaitables)
+                , children_()
+            {
+            }
+
+            template<typename Awaitable>
+            std::size_t WhenRange<Awaitable>::size() const noexcept
+            {
+                return awaitables_.size();
+            }
+
+            template<typename Awaitable>
+            void WhenRange<Awaitable>::start(WhenState& state)
+            {
+                children_.reserve(awaitables_.size());
+                for (Awaitable& awaitable : awaitables_)
+                {
+                    children_.push_back(make_when_child(awaitable));
+                }
+                for (std::size_t i = 0; i < children_.size(); ++i)
+                {
+                    children_[i].start(state, i);
+                }
+            }
+
+            template<typename Awaitable>
+            void WhenRange<Awaitable>::cancel(std::size_t winner)
+            {
+                for (std::size_t i = 0; i < awaitables_.size(); ++i)
+                {
+                    if (i != winner)
+                    {
+                        cancel_child(awaitables_[i]);
+                    }
+                }
+            }
+
+            template<typename Awaitable>
+            typename WhenRange<Awaitable>::AllResult WhenRange<Awaitable>::all_result()
+            {
+                for (const auto& child : children_)
+                {
+                    child.rethrow_if_failed();
+                }
+                AllResult results;
+                results.reserve(children_.size());
+                for (auto& child : children_)
+                {
+                    results.push_back(child.take());
+                }
+                return results;
+            }
+
+            template<typename Awaitable>
+            typename WhenRange<Awaitable>::AnyResult WhenRange<Awaitable>::any_result(std::size_t winner)
+            {
+                assert(winner < children_.size());
+                return AnyResult{winner, children_[winner].take()};
+            }
+
+        } // namespace detail
+    } // namespace coro
+} // namespace wi
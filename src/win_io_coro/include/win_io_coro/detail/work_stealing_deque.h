@@ -0,0 +1,208 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace wi
+{
+    namespace coro
+    {
+        namespace detail
+        {
+            // Chase-Lev work-stealing deque of non-owning pointers.
+            // Single owner thread pushes and pops at the bottom (LIFO),
+            // any other thread steals from the top (FIFO).
+            // 
+            // Note: based on "Correct and Efficient Work-Stealing for
+            // Weak Memory Models" (Le, Pop, Cohen, Nardelli, 2013),
+            // with seq_cst operations instead of standalone fences
+            // (TSan does not model fences).
+            // 
+            // Grows when full; old arrays are kept until destruction
+            // since thieves may still read from them.
+            template<typename T>
+            class WorkStealingDeque
+            {
+            public:
+                explicit WorkStealingDeque(std::size_t capacity = 64);
+                WorkStealingDeque(const WorkStealingDeque& rhs) = delete;
+                WorkStealingDeque& operator=(const WorkStealingDeque& rhs) = delete;
+                WorkStealingDeque(WorkStealingDeque&& rhs) = delete;
+                WorkStealingDeque& operator=(WorkStealingDeque&& rhs) = delete;
+
+                // Owner only.
+                void push(T* value);
+                // Owner only. False if empty.
+                bool pop(T*& value);
+                // Any thread. False if empty or if lost the race
+                // for the top element to other thief/owner.
+                bool steal(T*& value);
+
+                // Approximate: may be stale once returned.
+                bool is_empty() const;
+
+            private:
+                struct Array
+                {
+                    explicit Array(std::int64_t capacity);
+
+                    T* get(std::int64_t index) const;
+                    void put(std::int64_t index, T* value);
+
+                    const std::int64_t mask;
+                    std::unique_ptr<std::atomic<T*>[]> cells;
+                };
+
+                Array* grow(Array* array, std::int64_t top, std::int64_t bottom);
+
+            private:
+                // Separate cache lines: `bottom_` is written by the owner,
+                // `top_` - by thieves.
+                alignas(64) std::atomic<std::int64_t> top_;
+                alignas(64) std::atomic<std::int64_t> bottom_;
+                std::atomic<Array*> array_;
+                // Owner only.
+                std::vector<std::unique_ptr<Array>> arrays_;
+            };
+        } // namespace detail
+    } // namespace coro
+} // namespace wi
+
+namespace wi
+{
+    namespace coro
+    {
+        namespace detail
+        {
+
+            template<typename T>
+            /*explicit*/ WorkStealingDeque<T>::Array::Array(std::int64_t capacity)
+                : mask(capacity - 1)
+                , cells(new std::atomic<T*>[std::size_t(capacity)])
+            {
+                assert(((capacity & mask) == 0) && "Capacity should be power of 2");
+            }
+
+            template<typename T>
+            T* WorkStealingDeque<T>::Array::get(std::int64_t index) const
+            {
+                return cells[std::size_t(index & mask)].load(std::memory_order_relaxed);
+            }
+
+            template<typename T>
+            void WorkStealingDeque<T>::Array::put(std::int64_t index, T* value)
+            {
+                cells[std::size_t(index & mask)].store(value, std::memory_order_relaxed);
+            }
+
+            template<typename T>
+            /*explicit*/ WorkStealingDeque<T>::WorkStealingDeque(std::size_t capacity /*= 64*/)
+                : top_(0)
+                , bottom_(0)
+                , array_(nullptr)
+                , arrays_()
+            {
+                std::int64_t power = 2;
+                while (power < std::int64_t(capacity))
+                {
+                    power <<= 1;
+                }
+                arrays_.push_back(std::make_unique<Array>(power));
+                array_.store(arrays_.back().get(), std::memory_order_relaxed);
+            }
+
+            template<typename T>
+            typename WorkStealingDeque<T>::Array* WorkStealingDeque<T>::grow(Array* array
+                , std::int64_t top, std::int64_t bottom)
+            {
+                arrays_.push_back(std::make_unique<Array>((array->mask + 1) * 2));
+                Array* bigger = arrays_.back().get();
+                for (std::int64_t i = top; i < bottom; ++i)
+                {
+                    bigger->put(i, array->get(i));
+                }
+                array_.store(bigger, std::memory_order_release);
+                return bigger;
+            }
+
+            template<typename T>
+            void WorkStealingDeque<T>::push(T* value)
+            {
+                assert(value);
+                const std::int64_t bottom = bottom_.load(std::memory_order_relaxed);
+                const std::int64_t top = top_.load(std::memory_order_acquire);
+                Array* array = array_.load(std::memory_order_relaxed);
+                if ((bottom - top) > array->mask)
+                {
+                    array = grow(array, top, bottom);
+                }
+                array->put(bottom, value);
+                bottom_.store(bottom + 1, std::memory_order_release);
+            }
+
+            template<typename T>
+            bool WorkStealingDeque<T>::pop(T*& value)
+            {
+                const std::int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+                Array* array = array_.load(std::memory_order_relaxed);
+                // Take the element first, then check if thieves did not
+                // take it already (store bottom, load top: seq_cst).
+                bottom_.store(bottom, std::memory_order_seq_cst);
+                std::int64_t top = top_.load(std::memory_order_seq_cst);
+                if (top > bottom)
+                {
+                    // Empty.
+                    bottom_.store(bottom + 1, std::memory_order_relaxed);
+                    return false;
+                }
+
+                value = array->get(bottom);
+                if (top < bottom)
+                {
+                    // More than one element: thieves can't reach this one.
+                    return true;
+                }
+
+                // Last element: race with thieves for it.
+                const bool taken = top_.compare_exchange_strong(top, top + 1
+                    , std::memory_order_seq_cst, std::memory_order_relaxed);
+                bottom_.store(bottom + 1, std::memory_order_relaxed);
+                return taken;
+            }
+
+            template<typename T>
+            bool WorkStealingDeque<T>::steal(T*& value)
+            {
+                std::int64_t top = top_.load(std::memory_order_seq_cst);
+                const std::int64_t bottom = bottom_.load(std::memory_order_seq_cst);
+                if (top >= bottom)
+                {
+                    return false;
+                }
+
+                Array* array = array_.load(std::memory_order_acquire);
+                T* stolen = array->get(top);
+                if (!top_.compare_exchange_strong(top, top + 1
+                    , std::memory_order_seq_cst, std::memory_order_relaxed))
+                {
+                    return false;
+                }
+                value = stolen;
+                return true;
+            }
+
+            template<typename T>
+            bool WorkStealingDeque<T>::is_empty() const
+            {
+                const std::int64_t bottom = bottom_.load(std::memory_order_seq_cst);
+                const std::int64_t top = top_.load(std::memory_order_seq_cst);
+                return (top >= bottom);
+            }
+
+        } // namespace detail
+    } // namespace coro
+} // namespace wi
@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace wi
+{
+    namespace coro
+    {
+        // Opt-in counters of FramePool, see FramePool::set_stats().
+        // Shared by all threads (relaxed atomics): enable for diagnostics.
+        struct FramePoolStats
+        {
+            // Allocations served from the thread's cache.
+            std::atomic<std::uint64_t> hits{0};
+            // Allocations that went to global operator new
+            // (cache was empty or frame is too big).
+            std::atomic<std::uint64_t> misses{0};
+            // Deallocations that went back to the thread's cache.
+            std::atomic<std::uint64_t> recycled{0};
+            // Deallocations that went to global operator delete
+            // (cache is full or frame is too big).
+            std::atomic<std::uint64_t> released{0};
+        };
+
+        // Per-thread cache of coroutine frames, by size class
+        // (powers of 2, from kMinBlockSize up to kMaxBlockSize).
+        // Lock-free: each thread allocates from and frees to its own cache;
+        // frame freed on other thread goes to that thread's cache.
+        // Bigger frames and frames that don't fit the cache go
+        // to global operator new/delete.
+        class FramePool
+        {
+        public:
+            static constexpr std::size_t kMinBlockSize = 64;
+            static constexpr std::size_t kMaxBlockSize = 4096;
+            static constexpr std::size_t kClassesCount = 7;
+            // Per thread, per size class.
+            static constexpr std::size_t kMaxCachedBlocks = 256;
+
+            static void* allocate(std::size_t size);
+            // `size` should be the same as passed to allocate().
+            static void deallocate(void* ptr, std::size_t size) noexcept;
+
+            // Not owned; nullptr to disable. Must outlive all pool's use.
+            static void set_stats(FramePoolStats* stats) noexcept;
+            static FramePoolStats* stats() noexcept;
+        };
+
+        // Base for promise types: coroutine frame is allocated from FramePool.
+        struct PooledFrame
+        {
+            static void* operator new(std::size_t size);
+            static void operator delete(void* ptr, std::size_t size) noexcept;
+        };
+
+    } // namespace coro
+} // namespace wi
@@ -1,39 +1,186 @@
 #pragma once
 #include <win_io/io_completion_port.h>
+#include <win_io/timer_wheel.h>
 #include <win_io_coro/io_task.h>
+#include <win_io_coro/sleep_task.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+
+#include <limits>
 
 #include <cstddef>
+#include <cstdint>
 
 namespace wi
 {
     namespace coro
     {
+        // Resumes coroutines that wait for IoCompletionPort data.
+        // 
+        // Entries with OVERLAPPED are completions of wi::IoOperation-s
+        // (e.g., IoOperationTask): the operation's callback is invoked
+        // directly, resuming exactly the coroutine that issued the I/O.
+        // Entries without OVERLAPPED (posted data) go to coroutines
+        // waiting on get(), in FIFO order; if there are none, data is kept
+        // until the next get().
+        // 
+        // poll()/poll_one() never block; run()/run_one() block on the port
+        // and can be called from several threads at once: coroutine
+        // continues on the thread that took the data.
+        // stop() posts single sentinel entry (kStopKey, no OVERLAPPED);
+        // thread that takes it posts it again for the next one,
+        // so all blocked threads return. Same as Asio, once stopped,
+        // run*() and poll*() return immediately until restart().
+        // 
+        // Timers (sleep_for()): TimerWheel, advanced by run*()/poll*().
+        // Expired timer is posted to the port as IoOperation completion.
+        // Same as IoContext, one of the blocked threads uses the next
+        // expiration time as its wait time-out; if earlier timer is
+        // scheduled, it's woken up with kWakeKey entry to re-calculate it.
+        // Thread that leaves the wait to resume a coroutine gives up the
+        // duty: if other thread is blocked without time-out, it's woken up
+        // with kWakeKey to take it, so timers scheduled during long resume
+        // still expire on time.
         class IoScheduler
         {
         public:
+            using Clock = std::chrono::steady_clock;
+
+            // Reserved: do not post entries with these keys.
+            static constexpr WinULONG_PTR kStopKey = ~WinULONG_PTR(0);
+            static constexpr WinULONG_PTR kWakeKey = ~WinULONG_PTR(0) - 1;
+            // Entries poll() takes from the port with single query_many().
+            static constexpr std::size_t kPollBatchSize = 64;
+            static constexpr std::size_t kNoPollBudget = (std::numeric_limits<std::size_t>::max)();
+
             IoScheduler(IoCompletionPort& io_port);
             ~IoScheduler();
 
+            // Handles ready entries, in batches of kPollBatchSize,
+            // but no more than poll budget (see set_poll_budget()).
             std::size_t poll();
             std::size_t poll_one();
 
+            // Max entries single poll() takes from the port, so it can't
+            // starve the caller under the constant load. Unlimited by default.
+            // Must not be called while poll() is in progress.
+            void set_poll_budget(std::size_t max_entries);
+
+            // Blocks until stop(). Returns number of handled entries.
+            // `ec` is set if waiting on the port failed (scheduler is
+            // stopped then, same as IoContext::run()).
+            std::size_t run(std::error_code& ec);
+            // Blocks until single entry is handled, stop() or error.
+            std::size_t run_one(std::error_code& ec);
+            // Same, but the port's error is not reported: check stopped().
             std::size_t run();
             std::size_t run_one();
 
+            // Thread-safe. Can be called from the coroutine.
+            void stop();
+            bool stopped() const;
+            // Must not be called while there are unfinished calls
+            // to run() or run_one() (same as Asio).
+            void restart();
+
             // Should be used together with co_await.
             // Suspends coroutine until any IoCompletionPort data
-            // becomes available
+            // (without OVERLAPPED) becomes available
             IoTask get();
+            // Same, but once stop is requested, coroutine is resumed
+            // with std::errc::operation_canceled (see StoppableIoTask).
+            StoppableIoTask get(std::stop_token stop_token);
+
+            // Should be used together with co_await.
+            // Suspends coroutine until `time` passes (rounded up to 1ms).
+            template<typename Rep, typename Period>
+            SleepTask sleep_for(std::chrono::duration<Rep, Period> time);
+            SleepTask sleep_until(Clock::time_point when);
+
+            // Completes `operation` (no data) through the port: awaiting
+            // coroutine is resumed by the thread that runs the scheduler,
+            // not by the caller. Thread-safe.
+            void post(IoOperationTask& operation);
 
         private:
             friend class IoTask;
-            void add(IoTask& task);
+            friend class StoppableIoTask;
+            friend class SleepTask;
+            // False if there is data already: `task` gets it
+            // and should not be suspended. Same if `task` is canceled.
+            // Lock-free, unless it races with the data kept by handle().
+            bool add(IoTask& task);
+            // Removes `task` from the waiting ones. False if it's
+            // not waiting (data is given to it already).
+            bool cancel(IoTask& task);
+            // Returns 1 if `data` was handled: operation's callback
+            // invoked or waiting coroutine resumed.
+            std::size_t handle(PortEntry& data, std::error_code ec);
+            // Returns true if `data` is stop or wake-up sentinel (handled).
+            bool handle_sentinel(const PortEntry& data);
+            // Gives the oldest kept data to the oldest waiting task.
+            // False if there is no data or no task.
+            bool take_pending(IoTask*& task, PortEntry& data);
+
+            void schedule_timer(WheelTimer& timer, Clock::time_point when);
+            // False if `timer` is not scheduled (expired already).
+            bool cancel_timer(WheelTimer& timer);
+            // Posts expired timers to the port. If there are none and
+            // `timer_duty` is given, takes the duty (if free): returns
+            // the time to wake up at, `timer_duty` is set to non-0 then.
+            // Otherwise, the calling thread is counted as blocked without
+            // the duty until release_timer_duty().
+            std::optional<Clock::time_point> expire_timers(std::uint64_t* timer_duty);
+            // After the wait of expire_timers(&timer_duty); `has_work` if
+            // the thread took anything but sentinel.
+            void release_timer_duty(std::uint64_t timer_duty, bool has_work);
+            // run_one() without `running_` accounting.
+            std::size_t wait_one(std::error_code& ec);
+            // Under `timers_lock_`. True if nobody waits for timers, but some
+            // thread is blocked without time-out and can take the duty:
+            // kWakeKey needs to be posted then (`wake_posted_` is set).
+            bool hand_off_timer_duty();
+            void post_wake_up();
 
         private:
             IoCompletionPort& io_port_;
-            detail::IntrusiveQueue<IoTask> tasks_;
+            // Tasks are pushed from any thread without the lock, but
+            // popped (and removed) under `lock_` only. Once add() and
+            // handle() return, either `tasks_` or `pending_data_` is
+            // empty: see add() and handle().
+            detail::IntrusiveMPSCQueue<IoTask> tasks_;
+            std::deque<PortEntry> pending_data_;
+            // Same as !pending_data_.empty(), for add() without the lock.
+            std::atomic<bool> has_pending_data_;
+            std::mutex lock_;
+            std::atomic<bool> stopped_;
+            // Threads inside run() or run_one(), for restart().
+            std::atomic<std::uint32_t> running_;
+            std::size_t poll_budget_;
+
+            std::mutex timers_lock_;
+            TimerWheel timers_;
+            // Id of the thread's wait that uses timers for time-out, 0 if none.
+            std::uint64_t timer_duty_;
+            std::uint64_t timer_duty_id_;
+            Clock::time_point planned_wake_up_;
+            // Threads blocked on the port without timer duty.
+            std::uint32_t waiting_;
+            // kWakeKey is posted, but nobody took the duty yet.
+            bool wake_posted_;
         };
 
+        template<typename Rep, typename Period>
+        SleepTask IoScheduler::sleep_for(std::chrono::duration<Rep, Period> time)
+        {
+            return sleep_until(Clock::now() + std::chrono::duration_cast<Clock::duration>(time));
+        }
+
     } // namespace coro
 } // namespace wi
 
@@ -0,0 +1,69 @@
+#pragma once
+#include <win_io/io_completion_port.h>
+#include <win_io/io_operation.h>
+
+#include <atomic>
+#include <coroutine>
+#include <system_error>
+
+#include <cstdint>
+
+namespace wi
+{
+    namespace coro
+    {
+        struct IoResult
+        {
+            PortEntry entry;
+            // Error of the operation, if failed.
+            std::error_code error;
+        };
+
+        // Awaitable for single asynchronous operation.
+        // Pass overlapped() to the Win API call (or post PortEntry with it),
+        // then co_await: the completion resumes exactly this coroutine,
+        // straight from `PortEntry::overlapped` (see wi::IoOperation),
+        // whichever thread dispatches it (IoScheduler::run(), poll(), ...).
+        // 
+        // Operation may complete before co_await (on other thread):
+        // coroutine is not suspended then.
+        // Many operations can be in-flight for the same coroutine.
+        // Must outlive the operation.
+        class IoOperationTask
+        {
+        public:
+            IoOperationTask();
+            IoOperationTask(IoOperationTask&& rhs) = delete;
+            IoOperationTask& operator=(IoOperationTask&& rhs) = delete;
+            IoOperationTask(const IoOperationTask& rhs) = delete;
+            IoOperationTask& operator=(const IoOperationTask& rhs) = delete;
+
+            WinOVERLAPPED* overlapped();
+
+            bool await_ready() const noexcept;
+            bool await_suspend(std::coroutine_handle<> awaiter) noexcept;
+            IoResult await_resume() noexcept;
+
+            // Makes the task ready for the next operation.
+            // Previous one should be completed and awaited.
+            void reset();
+
+        private:
+            static void on_complete(void* user_data, const PortEntry& entry, std::error_code ec);
+
+        private:
+            enum State : std::uint32_t
+            {
+                Pending,
+                Suspended,
+                Completed,
+            };
+
+            IoOperation operation_;
+            std::atomic<std::uint32_t> state_;
+            std::coroutine_handle<> coro_;
+            IoResult result_;
+        };
+
+    } // namespace coro
+} // namespace wi
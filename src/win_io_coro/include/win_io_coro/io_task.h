@@ -2,8 +2,14 @@
 #include <win_io/io_completion_port.h>
 
 #include <win_io_coro/detail/intrusive_queue.h>
+#include <win_io_coro/io_operation_task.h>
 
+#include <atomic>
 #include <coroutine>
+#include <optional>
+#include <stop_token>
+
+#include <cstdint>
 
 namespace wi
 {
@@ -27,19 +33,69 @@ namespace wi
             IoTask& operator=(const IoTask& rhs) = delete;
 
             bool await_ready() const noexcept;
-            void await_suspend(std::coroutine_handle<> awaiter) noexcept;
+            bool await_suspend(std::coroutine_handle<> awaiter) noexcept;
             PortEntry await_resume() noexcept;
 
-        private:
+        protected:
             friend class IoScheduler;
             // Any coroutine that awaits on the task will be resumed
             // with given `data` passed in
             void set(PortEntry data);
 
-        private:
+        protected:
+            // kNew -> kAdded (queued by the scheduler) -> kTaken (got
+            // the data) or kCanceled. Also kNew -> kCanceled, if canceled
+            // before it's added. kTaken is set under the scheduler's lock.
+            enum class State : std::uint8_t
+            {
+                kNew,
+                kAdded,
+                kTaken,
+                kCanceled,
+            };
+
+            bool is_canceled() const;
+
+        protected:
             IoScheduler* scheduler_;
             std::coroutine_handle<> coro_;
             PortEntry data_;
+            std::atomic<State> state_;
+        };
+
+        // IoTask that can be cancelled with std::stop_token:
+        // once stop is requested, the coroutine that still waits
+        // for the data is resumed with std::errc::operation_canceled
+        // (and no data). Data that was already taken is not lost:
+        // it's returned even if stop is requested later.
+        class StoppableIoTask : public IoTask
+        {
+        public:
+            StoppableIoTask(IoScheduler& scheduler, std::stop_token stop_token);
+
+            StoppableIoTask(StoppableIoTask&& rhs) noexcept;
+            StoppableIoTask& operator=(StoppableIoTask&& rhs) = delete;
+            StoppableIoTask(const StoppableIoTask& rhs) = delete;
+            StoppableIoTask& operator=(const StoppableIoTask& rhs) = delete;
+
+            bool await_suspend(std::coroutine_handle<> awaiter) noexcept;
+            IoResult await_resume() noexcept;
+
+            // Same as stop request, but for this task only.
+            // Used by when_any() (with_timeout()) for the loser.
+            void cancel();
+
+        private:
+            struct OnStop
+            {
+                StoppableIoTask* task;
+                void operator()() const noexcept;
+            };
+
+        private:
+            std::stop_token stop_token_;
+            // Registered while co_await-ing only.
+            std::optional<std::stop_callback<OnStop>> on_stop_;
         };
 
     } // namespace coro
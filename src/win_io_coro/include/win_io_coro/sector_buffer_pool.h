@@ -0,0 +1,90 @@
+#pragma once
+#include <win_io_coro/detail/slab_free_list.h>
+
+#include <optional>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace wi
+{
+    namespace coro
+    {
+        class SectorBufferPool;
+
+        // Sector-aligned block of memory from SectorBufferPool, e.g.,
+        // for unbuffered (FILE_FLAG_NO_BUFFERING) reads.
+        // Returned to the pool on destruction.
+        class SectorBuffer
+        {
+        public:
+            SectorBuffer() noexcept = default;
+            SectorBuffer(SectorBuffer&& rhs) noexcept;
+            SectorBuffer& operator=(SectorBuffer&& rhs) noexcept;
+            SectorBuffer(const SectorBuffer& rhs) = delete;
+            SectorBuffer& operator=(const SectorBuffer& rhs) = delete;
+            ~SectorBuffer();
+
+            std::uint8_t* data() const noexcept;
+            // Size of the block: requested size, rounded up.
+            std::size_t size() const noexcept;
+            explicit operator bool() const noexcept;
+
+        private:
+            friend class SectorBufferPool;
+            explicit SectorBuffer(SectorBufferPool& pool, std::uint8_t* data, std::size_t size) noexcept;
+            void release() noexcept;
+
+        private:
+            SectorBufferPool* pool_ = nullptr;
+            std::uint8_t* data_ = nullptr;
+            std::size_t size_ = 0;
+        };
+
+        // Slab pool of sector-aligned blocks, by size class (powers of 2,
+        // from kMinBlockSize up to kMaxBlockSize). Blocks of the class are
+        // carved from slabs of ~kSlabSize and reused once returned,
+        // so steady-state reads don't allocate (and don't page-fault).
+        // Bigger blocks go to aligned operator new/delete directly.
+        // Memory is kept until the pool is destroyed.
+        // Thread-safe: one lock per size class.
+        class SectorBufferPool
+        {
+        public:
+            static constexpr std::size_t kDefaultSectorSize = 4 * 1024;
+            static constexpr std::size_t kMinBlockSize = 4 * 1024;
+            static constexpr std::size_t kMaxBlockSize = 1024 * 1024;
+            static constexpr std::size_t kClassesCount = 9;
+            static constexpr std::size_t kSlabSize = 1024 * 1024;
+
+            // `sector_size` - power of 2, not bigger than kMinBlockSize.
+            explicit SectorBufferPool(std::size_t sector_size = kDefaultSectorSize);
+            SectorBufferPool(const SectorBufferPool& rhs) = delete;
+            SectorBufferPool& operator=(const SectorBufferPool& rhs) = delete;
+            SectorBufferPool(SectorBufferPool&& rhs) = delete;
+            SectorBufferPool& operator=(SectorBufferPool&& rhs) = delete;
+            // All buffers should be returned.
+            ~SectorBufferPool();
+
+            // Throws std::bad_alloc.
+            SectorBuffer allocate(std::size_t size);
+
+            std::size_t sector_size() const noexcept;
+            // Slabs allocated so far, for all classes.
+            std::size_t slabs_count();
+
+            // Default pool, never destroyed: buffers may be
+            // returned during static destruction.
+            static SectorBufferPool& shared();
+
+        private:
+            friend class SectorBuffer;
+            void deallocate(std::uint8_t* data, std::size_t size) noexcept;
+
+        private:
+            std::size_t sector_size_;
+            std::optional<detail::SlabFreeList> classes_[kClassesCount];
+        };
+
+    } // namespace coro
+} // namespace wi
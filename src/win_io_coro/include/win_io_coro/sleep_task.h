@@ -0,0 +1,47 @@
+#pragma once
+#include <win_io/timer_wheel.h>
+#include <win_io_coro/io_operation_task.h>
+
+#include <chrono>
+#include <coroutine>
+
+namespace wi
+{
+    namespace coro
+    {
+        class IoScheduler;
+
+        // Awaitable returned by IoScheduler::sleep_for()/sleep_until().
+        // Timer lives in the scheduler's TimerWheel; once expired,
+        // it's posted to the port as completion of own IoOperationTask,
+        // so the coroutine is resumed by whichever thread runs the
+        // scheduler, same as for any other I/O.
+        // Must not be moved while co_await-ed.
+        class SleepTask
+        {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            SleepTask(IoScheduler& scheduler, Clock::time_point when);
+            SleepTask(SleepTask&& rhs) noexcept;
+            SleepTask& operator=(SleepTask&& rhs) = delete;
+            SleepTask(const SleepTask& rhs) = delete;
+            SleepTask& operator=(const SleepTask& rhs) = delete;
+
+            bool await_ready() const noexcept;
+            bool await_suspend(std::coroutine_handle<> awaiter) noexcept;
+            void await_resume() noexcept;
+
+            // Wakes up the awaiter earlier (if still sleeping).
+            // Used by when_any() (with_timeout()) for the loser.
+            void cancel();
+
+        private:
+            IoScheduler* scheduler_;
+            Clock::time_point when_;
+            WheelTimer timer_;
+            IoOperationTask operation_;
+        };
+
+    } // namespace coro
+} // namespace wi
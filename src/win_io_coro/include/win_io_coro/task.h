@@ -0,0 +1,283 @@
+#pragma once
+#include <win_io_coro/frame_pool.h>
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include <cassert>
+
+namespace wi
+{
+    namespace coro
+    {
+        template<typename T>
+        class Task;
+
+        namespace detail
+        {
+            struct TaskPromiseBase : PooledFrame
+            {
+                // Resumes the awaiting coroutine with symmetric transfer
+                // if it's suspended already; otherwise the task finished
+                // synchronously, inside Task::Awaiter::await_suspend(),
+                // which then continues without suspending.
+                struct FinalAwaiter
+                {
+                    bool await_ready() const noexcept;
+                    template<typename Promise>
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> coro) noexcept;
+                    void await_resume() const noexcept;
+                };
+
+                std::suspend_always initial_suspend() noexcept;
+                FinalAwaiter final_suspend() noexcept;
+                void unhandled_exception() noexcept;
+
+                std::coroutine_handle<> continuation_;
+                std::exception_ptr exception_;
+                // Set by the first of: awaiter (suspended) or the task
+                // (finished); the second one continues the awaiter.
+                std::atomic<bool> ready_{false};
+            };
+
+            template<typename T>
+            struct TaskPromise : TaskPromiseBase
+            {
+                Task<T> get_return_object() noexcept;
+                template<typename U>
+                void return_value(U&& value);
+                T result();
+
+                std::optional<T> value_;
+            };
+
+            template<>
+            struct TaskPromise<void> : TaskPromiseBase
+            {
+                Task<void> get_return_object() noexcept;
+                void return_void() noexcept;
+                void result();
+            };
+        } // namespace detail
+
+        // Lazy coroutine that produces single value (or exception).
+        // Starts once co_await-ed. Task that completes synchronously
+        // does not suspend the awaiter; otherwise the awaiter is resumed
+        // with symmetric transfer. In both cases long loops of awaits
+        // don't grow the stack (even when the compiler does not turn
+        // symmetric transfer into tail call, e.g. unoptimized builds).
+        // Frame is allocated from FramePool.
+        template<typename T = void>
+        class Task
+        {
+        public:
+            static_assert(!std::is_reference_v<T>, "Task<T&> is not supported");
+
+            using promise_type = detail::TaskPromise<T>;
+
+            class Awaiter
+            {
+            public:
+                explicit Awaiter(std::coroutine_handle<promise_type> coro) noexcept;
+
+                bool await_ready() const noexcept;
+                bool await_suspend(std::coroutine_handle<> awaiter) noexcept;
+                T await_resume();
+
+            private:
+                std::coroutine_handle<promise_type> coro_;
+            };
+
+        public:
+            Task() noexcept = default;
+            Task(Task&& rhs) noexcept;
+            Task& operator=(Task&& rhs) noexcept;
+            Task(const Task& rhs) = delete;
+            Task& operator=(const Task& rhs) = delete;
+            ~Task();
+
+            // True if finished (or empty).
+            bool is_ready() const noexcept;
+            Awaiter operator co_await() const noexcept;
+
+        private:
+            friend struct detail::TaskPromise<T>;
+            explicit Task(std::coroutine_handle<promise_type> coro) noexcept;
+
+        private:
+            std::coroutine_handle<promise_type> coro_;
+        };
+
+    } // namespace coro
+} // namespace wi
+
+namespace wi
+{
+    namespace coro
+    {
+        namespace detail
+        {
+
+            inline bool TaskPromiseBase::FinalAwaiter::await_ready() const noexcept
+            {
+                return false;
+            }
+
+            template<typename Promise>
+            std::coroutine_handle<> TaskPromiseBase::FinalAwaiter::await_suspend(
+                std::coroutine_handle<Promise> coro) noexcept
+            {
+                TaskPromiseBase& promise = coro.promise();
+                if (promise.ready_.exchange(true, std::memory_order_acq_rel))
+                {
+                    return promise.continuation_;
+                }
+                // Awaiter is still inside await_suspend() (or there is
+                // no awaiter): return to it.
+                return std::noop_coroutine();
+            }
+
+            inline void TaskPromiseBase::FinalAwaiter::await_resume() const noexcept
+            {
+            }
+
+            inline std::suspend_always TaskPromiseBase::initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            inline TaskPromiseBase::FinalAwaiter TaskPromiseBase::final_suspend() noexcept
+            {
+                return {};
+            }
+
+            inline void TaskPromiseBase::unhandled_exception() noexcept
+            {
+                exception_ = std::current_exception();
+            }
+
+            template<typename T>
+            Task<T> TaskPromise<T>::get_return_object() noexcept
+            {
+                return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+            }
+
+            template<typename T>
+            template<typename U>
+            void TaskPromise<T>::return_value(U&& value)
+            {
+                value_.emplace(std::forward<U>(value));
+            }
+
+            template<typename T>
+            T TaskPromise<T>::result()
+            {
+                if (exception_)
+                {
+                    std::rethrow_exception(exception_);
+                }
+                assert(value_ && "Task finished without value");
+                return std::move(*value_);
+            }
+
+            inline Task<void> TaskPromise<void>::get_return_object() noexcept
+            {
+                return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+            }
+
+            inline void TaskPromise<void>::return_void() noexcept
+            {
+            }
+
+            inline void TaskPromise<void>::result()
+            {
+                if (exception_)
+                {
+                    std::rethrow_exception(exception_);
+                }
+            }
+
+        } // namespace detail
+
+        template<typename T>
+        /*explicit*/ Task<T>::Awaiter::Awaiter(std::coroutine_handle<promise_type> coro) noexcept
+            : coro_(coro)
+        {
+        }
+
+        template<typename T>
+        bool Task<T>::Awaiter::await_ready() const noexcept
+        {
+            return (!coro_ || coro_.done());
+        }
+
+        template<typename T>
+        bool Task<T>::Awaiter::await_suspend(std::coroutine_handle<> awaiter) noexcept
+        {
+            promise_type& promise = coro_.promise();
+            promise.continuation_ = awaiter;
+            coro_.resume();
+            // Finished already - continue without suspending.
+            return !promise.ready_.exchange(true, std::memory_order_acq_rel);
+        }
+
+        template<typename T>
+        T Task<T>::Awaiter::await_resume()
+        {
+            assert(coro_ && "co_await on empty Task");
+            return coro_.promise().result();
+        }
+
+        template<typename T>
+        /*explicit*/ Task<T>::Task(std::coroutine_handle<promise_type> coro) noexcept
+            : coro_(coro)
+        {
+        }
+
+        template<typename T>
+        Task<T>::Task(Task&& rhs) noexcept
+            : coro_(std::exchange(rhs.coro_, nullptr))
+        {
+        }
+
+        template<typename T>
+        Task<T>& Task<T>::operator=(Task&& rhs) noexcept
+        {
+            if (this != &rhs)
+            {
+                if (coro_)
+                {
+                    coro_.destroy();
+                }
+                coro_ = std::exchange(rhs.coro_, nullptr);
+            }
+            return *this;
+        }
+
+        template<typename T>
+        Task<T>::~Task()
+        {
+            if (coro_)
+            {
+                coro_.destroy();
+            }
+        }
+
+        template<typename T>
+        bool Task<T>::is_ready() const noexcept
+        {
+            return (!coro_ || coro_.done());
+        }
+
+        template<typename T>
+        typename Task<T>::Awaiter Task<T>::operator co_await() const noexcept
+        {
+            return Awaiter(coro_);
+        }
+
+    } // namespace coro
+} // namespace wi
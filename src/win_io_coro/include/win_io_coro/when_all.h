@@ -0,0 +1,117 @@
+#pragma once
+#include <win_io_coro/detail/when_children.h>
+
+#include <coroutine>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+
+namespace wi
+{
+    namespace coro
+    {
+        namespace detail
+        {
+            // Starts all children on co_await; the awaiter is resumed
+            // by the last finished one (or not suspended at all
+            // if all of them finished synchronously).
+            template<typename Children>
+            class WhenAllAwaitable
+            {
+            public:
+                template<typename... Args>
+                explicit WhenAllAwaitable(Args&&... args);
+                WhenAllAwaitable(const WhenAllAwaitable& rhs) = delete;
+                WhenAllAwaitable& operator=(const WhenAllAwaitable& rhs) = delete;
+
+                bool await_ready() const noexcept;
+                bool await_suspend(std::coroutine_handle<> awaiter);
+                typename Children::AllResult await_resume();
+
+            private:
+                Children children_;
+                WhenState state_;
+            };
+        } // namespace detail
+
+        // co_await-s all `awaitables` concurrently (e.g., AsyncReadTask,
+        // IoOperationTask, IoTask, Task<T>): std::tuple of the results,
+        // in input order; void result is std::monostate.
+        // If any of them throws, the first exception (in input order)
+        // is rethrown once all finished.
+        // 
+        // Lvalues are referenced and must outlive co_await; rvalues
+        // are moved in. Single atomic counter for all; each awaitable
+        // is co_await-ed by small coroutine with FramePool frame.
+        template<detail::Awaitable... Awaitables>
+        detail::WhenAllAwaitable<detail::WhenTuple<Awaitables...>> when_all(Awaitables&&... awaitables);
+
+        // Same for the range of awaitables: std::vector of the results.
+        template<typename Awaitable>
+        detail::WhenAllAwaitable<detail::WhenRange<Awaitable>> when_all(std::span<Awaitable> awaitables);
+
+        template<typename Awaitable>
+        detail::WhenAllAwaitable<detail::WhenRange<Awaitable>> when_all(std::vector<Awaitable>& awaitables);
+
+    } // namespace coro
+} // namespace wi
+
+namespace wi
+{
+    namespace coro
+    {
+        namespace detail
+        {
+
+            template<typename Children>
+            template<typename... Args>
+            /*explicit*/ WhenAllAwaitable<Children>::WhenAllAwaitable(Args&&... args)
+                : children_(std::forward<Args>(args)...)
+                , state_(children_.size())
+            {
+            }
+
+            template<typename Children>
+            bool WhenAllAwaitable<Children>::await_ready() const noexcept
+            {
+                return (children_.size() == 0);
+            }
+
+            template<typename Children>
+            bool WhenAllAwaitable<Children>::await_suspend(std::coroutine_handle<> awaiter)
+            {
+                children_.start(state_);
+                return state_.suspend(awaiter);
+            }
+
+            template<typename Children>
+            typename Children::AllResult WhenAllAwaitable<Children>::await_resume()
+            {
+                return children_.all_result();
+            }
+
+        } // namespace detail
+
+        template<detail::Awaitable... Awaitables>
+        detail::WhenAllAwaitable<detail::WhenTuple<Awaitables...>> when_all(Awaitables&&... awaitables)
+        {
+            return detail::WhenAllAwaitable<detail::WhenTuple<Awaitables...>>(
+                std::forward<Awaitables>(awaitables)...);
+        }
+
+        template<typename Awaitable>
+        detail::WhenAllAwaitable<detail::WhenRange<Awaitable>> when_all(std::span<Awaitable> awaitables)
+        {
+            return detail::WhenAllAwaitable<detail::WhenRange<Awaitable>>(awaitables);
+        }
+
+        template<typename Awaitable>
+        detail::WhenAllAwaitable<detail::WhenRange<Awaitable>> when_all(std::vector<Awaitable>& awaitables)
+        {
+            return detail::WhenAllAwaitable<detail::WhenRange<Awaitable>>(std::span<Awaitable>(awaitables));
+        }
+
+    } // namespace coro
+} // namespace wi
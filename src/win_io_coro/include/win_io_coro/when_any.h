@@ -0,0 +1,128 @@
+#pragma once
+#include <win_io_coro/detail/when_children.h>
+
+#include <coroutine>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <cassert>
+#include <cstddef>
+
+namespace wi
+{
+    namespace coro
+    {
+        namespace detail
+        {
+            // Starts all children on co_await. The first finished one
+            // is the winner: the rest are cancelled (if Cancellable)
+            // and the awaiter is resumed once all of them finished.
+            template<typename Children>
+            class WhenAnyAwaitable
+            {
+            public:
+                template<typename... Args>
+                explicit WhenAnyAwaitable(Args&&... args);
+                WhenAnyAwaitable(const WhenAnyAwaitable& rhs) = delete;
+                WhenAnyAwaitable& operator=(const WhenAnyAwaitable& rhs) = delete;
+
+                bool await_ready() const noexcept;
+                bool await_suspend(std::coroutine_handle<> awaiter);
+                typename Children::AnyResult await_resume();
+
+            private:
+                static void cancel(void* self, std::size_t winner);
+
+            private:
+                Children children_;
+                WhenState state_;
+            };
+        } // namespace detail
+
+        // co_await-s all `awaitables` concurrently, returns result of the
+        // first finished one (or rethrows its exception): std::variant
+        // with the index of the winner. Losers are cancelled - each one
+        // that has cancel() member (e.g., AsyncReadTask) - and always
+        // awaited to the end, so nothing outlives co_await; results
+        // of the losers are dropped. Not cancellable awaitable delays
+        // the resumption until it finishes on its own.
+        // 
+        // Same ownership rules as for when_all(). Must not be empty.
+        template<detail::Awaitable... Awaitables>
+        detail::WhenAnyAwaitable<detail::WhenTuple<Awaitables...>> when_any(Awaitables&&... awaitables);
+
+        // Same for the range of awaitables: WhenAnyResult.
+        template<typename Awaitable>
+        detail::WhenAnyAwaitable<detail::WhenRange<Awaitable>> when_any(std::span<Awaitable> awaitables);
+
+        template<typename Awaitable>
+        detail::WhenAnyAwaitable<detail::WhenRange<Awaitable>> when_any(std::vector<Awaitable>& awaitables);
+
+    } // namespace coro
+} // namespace wi
+
+namespace wi
+{
+    namespace coro
+    {
+        namespace detail
+        {
+
+            template<typename Children>
+            template<typename... Args>
+            /*explicit*/ WhenAnyAwaitable<Children>::WhenAnyAwaitable(Args&&... args)
+                : children_(std::forward<Args>(args)...)
+                , state_(children_.size(), &WhenAnyAwaitable::cancel, this)
+            {
+                assert((children_.size() > 0) && "when_any() of nothing");
+            }
+
+            template<typename Children>
+            bool WhenAnyAwaitable<Children>::await_ready() const noexcept
+            {
+                return false;
+            }
+
+            template<typename Children>
+            bool WhenAnyAwaitable<Children>::await_suspend(std::coroutine_handle<> awaiter)
+            {
+                children_.start(state_);
+                return state_.suspend(awaiter);
+            }
+
+            template<typename Children>
+            typename Children::AnyResult WhenAnyAwaitable<Children>::await_resume()
+            {
+                return children_.any_result(state_.winner());
+            }
+
+            template<typename Children>
+            /*static*/ void WhenAnyAwaitable<Children>::cancel(void* self, std::size_t winner)
+            {
+                static_cast<WhenAnyAwaitable*>(self)->children_.cancel(winner);
+            }
+
+        } // namespace detail
+
+        template<detail::Awaitable... Awaitables>
+        detail::WhenAnyAwaitable<detail::WhenTuple<Awaitables...>> when_any(Awaitables&&... awaitables)
+        {
+            return detail::WhenAnyAwaitable<detail::WhenTuple<Awaitables...>>(
+                std::forward<Awaitables>(awaitables)...);
+        }
+
+        template<typename Awaitable>
+        detail::WhenAnyAwaitable<detail::WhenRange<Awaitable>> when_any(std::span<Awaitable> awaitables)
+        {
+            return detail::WhenAnyAwaitable<detail::WhenRange<Awaitable>>(awaitables);
+        }
+
+        template<typename Awaitable>
+        detail::WhenAnyAwaitable<detail::WhenRange<Awaitable>> when_any(std::vector<Awaitable>& awaitables)
+        {
+            return detail::WhenAnyAwaitable<detail::WhenRange<Awaitable>>(std::span<Awaitable>(awaitables));
+        }
+
+    } // namespace coro
+} // namespace wi
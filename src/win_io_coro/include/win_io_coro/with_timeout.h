@@ -0,0 +1,54 @@
+#pragma once
+#include <win_io_coro/io_coro_scheduler.h>
+#include <win_io_coro/sleep_task.h>
+#include <win_io_coro/task.h>
+#include <win_io_coro/when_any.h>
+
+#include <chrono>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace wi
+{
+    namespace coro
+    {
+        template<typename Awaitable>
+        using WithTimeoutResult = std::optional<detail::NonVoid<detail::AwaitResult<std::remove_reference_t<Awaitable>>>>;
+
+        // co_await-s `awaitable` for no longer than `time`: its result,
+        // or std::nullopt if timed out. On time-out, `awaitable` is
+        // cancelled (if it has cancel() member, e.g., AsyncReadTask,
+        // StoppableIoTask) and awaited to the end; not cancellable one
+        // delays the return until it finishes on its own, see when_any().
+        // Timer is IoScheduler's sleep_for(), no threads are involved.
+        template<typename Awaitable, typename Rep, typename Period>
+        Task<WithTimeoutResult<Awaitable>> with_timeout(IoScheduler& scheduler
+            , Awaitable&& awaitable
+            , std::chrono::duration<Rep, Period> time);
+
+    } // namespace coro
+} // namespace wi
+
+namespace wi
+{
+    namespace coro
+    {
+
+        template<typename Awaitable, typename Rep, typename Period>
+        Task<WithTimeoutResult<Awaitable>> with_timeout(IoScheduler& scheduler
+            , Awaitable&& awaitable
+            , std::chrono::duration<Rep, Period> time)
+        {
+            SleepTask timeout = scheduler.sleep_for(time);
+            auto result = co_await when_any(std::forward<Awaitable>(awaitable), timeout);
+            if (result.index() == 0)
+            {
+                co_return WithTimeoutResult<Awaitable>(std::move(std::get<0>(result)));
+            }
+            co_return std::nullopt;
+        }
+
+    } // namespace coro
+} // namespace wi
@@ -0,0 +1,90 @@
+#pragma once
+#include <win_io_coro/detail/intrusive_queue.h>
+#include <win_io_coro/detail/work_stealing_deque.h>
+
+#include <atomic>
+#include <coroutine>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace wi
+{
+    namespace coro
+    {
+        // Multi-threaded coroutine scheduler.
+        // `co_await scheduler.schedule()` continues the coroutine
+        // on one of the scheduler's threads.
+        // 
+        // Every worker thread has its own WorkStealingDeque:
+        // coroutines scheduled from the worker are resumed by the same
+        // worker (LIFO, cache-hot), threads do not contend on single queue.
+        // Worker that has nothing to do takes coroutines scheduled
+        // from outside (shared queue), then steals from other workers;
+        // sleeps when there is no work at all.
+        class WorkStealingScheduler
+        {
+        public:
+            class ScheduleOperation : public detail::IntrusiveQueue<ScheduleOperation>::Item
+            {
+            public:
+                explicit ScheduleOperation(WorkStealingScheduler& scheduler);
+
+                bool await_ready() const noexcept;
+                void await_suspend(std::coroutine_handle<> awaiter) noexcept;
+                void await_resume() const noexcept;
+
+            private:
+                friend class WorkStealingScheduler;
+                WorkStealingScheduler* scheduler_;
+                std::coroutine_handle<> coro_;
+            };
+
+        public:
+            // `threads_count` - 0 for as many as CPUs.
+            explicit WorkStealingScheduler(std::uint32_t threads_count = 0);
+            // Stops and joins worker threads. Coroutines that were
+            // scheduled, but not resumed yet, are left suspended.
+            ~WorkStealingScheduler();
+
+            WorkStealingScheduler(const WorkStealingScheduler&) = delete;
+            WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+            WorkStealingScheduler(WorkStealingScheduler&&) = delete;
+            WorkStealingScheduler& operator=(WorkStealingScheduler&&) = delete;
+
+            ScheduleOperation schedule();
+
+            std::uint32_t threads_count() const;
+            // True if called from one of the worker threads.
+            bool is_worker_thread() const;
+
+        private:
+            struct Worker
+            {
+                detail::WorkStealingDeque<ScheduleOperation> tasks;
+                std::thread thread;
+            };
+
+            void post(ScheduleOperation& operation);
+            void run_worker(std::uint32_t index);
+            ScheduleOperation* try_get_work(std::uint32_t index);
+            void stop();
+
+        private:
+            std::vector<std::unique_ptr<Worker>> workers_;
+            // Scheduled from non-worker threads.
+            detail::IntrusiveMPSCQueue<ScheduleOperation> shared_tasks_;
+            std::mutex shared_tasks_lock_;
+            // Incremented on every post()/stop(), sleeping workers
+            // wait for it to change.
+            std::atomic<std::uint32_t> epoch_;
+            std::atomic<std::uint32_t> sleeping_;
+            std::atomic<bool> stopped_;
+        };
+
+    } // namespace coro
+} // namespace wi
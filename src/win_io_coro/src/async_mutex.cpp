@@ -0,0 +1,89 @@
+#include <win_io_coro/async_mutex.h>
+#include <win_io_coro/io_coro_scheduler.h>
+
+#include <cassert>
+
+using namespace wi;
+using namespace coro;
+
+/*explicit*/ LockTask::LockTask(AsyncMutex& mutex)
+    : mutex_(&mutex)
+    , operation_()
+{
+}
+
+bool LockTask::await_ready() noexcept
+{
+    return mutex_->try_lock();
+}
+
+bool LockTask::await_suspend(std::coroutine_handle<> awaiter) noexcept
+{
+    if (!mutex_->add(*this))
+    {
+        return false;
+    }
+    // May be unlocked (and posted) already; not suspended then.
+    return operation_.await_suspend(awaiter);
+}
+
+void LockTask::await_resume() noexcept
+{
+}
+
+/*explicit*/ AsyncMutex::AsyncMutex(IoScheduler& scheduler)
+    : scheduler_(scheduler)
+    , lock_()
+    , locked_(false)
+    , waiters_()
+{
+}
+
+AsyncMutex::~AsyncMutex()
+{
+    assert(waiters_.is_empty() && "Destroying AsyncMutex with waiting coroutines");
+}
+
+LockTask AsyncMutex::lock()
+{
+    return LockTask(*this);
+}
+
+bool AsyncMutex::try_lock()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    if (locked_)
+    {
+        return false;
+    }
+    locked_ = true;
+    return true;
+}
+
+bool AsyncMutex::add(LockTask& task)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!locked_)
+    {
+        locked_ = true;
+        return false;
+    }
+    waiters_.push(&task);
+    return true;
+}
+
+void AsyncMutex::unlock()
+{
+    LockTask* task = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        assert(locked_ && "Unlocking not locked AsyncMutex");
+        if (!waiters_.pop(task))
+        {
+            locked_ = false;
+            return;
+        }
+        // Stays locked: ownership goes to `task`.
+    }
+    scheduler_.post(task->operation_);
+}
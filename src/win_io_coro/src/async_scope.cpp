@@ -0,0 +1,140 @@
+#include <win_io_coro/async_scope.h>
+#include <win_io_coro/io_coro_scheduler.h>
+
+#include <cassert>
+
+using namespace wi;
+using namespace coro;
+using coro::detail::ScopeChild;
+
+bool ScopeChild::promise_type::FinalAwaiter::await_ready() const noexcept
+{
+    return false;
+}
+
+void ScopeChild::promise_type::FinalAwaiter::await_suspend(std::coroutine_handle<promise_type> coro) noexcept
+{
+    AsyncScope* scope = coro.promise().scope_;
+    // Frame is freed before join() can see the child finished.
+    coro.destroy();
+    scope->on_child_finished();
+}
+
+void ScopeChild::promise_type::FinalAwaiter::await_resume() const noexcept
+{
+}
+
+ScopeChild ScopeChild::promise_type::get_return_object() noexcept
+{
+    return {};
+}
+
+std::suspend_never ScopeChild::promise_type::initial_suspend() noexcept
+{
+    return {};
+}
+
+ScopeChild::promise_type::FinalAwaiter ScopeChild::promise_type::final_suspend() noexcept
+{
+    return {};
+}
+
+void ScopeChild::promise_type::return_void() noexcept
+{
+}
+
+void ScopeChild::promise_type::unhandled_exception() noexcept
+{
+    std::terminate();
+}
+
+/*explicit*/ JoinTask::JoinTask(AsyncScope& scope)
+    : scope_(&scope)
+    , operation_()
+{
+}
+
+bool JoinTask::await_ready() const noexcept
+{
+    return false;
+}
+
+bool JoinTask::await_suspend(std::coroutine_handle<> awaiter) noexcept
+{
+    assert(!scope_->joiner_ && "AsyncScope::join() is awaited twice");
+    scope_->joiner_ = this;
+    // Drop scope's own reference: children are not counted
+    // from now on if there are none left.
+    if (scope_->count_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        return false;
+    }
+    // May be finished (and posted) already; not suspended then.
+    return operation_.await_suspend(awaiter);
+}
+
+void JoinTask::await_resume() noexcept
+{
+}
+
+/*explicit*/ AsyncScope::AsyncScope(IoScheduler& scheduler)
+    : scheduler_(scheduler)
+    , stop_source_()
+    , count_(1)
+    , live_(0)
+    , joiner_(nullptr)
+{
+}
+
+AsyncScope::~AsyncScope()
+{
+    assert((live_.load() == 0) && "Destroying AsyncScope with live children");
+}
+
+JoinTask AsyncScope::join()
+{
+    return JoinTask(*this);
+}
+
+void AsyncScope::request_stop() noexcept
+{
+    (void)stop_source_.request_stop();
+}
+
+bool AsyncScope::stop_requested() const noexcept
+{
+    return stop_source_.stop_requested();
+}
+
+std::stop_token AsyncScope::get_stop_token() const noexcept
+{
+    return stop_source_.get_token();
+}
+
+std::size_t AsyncScope::live() const noexcept
+{
+    return live_.load(std::memory_order_relaxed);
+}
+
+bool AsyncScope::add_child() noexcept
+{
+    if (stop_source_.stop_requested())
+    {
+        return false;
+    }
+    const std::size_t count = count_.fetch_add(1, std::memory_order_relaxed);
+    assert((count > 0) && "Spawning into AsyncScope that is joined already");
+    (void)count;
+    live_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void AsyncScope::on_child_finished() noexcept
+{
+    live_.fetch_sub(1, std::memory_order_relaxed);
+    if (count_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        // join() is suspended: scope is alive until it's resumed.
+        scheduler_.post(joiner_->operation_);
+    }
+}
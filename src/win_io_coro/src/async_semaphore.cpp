@@ -0,0 +1,98 @@
+#include <win_io_coro/async_semaphore.h>
+#include <win_io_coro/io_coro_scheduler.h>
+
+#include <cassert>
+
+using namespace wi;
+using namespace coro;
+
+/*explicit*/ AcquireTask::AcquireTask(AsyncSemaphore& semaphore)
+    : semaphore_(&semaphore)
+    , operation_()
+{
+}
+
+bool AcquireTask::await_ready() noexcept
+{
+    return semaphore_->try_acquire();
+}
+
+bool AcquireTask::await_suspend(std::coroutine_handle<> awaiter) noexcept
+{
+    if (!semaphore_->add(*this))
+    {
+        return false;
+    }
+    // May be released (and posted) already; not suspended then.
+    return operation_.await_suspend(awaiter);
+}
+
+void AcquireTask::await_resume() noexcept
+{
+}
+
+/*explicit*/ AsyncSemaphore::AsyncSemaphore(IoScheduler& scheduler, std::size_t count)
+    : scheduler_(scheduler)
+    , lock_()
+    , count_(count)
+    , waiters_()
+{
+}
+
+AsyncSemaphore::~AsyncSemaphore()
+{
+    assert(waiters_.is_empty() && "Destroying AsyncSemaphore with waiting coroutines");
+}
+
+AcquireTask AsyncSemaphore::acquire()
+{
+    return AcquireTask(*this);
+}
+
+bool AsyncSemaphore::try_acquire()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    if (count_ == 0)
+    {
+        return false;
+    }
+    --count_;
+    return true;
+}
+
+bool AsyncSemaphore::add(AcquireTask& task)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    if (count_ > 0)
+    {
+        --count_;
+        return false;
+    }
+    waiters_.push(&task);
+    return true;
+}
+
+void AsyncSemaphore::release(std::size_t count /*= 1*/)
+{
+    for (; count > 0; --count)
+    {
+        AcquireTask* task = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            if (!waiters_.pop(task))
+            {
+                count_ += count;
+                return;
+            }
+        }
+        // Permit is handed over. Don't touch `task` after: it may be
+        // resumed (and destroyed) right away.
+        scheduler_.post(task->operation_);
+    }
+}
+
+std::size_t AsyncSemaphore::available()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return count_;
+}
@@ -0,0 +1,149 @@
+#include <win_io_coro/frame_pool.h>
+
+#include <bit>
+#include <new>
+
+#include <cassert>
+
+using namespace wi;
+using namespace coro;
+
+static_assert((FramePool::kMinBlockSize << (FramePool::kClassesCount - 1)) == FramePool::kMaxBlockSize
+    , "Size classes should cover [kMinBlockSize, kMaxBlockSize]");
+
+namespace
+{
+    std::atomic<FramePoolStats*> g_frame_pool_stats{nullptr};
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    struct ThreadFramePool
+    {
+        FreeBlock* blocks[FramePool::kClassesCount]{};
+        std::size_t counts[FramePool::kClassesCount]{};
+
+        ~ThreadFramePool();
+    };
+
+    enum class PoolState
+    {
+        NotCreated,
+        Alive,
+        Destroyed,
+    };
+
+    // Frames can be freed while the thread exits, after the pool
+    // is gone: state is trivially destructible and checked first.
+    thread_local PoolState tls_pool_state = PoolState::NotCreated;
+
+    ThreadFramePool* ThisThreadPool()
+    {
+        if (tls_pool_state == PoolState::Destroyed)
+        {
+            return nullptr;
+        }
+        thread_local ThreadFramePool pool;
+        tls_pool_state = PoolState::Alive;
+        return &pool;
+    }
+
+    ThreadFramePool::~ThreadFramePool()
+    {
+        tls_pool_state = PoolState::Destroyed;
+        for (std::size_t i = 0; i < FramePool::kClassesCount; ++i)
+        {
+            while (FreeBlock* block = blocks[i])
+            {
+                blocks[i] = block->next;
+                ::operator delete(block);
+            }
+        }
+    }
+
+    // Index of the smallest class that fits `size`.
+    std::size_t SizeClass(std::size_t size)
+    {
+        if (size <= FramePool::kMinBlockSize)
+        {
+            return 0;
+        }
+        return std::size_t(std::bit_width((size - 1) / FramePool::kMinBlockSize));
+    }
+
+    void Count(std::atomic<std::uint64_t> FramePoolStats::* counter)
+    {
+        if (FramePoolStats* stats = g_frame_pool_stats.load(std::memory_order_relaxed))
+        {
+            (stats->*counter).fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+} // namespace
+
+/*static*/ void* FramePool::allocate(std::size_t size)
+{
+    if (size > kMaxBlockSize)
+    {
+        Count(&FramePoolStats::misses);
+        return ::operator new(size);
+    }
+
+    const std::size_t index = SizeClass(size);
+    ThreadFramePool* pool = ThisThreadPool();
+    if (pool && pool->blocks[index])
+    {
+        FreeBlock* block = pool->blocks[index];
+        pool->blocks[index] = block->next;
+        --pool->counts[index];
+        Count(&FramePoolStats::hits);
+        return block;
+    }
+    Count(&FramePoolStats::misses);
+    // Whole block, so it can be reused for any frame of the class.
+    return ::operator new(kMinBlockSize << index);
+}
+
+/*static*/ void FramePool::deallocate(void* ptr, std::size_t size) noexcept
+{
+    if (!ptr)
+    {
+        return;
+    }
+    if (size <= kMaxBlockSize)
+    {
+        const std::size_t index = SizeClass(size);
+        ThreadFramePool* pool = ThisThreadPool();
+        if (pool && (pool->counts[index] < kMaxCachedBlocks))
+        {
+            FreeBlock* block = ::new(ptr) FreeBlock{pool->blocks[index]};
+            pool->blocks[index] = block;
+            ++pool->counts[index];
+            Count(&FramePoolStats::recycled);
+            return;
+        }
+    }
+    Count(&FramePoolStats::released);
+    ::operator delete(ptr);
+}
+
+/*static*/ void FramePool::set_stats(FramePoolStats* stats) noexcept
+{
+    g_frame_pool_stats.store(stats, std::memory_order_relaxed);
+}
+
+/*static*/ FramePoolStats* FramePool::stats() noexcept
+{
+    return g_frame_pool_stats.load(std::memory_order_relaxed);
+}
+
+/*static*/ void* PooledFrame::operator new(std::size_t size)
+{
+    return FramePool::allocate(size);
+}
+
+/*static*/ void PooledFrame::operator delete(void* ptr, std::size_t size) noexcept
+{
+    FramePool::deallocate(ptr, size);
+}
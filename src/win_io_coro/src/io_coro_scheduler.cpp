@@ -1,4 +1,9 @@
 #include <win_io_coro/io_coro_scheduler.h>
+#include <win_io/io_operation.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
 
 #include <cassert>
 
@@ -7,11 +12,27 @@ using namespace coro;
 
 IoScheduler::IoScheduler(IoCompletionPort& io_port)
     : io_port_(io_port)
+    , tasks_()
+    , pending_data_()
+    , has_pending_data_(false)
+    , lock_()
+    , stopped_(false)
+    , running_(0)
+    , poll_budget_(kNoPollBudget)
+    , timers_lock_()
+    , timers_()
+    , timer_duty_(0)
+    , timer_duty_id_(0)
+    , planned_wake_up_()
+    , waiting_(0)
+    , wake_posted_(false)
 {
 }
 
 IoScheduler::~IoScheduler()
 {
+    assert((running_.load() == 0)
+        && "IoScheduler destroyed while run() is in progress");
     assert(tasks_.is_empty() &&
         "Coroutine tasks still running while destroying IoScheduler. "
         "Probably access to deleted object will happen");
@@ -19,60 +40,427 @@ IoScheduler::~IoScheduler()
 
 std::size_t IoScheduler::poll_one()
 {
+    if (stopped())
+    {
+        return 0;
+    }
+    (void)expire_timers(nullptr);
     std::error_code ec;
     auto data = io_port_.query(ec);
-    // #TODO: read Asio documentation to understand where error code
-    // is propagated for poll_one() interface
-    (void)ec;
     if (!data)
     {
         return 0;
     }
+    return handle(*data, ec);
+}
 
-    IoTask* task = nullptr;
-    if (!tasks_.pop(task))
+std::size_t IoScheduler::handle(PortEntry& data, std::error_code ec)
+{
+    if (handle_sentinel(data))
     {
-        // We have no any waiting task. Put the data back to the I/O Port
-        io_port_.post(*data, ec);
-        // #TODO: think about proper error handling
-        assert(!ec && "Failed to put data back to the I/O Port: "
-            "data lost happened");
         return 0;
     }
+    if (data.overlapped)
+    {
+        IoOperation::from(data).invoke(data, ec);
+        return 1;
+    }
 
-    task->set(std::move(*data));
+    IoTask* task = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        if (tasks_.pop(task))
+        {
+            task->state_.store(IoTask::State::kTaken, std::memory_order_relaxed);
+        }
+        else
+        {
+            // We have no any waiting task. Keep the data for the next one.
+            pending_data_.push_back(std::move(data));
+            has_pending_data_.store(true, std::memory_order_seq_cst);
+        }
+    }
+    if (!task)
+    {
+        // Pairs with add(): either the task pushed meanwhile is
+        // seen here (seq_cst pop), or add() sees the kept data.
+        if (!take_pending(task, data))
+        {
+            return 0;
+        }
+    }
+    task->set(std::move(data));
     return 1;
 }
 
+bool IoScheduler::take_pending(IoTask*& task, PortEntry& data)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    if (pending_data_.empty() || !tasks_.pop(task))
+    {
+        return false;
+    }
+    task->state_.store(IoTask::State::kTaken, std::memory_order_relaxed);
+    data = std::move(pending_data_.front());
+    pending_data_.pop_front();
+    has_pending_data_.store(!pending_data_.empty(), std::memory_order_relaxed);
+    return true;
+}
+
+bool IoScheduler::handle_sentinel(const PortEntry& data)
+{
+    if (data.overlapped)
+    {
+        return false;
+    }
+    if (data.completion_key == kWakeKey)
+    {
+        // Waiting thread woke up to re-calculate timers time-out.
+        return true;
+    }
+    if (data.completion_key != kStopKey)
+    {
+        return false;
+    }
+    if (stopped())
+    {
+        // Wake up next blocked thread, if any.
+        std::error_code ec;
+        io_port_.post(data, ec);
+        assert(!ec && "Failed to re-post stop entry");
+    }
+    // Otherwise, stale entry from the previous stop(), ignore.
+    return true;
+}
+
+void IoScheduler::stop()
+{
+    if (stopped_.exchange(true, std::memory_order_acq_rel))
+    {
+        return;
+    }
+    std::error_code ec;
+    io_port_.post(PortEntry(0, kStopKey, nullptr), ec);
+    assert(!ec && "Failed to post stop entry");
+}
+
+bool IoScheduler::stopped() const
+{
+    return stopped_.load(std::memory_order_acquire);
+}
+
+void IoScheduler::restart()
+{
+    assert((running_.load() == 0)
+        && "IoScheduler::restart() while run() is in progress");
+    stopped_.store(false, std::memory_order_release);
+}
+
 IoTask IoScheduler::get()
 {
     return IoTask(*this);
 }
 
-void IoScheduler::add(IoTask& task)
+StoppableIoTask IoScheduler::get(std::stop_token stop_token)
+{
+    return StoppableIoTask(*this, std::move(stop_token));
+}
+
+bool IoScheduler::add(IoTask& task)
 {
+    IoTask::State state = IoTask::State::kNew;
+    if (!task.state_.compare_exchange_strong(state, IoTask::State::kAdded
+        , std::memory_order_acq_rel))
+    {
+        // Canceled before it was added.
+        return false;
+    }
+    // Pairs with handle(): push and the load are seq_cst, so either
+    // it sees `task`, or we see the data it kept.
     tasks_.push(&task);
+    if (!has_pending_data_.load(std::memory_order_seq_cst))
+    {
+        return true;
+    }
+    // `task` can be taken (and resumed) by other thread already:
+    // it's touched only if it's taken here.
+    bool suspend = true;
+    IoTask* ready = nullptr;
+    PortEntry data;
+    while (take_pending(ready, data))
+    {
+        if (ready == &task)
+        {
+            task.data_ = std::move(data);
+            suspend = false;
+        }
+        else
+        {
+            ready->set(std::move(data));
+        }
+    }
+    return suspend;
+}
+
+bool IoScheduler::cancel(IoTask& task)
+{
+    IoTask::State state = IoTask::State::kNew;
+    if (task.state_.compare_exchange_strong(state, IoTask::State::kCanceled
+        , std::memory_order_acq_rel))
+    {
+        // Not added yet: add() will see it.
+        return false;
+    }
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            if (tasks_.remove(&task))
+            {
+                task.state_.store(IoTask::State::kCanceled, std::memory_order_release);
+                return true;
+            }
+            if (task.state_.load(std::memory_order_relaxed) != IoTask::State::kAdded)
+            {
+                // Got the data already (from add() or handle()).
+                return false;
+            }
+        }
+        // add() is about to push it.
+        std::this_thread::yield();
+    }
 }
 
 std::size_t IoScheduler::poll()
 {
-    // #TODO: add stop() mechanizm
-    std::size_t tasks = 0;
-    while (poll_one() == 1)
+    PortEntry entries[kPollBatchSize];
+    std::size_t handled = 0;
+    std::size_t budget = poll_budget_;
+    if (!stopped())
+    {
+        (void)expire_timers(nullptr);
+    }
+    while ((budget > 0) && !stopped())
     {
-        ++tasks;
+        // Never take more than the budget: entries can't be put back.
+        const std::size_t max_count = (std::min)(budget, kPollBatchSize);
+        std::error_code ec;
+        std::span<PortEntry> ready = io_port_.query_many(
+            std::span<PortEntry>(entries, max_count), ec);
+        for (PortEntry& data : ready)
+        {
+            handled += handle(data, ec);
+        }
+        budget -= ready.size();
+        if (ready.size() < max_count)
+        {
+            // Port is drained.
+            break;
+        }
     }
-    return tasks;
+    return handled;
+}
+
+void IoScheduler::set_poll_budget(std::size_t max_entries)
+{
+    assert((max_entries > 0) && "Poll budget should allow at least single entry");
+    poll_budget_ = max_entries;
 }
 
 std::size_t IoScheduler::run()
 {
-    assert(!"Not implemented yet");
-    return 0;
+    std::error_code ec;
+    return run(ec);
 }
 
 std::size_t IoScheduler::run_one()
 {
-    assert(!"Not implemented yet");
+    std::error_code ec;
+    return run_one(ec);
+}
+
+std::size_t IoScheduler::run(std::error_code& ec)
+{
+    running_.fetch_add(1, std::memory_order_relaxed);
+    std::size_t handled = 0;
+    while (wait_one(ec) == 1)
+    {
+        ++handled;
+    }
+    running_.fetch_sub(1, std::memory_order_relaxed);
+    return handled;
+}
+
+std::size_t IoScheduler::run_one(std::error_code& ec)
+{
+    running_.fetch_add(1, std::memory_order_relaxed);
+    const std::size_t handled = wait_one(ec);
+    running_.fetch_sub(1, std::memory_order_relaxed);
+    return handled;
+}
+
+std::size_t IoScheduler::wait_one(std::error_code& ec)
+{
+    ec = std::error_code();
+    while (!stopped())
+    {
+        std::uint64_t timer_duty = 0;
+        const std::optional<Clock::time_point> wake_up = expire_timers(&timer_duty);
+        std::error_code wait_ec;
+        std::optional<PortEntry> data;
+        if (wake_up)
+        {
+            const auto left = std::chrono::ceil<std::chrono::milliseconds>(*wake_up - Clock::now());
+            data = io_port_.wait_for((std::max)(left, std::chrono::milliseconds(0)), wait_ec);
+        }
+        else
+        {
+            data = io_port_.get(wait_ec);
+        }
+        const bool has_work = data
+            && (data->overlapped
+                || ((data->completion_key != kStopKey) && (data->completion_key != kWakeKey)));
+        release_timer_duty(timer_duty, has_work);
+        if (!data)
+        {
+            if (wait_ec == wi::detail::make_timeout_error_code())
+            {
+                // Time to expire timers.
+                continue;
+            }
+            // Port is unusable: same as IoContext, the scheduler is stopped.
+            // Same as stop(), but posting kStopKey may fail as well.
+            ec = wait_ec;
+            if (!stopped_.exchange(true, std::memory_order_acq_rel))
+            {
+                std::error_code post_ec;
+                io_port_.post(PortEntry(0, kStopKey, nullptr), post_ec);
+            }
+            return 0;
+        }
+        if (handle(*data, wait_ec) == 1)
+        {
+            return 1;
+        }
+    }
     return 0;
 }
+
+SleepTask IoScheduler::sleep_until(Clock::time_point when)
+{
+    return SleepTask(*this, when);
+}
+
+void IoScheduler::post(IoOperationTask& operation)
+{
+    std::error_code ec;
+    io_port_.post(PortEntry(0, 0, operation.overlapped()), ec);
+    assert(!ec && "Failed to post operation");
+}
+
+void IoScheduler::schedule_timer(WheelTimer& timer, Clock::time_point when)
+{
+    bool wake_up = false;
+    {
+        std::lock_guard<std::mutex> lock(timers_lock_);
+        timers_.schedule(timer, when);
+        if ((timer_duty_ != 0) && (when < planned_wake_up_))
+        {
+            // Waiting thread will sleep for too long; whoever
+            // takes kWakeKey takes the duty.
+            timer_duty_ = 0;
+            wake_posted_ = true;
+            wake_up = true;
+        }
+        else
+        {
+            // Nobody may wait for timers while resuming coroutines.
+            wake_up = hand_off_timer_duty();
+        }
+    }
+    if (wake_up)
+    {
+        post_wake_up();
+    }
+}
+
+bool IoScheduler::hand_off_timer_duty()
+{
+    if ((timer_duty_ != 0) || (waiting_ == 0) || wake_posted_
+        || !timers_.next_expiry())
+    {
+        return false;
+    }
+    wake_posted_ = true;
+    return true;
+}
+
+void IoScheduler::post_wake_up()
+{
+    std::error_code ec;
+    io_port_.post(PortEntry(0, kWakeKey, nullptr), ec);
+    assert(!ec && "Failed to post wake-up entry");
+}
+
+bool IoScheduler::cancel_timer(WheelTimer& timer)
+{
+    std::lock_guard<std::mutex> lock(timers_lock_);
+    const bool scheduled = timer.is_scheduled();
+    timers_.cancel(timer);
+    return scheduled;
+}
+
+std::optional<IoScheduler::Clock::time_point> IoScheduler::expire_timers(std::uint64_t* timer_duty)
+{
+    std::optional<Clock::time_point> wake_up;
+    std::vector<PortEntry> expired;
+    {
+        std::lock_guard<std::mutex> lock(timers_lock_);
+        timers_.advance(Clock::now(), [&](WheelTimer& timer)
+        {
+            expired.push_back(timer.entry);
+        });
+        if (timer_duty && expired.empty() && (timer_duty_ == 0))
+        {
+            // Nobody waits for timers; take it.
+            *timer_duty = timer_duty_ = ++timer_duty_id_;
+            wake_posted_ = false;
+            wake_up = timers_.next_expiry();
+            planned_wake_up_ = wake_up.value_or(Clock::time_point::max());
+        }
+        else if (timer_duty)
+        {
+            ++waiting_;
+        }
+    }
+    if (!expired.empty())
+    {
+        std::error_code ec;
+        const std::size_t posted = io_port_.post_many(expired, ec);
+        assert(!ec && (posted == expired.size()) && "Failed to post expired timers");
+        (void)posted;
+    }
+    return wake_up;
+}
+
+void IoScheduler::release_timer_duty(std::uint64_t timer_duty, bool has_work)
+{
+    bool wake_up = false;
+    {
+        std::lock_guard<std::mutex> lock(timers_lock_);
+        if (timer_duty == 0)
+        {
+            --waiting_;
+        }
+        else if (timer_duty_ == timer_duty)
+        {
+            timer_duty_ = 0;
+        }
+        // Resume may take long: let blocked thread wait for timers.
+        wake_up = has_work && hand_off_timer_duty();
+    }
+    if (wake_up)
+    {
+        post_wake_up();
+    }
+}
@@ -0,0 +1,64 @@
+#include <win_io_coro/io_operation_task.h>
+
+#include <cassert>
+
+using namespace wi;
+using namespace coro;
+
+IoOperationTask::IoOperationTask()
+    : operation_(&IoOperationTask::on_complete, this)
+    , state_(Pending)
+    , coro_()
+    , result_()
+{
+}
+
+WinOVERLAPPED* IoOperationTask::overlapped()
+{
+    return operation_.overlapped();
+}
+
+bool IoOperationTask::await_ready() const noexcept
+{
+    return (state_.load(std::memory_order_acquire) == Completed);
+}
+
+bool IoOperationTask::await_suspend(std::coroutine_handle<> awaiter) noexcept
+{
+    assert(!coro_);
+    coro_ = awaiter;
+    std::uint32_t expected = Pending;
+    // False if completed in the meantime: continue without suspension.
+    return state_.compare_exchange_strong(expected, Suspended
+        , std::memory_order_acq_rel, std::memory_order_acquire);
+}
+
+IoResult IoOperationTask::await_resume() noexcept
+{
+    assert((state_.load(std::memory_order_acquire) == Completed)
+        && "Resumed before the operation completed");
+    return result_;
+}
+
+void IoOperationTask::reset()
+{
+    assert((state_.load(std::memory_order_acquire) != Suspended)
+        && "Reset while coroutine is waiting");
+    operation_ = IoOperation(&IoOperationTask::on_complete, this);
+    state_.store(Pending, std::memory_order_release);
+    coro_ = nullptr;
+    result_ = IoResult();
+}
+
+/*static*/ void IoOperationTask::on_complete(void* user_data, const PortEntry& entry, std::error_code ec)
+{
+    IoOperationTask& self = *static_cast<IoOperationTask*>(user_data);
+    self.result_.entry = entry;
+    self.result_.error = ec;
+    const std::uint32_t prev = self.state_.exchange(Completed, std::memory_order_acq_rel);
+    assert((prev != Completed) && "Operation completed twice");
+    if (prev == Suspended)
+    {
+        self.coro_.resume();
+    }
+}
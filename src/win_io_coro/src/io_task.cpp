@@ -10,6 +10,7 @@ IoTask::IoTask(IoScheduler& scheduler)
     : scheduler_(&scheduler)
     , coro_()
     , data_()
+    , state_(State::kNew)
 {
 }
 
@@ -32,12 +33,20 @@ IoTask::IoTask(IoTask&& rhs) noexcept
     : scheduler_(rhs.scheduler_)
     , coro_(std::move(rhs.coro_))
     , data_(std::move(rhs.data_))
+    , state_(State::kNew)
 {
+    assert((rhs.state_.load(std::memory_order_relaxed) == State::kNew)
+        && "Moving IoTask that is co_await-ed");
     rhs.scheduler_ = nullptr;
     rhs.coro_ = nullptr;
     rhs.data_ = PortEntry();
 }
 
+bool IoTask::is_canceled() const
+{
+    return (state_.load(std::memory_order_acquire) == State::kCanceled);
+}
+
 void IoTask::set(PortEntry data)
 {
     assert(coro_);
@@ -57,10 +66,72 @@ PortEntry IoTask::await_resume() noexcept
     return std::move(data_);
 }
 
-void IoTask::await_suspend(std::coroutine_handle<> awaiter) noexcept
+bool IoTask::await_suspend(std::coroutine_handle<> awaiter) noexcept
 {
     assert(scheduler_);
     assert(!coro_);
     coro_ = awaiter;
-    scheduler_->add(*this);
+    // Not suspended if data is already there.
+    if (!scheduler_->add(*this))
+    {
+        coro_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+StoppableIoTask::StoppableIoTask(IoScheduler& scheduler, std::stop_token stop_token)
+    : IoTask(scheduler)
+    , stop_token_(std::move(stop_token))
+    , on_stop_()
+{
+}
+
+StoppableIoTask::StoppableIoTask(StoppableIoTask&& rhs) noexcept
+    : IoTask(std::move(rhs))
+    , stop_token_(std::move(rhs.stop_token_))
+    , on_stop_()
+{
+    assert(!rhs.on_stop_ && "Moving StoppableIoTask that is co_await-ed");
+}
+
+bool StoppableIoTask::await_suspend(std::coroutine_handle<> awaiter) noexcept
+{
+    assert(scheduler_);
+    if (stop_token_.stop_requested())
+    {
+        state_.store(State::kCanceled, std::memory_order_relaxed);
+        return false;
+    }
+    // Registered before the task is queued, so stop can't be missed.
+    // If invoked right away, the task is marked as canceled and
+    // won't be queued (not suspended).
+    on_stop_.emplace(stop_token_, OnStop{this});
+    return IoTask::await_suspend(awaiter);
+}
+
+IoResult StoppableIoTask::await_resume() noexcept
+{
+    IoResult result;
+    if (is_canceled())
+    {
+        result.error = std::make_error_code(std::errc::operation_canceled);
+        return result;
+    }
+    result.entry = IoTask::await_resume();
+    return result;
+}
+
+void StoppableIoTask::cancel()
+{
+    // Only if still waiting; otherwise data is (being) delivered.
+    if (scheduler_->cancel(*this))
+    {
+        coro_.resume();
+    }
+}
+
+void StoppableIoTask::OnStop::operator()() const noexcept
+{
+    task->cancel();
 }
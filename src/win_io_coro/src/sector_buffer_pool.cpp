@@ -0,0 +1,143 @@
+#include <win_io_coro/sector_buffer_pool.h>
+
+#include <bit>
+#include <new>
+#include <utility>
+
+#include <cassert>
+
+using namespace wi;
+using namespace coro;
+
+static_assert((SectorBufferPool::kMinBlockSize << (SectorBufferPool::kClassesCount - 1)) == SectorBufferPool::kMaxBlockSize
+    , "Size classes should cover [kMinBlockSize, kMaxBlockSize]");
+
+namespace
+{
+    // Index of the smallest class that fits `size`.
+    std::size_t SizeClass(std::size_t size)
+    {
+        if (size <= SectorBufferPool::kMinBlockSize)
+        {
+            return 0;
+        }
+        return std::size_t(std::bit_width((size - 1) / SectorBufferPool::kMinBlockSize));
+    }
+} // namespace
+
+/*explicit*/ SectorBuffer::SectorBuffer(SectorBufferPool& pool, std::uint8_t* data, std::size_t size) noexcept
+    : pool_(&pool)
+    , data_(data)
+    , size_(size)
+{
+}
+
+SectorBuffer::SectorBuffer(SectorBuffer&& rhs) noexcept
+    : pool_(std::exchange(rhs.pool_, nullptr))
+    , data_(std::exchange(rhs.data_, nullptr))
+    , size_(std::exchange(rhs.size_, 0))
+{
+}
+
+SectorBuffer& SectorBuffer::operator=(SectorBuffer&& rhs) noexcept
+{
+    if (this != &rhs)
+    {
+        release();
+        pool_ = std::exchange(rhs.pool_, nullptr);
+        data_ = std::exchange(rhs.data_, nullptr);
+        size_ = std::exchange(rhs.size_, 0);
+    }
+    return *this;
+}
+
+SectorBuffer::~SectorBuffer()
+{
+    release();
+}
+
+void SectorBuffer::release() noexcept
+{
+    if (data_)
+    {
+        pool_->deallocate(data_, size_);
+        pool_ = nullptr;
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+std::uint8_t* SectorBuffer::data() const noexcept
+{
+    return data_;
+}
+
+std::size_t SectorBuffer::size() const noexcept
+{
+    return size_;
+}
+
+/*explicit*/ SectorBuffer::operator bool() const noexcept
+{
+    return (data_ != nullptr);
+}
+
+/*explicit*/ SectorBufferPool::SectorBufferPool(std::size_t sector_size /*= kDefaultSectorSize*/)
+    : sector_size_(sector_size)
+    , classes_()
+{
+    assert(std::has_single_bit(sector_size_));
+    assert(sector_size_ <= kMinBlockSize);
+    for (std::size_t i = 0; i < kClassesCount; ++i)
+    {
+        const std::size_t block_size = (kMinBlockSize << i);
+        classes_[i].emplace(block_size, sector_size_, kSlabSize / block_size);
+    }
+}
+
+SectorBufferPool::~SectorBufferPool() = default;
+
+SectorBuffer SectorBufferPool::allocate(std::size_t size)
+{
+    assert(size > 0);
+    if (size > kMaxBlockSize)
+    {
+        const std::size_t rounded = ((size + sector_size_ - 1) / sector_size_) * sector_size_;
+        void* data = ::operator new(rounded, std::align_val_t(sector_size_));
+        return SectorBuffer(*this, static_cast<std::uint8_t*>(data), rounded);
+    }
+    detail::SlabFreeList& blocks = *classes_[SizeClass(size)];
+    return SectorBuffer(*this, static_cast<std::uint8_t*>(blocks.allocate()), blocks.block_size());
+}
+
+void SectorBufferPool::deallocate(std::uint8_t* data, std::size_t size) noexcept
+{
+    if (size > kMaxBlockSize)
+    {
+        ::operator delete(data, std::align_val_t(sector_size_));
+        return;
+    }
+    assert(std::has_single_bit(size));
+    classes_[SizeClass(size)]->deallocate(data);
+}
+
+std::size_t SectorBufferPool::sector_size() const noexcept
+{
+    return sector_size_;
+}
+
+std::size_t SectorBufferPool::slabs_count()
+{
+    std::size_t count = 0;
+    for (auto& blocks : classes_)
+    {
+        count += blocks->slabs_count();
+    }
+    return count;
+}
+
+/*static*/ SectorBufferPool& SectorBufferPool::shared()
+{
+    static SectorBufferPool* const pool = new SectorBufferPool();
+    return *pool;
+}
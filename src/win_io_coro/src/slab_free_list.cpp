@@ -0,0 +1,74 @@
+#include <win_io_coro/detail/slab_free_list.h>
+
+#include <bit>
+#include <new>
+
+#include <cassert>
+#include <cstdint>
+
+using namespace wi;
+using namespace coro;
+using coro::detail::SlabFreeList;
+
+/*explicit*/ SlabFreeList::SlabFreeList(std::size_t block_size
+    , std::size_t alignment
+    , std::size_t blocks_per_slab)
+        : lock_()
+        , free_(nullptr)
+        , slabs_()
+        , block_size_(block_size)
+        , alignment_((alignment < alignof(FreeBlock)) ? alignof(FreeBlock) : alignment)
+        , blocks_per_slab_(blocks_per_slab)
+{
+    assert(std::has_single_bit(alignment_));
+    assert(block_size_ >= sizeof(FreeBlock));
+    assert((block_size_ % alignment_) == 0);
+    assert(blocks_per_slab_ > 0);
+}
+
+SlabFreeList::~SlabFreeList()
+{
+    for (void* slab : slabs_)
+    {
+        ::operator delete(slab, std::align_val_t(alignment_));
+    }
+}
+
+void* SlabFreeList::allocate()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!free_)
+    {
+        slabs_.reserve(slabs_.size() + 1);
+        auto* slab = static_cast<std::uint8_t*>(::operator new(
+            block_size_ * blocks_per_slab_, std::align_val_t(alignment_)));
+        slabs_.push_back(slab);
+        // Blocks are given away in address order.
+        for (std::size_t i = blocks_per_slab_; i > 0; --i)
+        {
+            auto* block = ::new(static_cast<void*>(slab + (i - 1) * block_size_)) FreeBlock{free_};
+            free_ = block;
+        }
+    }
+    FreeBlock* block = free_;
+    free_ = block->next;
+    return block;
+}
+
+void SlabFreeList::deallocate(void* block) noexcept
+{
+    assert(block);
+    std::lock_guard<std::mutex> lock(lock_);
+    free_ = ::new(block) FreeBlock{free_};
+}
+
+std::size_t SlabFreeList::block_size() const noexcept
+{
+    return block_size_;
+}
+
+std::size_t SlabFreeList::slabs_count()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return slabs_.size();
+}
@@ -0,0 +1,54 @@
+#include <win_io_coro/sleep_task.h>
+#include <win_io_coro/io_coro_scheduler.h>
+
+#include <cassert>
+
+using namespace wi;
+using namespace coro;
+
+SleepTask::SleepTask(IoScheduler& scheduler, Clock::time_point when)
+    : scheduler_(&scheduler)
+    , when_(when)
+    , timer_()
+    , operation_()
+{
+}
+
+SleepTask::SleepTask(SleepTask&& rhs) noexcept
+    : scheduler_(rhs.scheduler_)
+    , when_(rhs.when_)
+    , timer_()
+    , operation_()
+{
+    assert(!rhs.timer_.is_scheduled() && "Moving SleepTask that is co_await-ed");
+    rhs.scheduler_ = nullptr;
+}
+
+bool SleepTask::await_ready() const noexcept
+{
+    return (when_ <= Clock::now());
+}
+
+bool SleepTask::await_suspend(std::coroutine_handle<> awaiter) noexcept
+{
+    assert(scheduler_);
+    timer_.entry = PortEntry(0, 0, operation_.overlapped());
+    scheduler_->schedule_timer(timer_, when_);
+    // Timer may expire (and be handled) right away; then
+    // the coroutine is not suspended.
+    return operation_.await_suspend(awaiter);
+}
+
+void SleepTask::await_resume() noexcept
+{
+}
+
+void SleepTask::cancel()
+{
+    assert(scheduler_);
+    if (scheduler_->cancel_timer(timer_))
+    {
+        // Was not expired yet: complete it now.
+        scheduler_->post(operation_);
+    }
+}
@@ -0,0 +1,180 @@
+#include <win_io_coro/work_stealing_scheduler.h>
+
+#include <algorithm>
+
+#include <cassert>
+
+using namespace wi;
+using namespace coro;
+
+namespace
+{
+    // Which worker the thread is, if any.
+    struct ThisThreadWorker
+    {
+        const WorkStealingScheduler* scheduler = nullptr;
+        std::uint32_t index = 0;
+    };
+
+    thread_local ThisThreadWorker tls_this_thread_worker;
+} // namespace
+
+WorkStealingScheduler::ScheduleOperation::ScheduleOperation(WorkStealingScheduler& scheduler)
+    : scheduler_(&scheduler)
+    , coro_()
+{
+}
+
+bool WorkStealingScheduler::ScheduleOperation::await_ready() const noexcept
+{
+    return false;
+}
+
+void WorkStealingScheduler::ScheduleOperation::await_suspend(std::coroutine_handle<> awaiter) noexcept
+{
+    assert(!coro_);
+    coro_ = awaiter;
+    scheduler_->post(*this);
+}
+
+void WorkStealingScheduler::ScheduleOperation::await_resume() const noexcept
+{
+}
+
+WorkStealingScheduler::WorkStealingScheduler(std::uint32_t threads_count /*= 0*/)
+    : workers_()
+    , shared_tasks_()
+    , shared_tasks_lock_()
+    , epoch_(0)
+    , sleeping_(0)
+    , stopped_(false)
+{
+    if (threads_count == 0)
+    {
+        threads_count = (std::max)(1u, std::thread::hardware_concurrency());
+    }
+    // All deques should exist before any worker starts stealing.
+    workers_.reserve(threads_count);
+    for (std::uint32_t i = 0; i < threads_count; ++i)
+    {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (std::uint32_t i = 0; i < threads_count; ++i)
+    {
+        workers_[i]->thread = std::thread([this, i]()
+        {
+            run_worker(i);
+        });
+    }
+}
+
+WorkStealingScheduler::~WorkStealingScheduler()
+{
+    stop();
+    for (auto& worker : workers_)
+    {
+        worker->thread.join();
+    }
+}
+
+WorkStealingScheduler::ScheduleOperation WorkStealingScheduler::schedule()
+{
+    return ScheduleOperation(*this);
+}
+
+std::uint32_t WorkStealingScheduler::threads_count() const
+{
+    return std::uint32_t(workers_.size());
+}
+
+bool WorkStealingScheduler::is_worker_thread() const
+{
+    return (tls_this_thread_worker.scheduler == this);
+}
+
+void WorkStealingScheduler::post(ScheduleOperation& operation)
+{
+    if (is_worker_thread())
+    {
+        workers_[tls_this_thread_worker.index]->tasks.push(&operation);
+    }
+    else
+    {
+        shared_tasks_.push(&operation);
+    }
+
+    // Pairs with sleeping_/epoch_ in run_worker(): either the worker
+    // sees new epoch (and re-checks the queues) or we see the sleeper.
+    epoch_.fetch_add(1, std::memory_order_seq_cst);
+    if (sleeping_.load(std::memory_order_seq_cst) > 0)
+    {
+        epoch_.notify_one();
+    }
+}
+
+void WorkStealingScheduler::stop()
+{
+    stopped_.store(true, std::memory_order_seq_cst);
+    epoch_.fetch_add(1, std::memory_order_seq_cst);
+    epoch_.notify_all();
+}
+
+WorkStealingScheduler::ScheduleOperation* WorkStealingScheduler::try_get_work(std::uint32_t index)
+{
+    ScheduleOperation* operation = nullptr;
+    if (workers_[index]->tasks.pop(operation))
+    {
+        return operation;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(shared_tasks_lock_);
+        if (shared_tasks_.pop(operation))
+        {
+            return operation;
+        }
+    }
+
+    const std::size_t count = workers_.size();
+    for (std::size_t i = 1; i < count; ++i)
+    {
+        Worker& victim = *workers_[(index + i) % count];
+        if (victim.tasks.steal(operation))
+        {
+            return operation;
+        }
+    }
+    return nullptr;
+}
+
+void WorkStealingScheduler::run_worker(std::uint32_t index)
+{
+    tls_this_thread_worker = {this, index};
+
+    while (!stopped_.load(std::memory_order_relaxed))
+    {
+        ScheduleOperation* operation = try_get_work(index);
+        if (!operation)
+        {
+            sleeping_.fetch_add(1, std::memory_order_seq_cst);
+            const std::uint32_t epoch = epoch_.load(std::memory_order_seq_cst);
+            operation = try_get_work(index);
+            if (!operation && !stopped_.load(std::memory_order_seq_cst))
+            {
+                epoch_.wait(epoch, std::memory_order_seq_cst);
+            }
+            sleeping_.fetch_sub(1, std::memory_order_relaxed);
+            if (!operation)
+            {
+                continue;
+            }
+        }
+
+        // Operation lives in the coroutine frame and
+        // may be destroyed once resumed.
+        std::coroutine_handle<> coro = operation->coro_;
+        coro.resume();
+    }
+
+    tls_this_thread_worker = {};
+}
@@ -11,6 +11,9 @@
 #include <MSWSock.h>
 
 #include <win_io/io_completion_port.h>
+#include <win_io/io_context.h>
+#include <win_io/io_operation.h>
+#include <win_io/sharded_io_context.h>
 
 #include <unifex/sender_concepts.hpp>
 #include <unifex/sync_wait.hpp>
@@ -145,15 +148,21 @@ struct Initialize_WSA
 
 static constexpr wi::WinULONG_PTR kClientKeyIOCP = 1;
 
-struct IOCP_Overlapped : OVERLAPPED
+struct IOCP_Overlapped : wi::IoOperation
 {
-    LPOVERLAPPED ptr() { return this; }
+    using Handle = wi::IoOperation::Callback;
+    using wi::IoOperation::IoOperation;
 
-    using Handle = void (*)(void* user_data, const wi::PortEntry& /*entry*/, std::error_code /*ec*/);
-    Handle _callback = nullptr;
-    void* _user_data = nullptr;
+    LPOVERLAPPED ptr() { return reinterpret_cast<LPOVERLAPPED>(overlapped()); }
 };
 
+// Invokes callback of IOCP_Overlapped that completed.
+// Can be used as wi::IoContext dispatch function to run on many threads.
+static void IOCP_Dispatch(void* user_data, const wi::PortEntry& entry, std::error_code ec)
+{
+    wi::dispatch_operation(user_data, entry, ec);
+}
+
 struct Endpoint_IPv4
 {
     std::uint16_t _port_network = 0;
@@ -245,7 +254,7 @@ struct Operation_Connect : Operation_Base
     Receiver _receiver;
     SOCKET _socket = INVALID_SOCKET;
     Endpoint_IPv4 _endpoint;
-    IOCP_Overlapped _ov{{}, &Operation_Connect::on_connected, this};
+    IOCP_Overlapped _ov{&Operation_Connect::on_connected, this};
     Helper_HandleStopToken<Receiver, Operation_Connect> _cancel_impl{};
 
     void try_stop() noexcept { Helper_CancelIoEx(_socket, _ov.ptr()); }
@@ -440,7 +449,7 @@ struct Operation_WriteSome : Operation_Base
     Receiver _receiver;
     SOCKET _socket = INVALID_SOCKET;
     OneBufferOwnerOrManyRef _buffers;
-    IOCP_Overlapped _ov{{}, &Operation_WriteSome::on_sent, this};
+    IOCP_Overlapped _ov{&Operation_WriteSome::on_sent, this};
     Helper_HandleStopToken<Receiver, Operation_WriteSome> _cancel_impl{};
 
     void try_stop() noexcept { Helper_CancelIoEx(_socket, _ov.ptr()); }
@@ -523,7 +532,7 @@ struct Operation_SendTo : Operation_Base
     SOCKET _socket = INVALID_SOCKET;
     OneBufferOwnerOrManyRef _buffers;
     Endpoint_IPv4 _destination;
-    IOCP_Overlapped _ov{{}, &Operation_SendTo::on_sent_to, this};
+    IOCP_Overlapped _ov{&Operation_SendTo::on_sent_to, this};
     Helper_HandleStopToken<Receiver, Operation_SendTo> _cancel_impl{};
 
     void try_stop() noexcept { Helper_CancelIoEx(_socket, _ov.ptr()); }
@@ -611,7 +620,7 @@ struct Operation_ReadSome : Operation_Base
     Receiver _receiver;
     SOCKET _socket = INVALID_SOCKET;
     OneBufferOwnerOrManyRef _buffers;
-    IOCP_Overlapped _ov{{}, &Operation_ReadSome::on_received, this};
+    IOCP_Overlapped _ov{&Operation_ReadSome::on_received, this};
     DWORD _flags = 0;
     WSABUF _wsa_buf{};
     Helper_HandleStopToken<Receiver, Operation_ReadSome> _cancel_impl{};
@@ -706,7 +715,7 @@ struct Operation_ReceiveFrom : Operation_Base
     SOCKET _socket = INVALID_SOCKET;
     OneBufferOwnerOrManyRef _buffers;
     Endpoint_IPv4* _sender = nullptr;
-    IOCP_Overlapped _ov{{}, &Operation_ReceiveFrom::on_received_from, this};
+    IOCP_Overlapped _ov{&Operation_ReceiveFrom::on_received_from, this};
     DWORD _flags = 0;
     struct sockaddr_in _received_from{};
     INT _endpoint_length = 0;
@@ -806,7 +815,7 @@ struct Operation_Accept : Operation_Base
     Receiver _receiver;
     SOCKET _listen_socket = INVALID_SOCKET;
     wi::IoCompletionPort* _iocp = nullptr;
-    IOCP_Overlapped _ov{{}, &Operation_Accept::on_accepted, this};
+    IOCP_Overlapped _ov{&Operation_Accept::on_accepted, this};
     char _buffer[2 * kAddressLength]{};
     _Async_TCPSocket _client{};
 
@@ -1227,7 +1236,7 @@ struct Operation_IOCP_Schedule : Operation_Base
 
     Receiver _receiver;
     wi::IoCompletionPort* _iocp = nullptr;
-    IOCP_Overlapped _ov{{}, &Operation_IOCP_Schedule::on_scheduled, this};
+    IOCP_Overlapped _ov{&Operation_IOCP_Schedule::on_scheduled, this};
 
     static void on_scheduled(void* user_data, const wi::PortEntry& entry, std::error_code ec) noexcept
     {
@@ -1289,6 +1298,13 @@ struct IOCP_Scheduler
 
 static_assert(unifex::scheduler<IOCP_Scheduler>);
 
+// Scheduler of the shard that calling thread runs on (or is assigned to).
+// Create sockets with the same port, so their completions stay on this shard.
+static IOCP_Scheduler IOCP_current_shard_scheduler(wi::ShardedIoContext& context)
+{
+    return IOCP_Scheduler{&context.current_port()};
+}
+
 template<typename Receiver, typename Scheduler, typename Fallback>
 struct Operation_SelectOnceInN : Operation_Base
 {
@@ -1718,7 +1734,7 @@ struct Operation_Resolve : Operation_Base
     wchar_t _wservice_name[256]{};
     PADDRINFOEXW _results = nullptr;
     AddrInfo_Overlapped _ov{{}, &Operation_Resolve::on_complete_WindowsThread, this};
-    IOCP_Overlapped _iocp_ov{{}, &Operation_Resolve::on_addrinfo_finish, this};
+    IOCP_Overlapped _iocp_ov{&Operation_Resolve::on_addrinfo_finish, this};
     Helper_HandleStopToken<Receiver, Operation_Resolve> _cancel_impl{};
     HANDLE _cancel_handle = INVALID_HANDLE_VALUE;
     // Points to `_cancel_handle` when cancel is available.
@@ -2013,13 +2029,7 @@ static void IOCP_sync_wait(wi::IoCompletionPort& iocp, Sender&& sender)
     while (!finish)
     {
         wi::PortEntry entries[4];
-        for (const wi::PortEntry& entry : iocp.get_many(entries, ec))
-        {
-            IOCP_Overlapped* ov = static_cast<IOCP_Overlapped*>(entry.overlapped);
-            assert(ov);
-            assert(ov->_callback);
-            ov->_callback(ov->_user_data, entry, ec);
-        }
+        (void)wi::dispatch(iocp.get_many(entries, ec), ec);
     }
 }
 